@@ -0,0 +1,159 @@
+// Standalone ray tracer for the baseline design.
+//
+// Reads the same macros as ReadoutSim (/RS/guide/*, /RS/gun/photonsPerEvent,
+// /random/setSeeds, /run/beamOn) and prints the fate summary of Run::EndOfRun
+// for every /run/beamOn, without Geant4 stepping.
+
+#include "RayTraceScene.hh"
+#include "RayTraceEngine.hh"
+#include "RayTraceTally.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // primaries per batch handed to a thread
+    const G4int kBatchSize = 4096;
+
+    struct Settings
+    {
+        G4int spaceGuide = 0;
+        G4int WLSBack = 0;
+        G4int WLSWrap = 1;
+        G4int photonsPerEvent = 1;
+        std::uint64_t seed = 12345;
+        G4int nThreads = 0;
+    };
+
+    void PrintUsage()
+    {
+        std::cerr << " Usage: " << std::endl;
+        std::cerr << " ReadoutRayTrace [macro] [-n nPhotons] [-s seed] [-t nThreads]" << std::endl;
+        std::cerr << "   -n, --photons  photons to trace without a macro (default 1000000)" << std::endl;
+        std::cerr << "   -s, --seed     random seed, /random/setSeeds in the macro overrides it" << std::endl;
+        std::cerr << "   -t, --threads  number of threads (default: READOUTSIM_NTHREADS or all cores)" << std::endl;
+    }
+
+    void RunPhotons(const Settings& settings, std::uint64_t first, std::uint64_t nPhotons)
+    {
+        RayTraceScene scene(settings.spaceGuide, settings.WLSBack, settings.WLSWrap);
+
+        std::atomic<std::uint64_t> next(0);
+        std::vector<RayTraceTally> tallies(settings.nThreads);
+        std::vector<std::thread> threads;
+
+        auto start = std::chrono::steady_clock::now();
+        for (G4int t = 0; t < settings.nThreads; t++)
+        {
+            threads.emplace_back([&, t]()
+            {
+                RayTraceEngine engine(scene, settings.seed);
+                for (;;)
+                {
+                    std::uint64_t offset = next.fetch_add(kBatchSize);
+                    if (offset >= nPhotons) break;
+                    G4int n = G4int(std::min<std::uint64_t>(kBatchSize, nPhotons - offset));
+                    engine.Trace(first + offset, n, tallies[t]);
+                }
+            });
+        }
+        for (auto& thread : threads) thread.join();
+        std::chrono::duration<G4double> wallTime = std::chrono::steady_clock::now() - start;
+
+        RayTraceTally total;
+        for (const auto& tally : tallies) total.Add(tally);
+        total.Print(std::cout);
+
+        std::cout << "\n   Throughput\n";
+        std::cout <<   "---------------------------------\n";
+        std::cout << "  Threads:                         " << settings.nThreads << "\n";
+        std::cout << "  Wall time:                       " << wallTime.count() << " s\n";
+        std::cout << "  Photons/s:                       " << nPhotons / wallTime.count() << "\n";
+        std::cout << "  Photons/s per thread:            " << nPhotons / wallTime.count() / settings.nThreads << "\n";
+        std::cout <<   "---------------------------------\n";
+    }
+
+    // the subset of ReadoutSim commands that matters here, others are skipped
+    G4bool ExecuteMacro(const std::string& fileName, Settings& settings)
+    {
+        std::ifstream macro(fileName);
+        if (!macro)
+        {
+            std::cerr << "Cannot open macro " << fileName << std::endl;
+            return false;
+        }
+
+        std::uint64_t first = 0;
+        std::string line;
+        while (std::getline(macro, line))
+        {
+            std::istringstream words(line);
+            std::string command;
+            if (!(words >> command) || command[0] == '#') continue;
+
+            if (command == "/RS/guide/setSpaceGuide") words >> settings.spaceGuide;
+            else if (command == "/RS/guide/setWLSBack") words >> settings.WLSBack;
+            else if (command == "/RS/guide/setWLSWrap") words >> settings.WLSWrap;
+            else if (command == "/RS/gun/photonsPerEvent") words >> settings.photonsPerEvent;
+            else if (command == "/random/setSeeds")
+            {
+                std::uint64_t seed1 = 0, seed2 = 0;
+                words >> seed1 >> seed2;
+                settings.seed = (seed1 << 32) ^ seed2;
+            }
+            else if (command == "/run/beamOn")
+            {
+                std::uint64_t nEvents = 0;
+                words >> nEvents;
+                std::uint64_t nPhotons = nEvents * settings.photonsPerEvent;
+                if (nPhotons == 0) continue;
+                // later runs continue the random streams of the earlier ones
+                RunPhotons(settings, first, nPhotons);
+                first += nPhotons;
+            }
+        }
+        return true;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Settings settings;
+    std::string macro;
+    std::uint64_t nPhotons = 1000000;
+    for (G4int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if ((arg == "-n" || arg == "--photons") && i + 1 < argc) nPhotons = std::strtoull(argv[++i], nullptr, 10);
+        else if ((arg == "-s" || arg == "--seed") && i + 1 < argc) settings.seed = std::strtoull(argv[++i], nullptr, 10);
+        else if ((arg == "-t" || arg == "--threads") && i + 1 < argc) settings.nThreads = std::atoi(argv[++i]);
+        else if (macro.empty() && arg[0] != '-') macro = arg;
+        else
+        {
+            PrintUsage();
+            return 1;
+        }
+    }
+
+    if (settings.nThreads <= 0)
+    {
+        const char* envThreads = std::getenv("READOUTSIM_NTHREADS");
+        if (envThreads) settings.nThreads = std::atoi(envThreads);
+    }
+    if (settings.nThreads <= 0) settings.nThreads = std::max(1u, std::thread::hardware_concurrency());
+
+    if (!macro.empty()) return ExecuteMacro(macro, settings) ? 0 : 1;
+
+    RunPhotons(settings, 0, nPhotons);
+    return 0;
+}
@@ -1,8 +1,7 @@
 #ifdef G4MULTITHREADED
 #include "G4MTRunManager.hh"
-#else
-#include "G4RunManager.hh"
 #endif
+#include "G4RunManager.hh"
 
 #include "G4UIExecutive.hh"
 #include "G4VisExecutive.hh"
@@ -12,47 +11,170 @@
 #include "FTFP_BERT.hh"
 #include "G4OpticalPhysics.hh"
 #include "G4EmStandardPhysics_option4.hh"
+#include "G4FastSimulationPhysics.hh"
 
 #include "ReadoutSimDetectorConstruction.hh"
 #include "ReadoutSimActionInitialization.hh"
+#include "ReadoutSimSweep.hh"
+#include "ReadoutSimCheckpoint.hh"
+#include "ReadoutSimAdaptiveRun.hh"
+#include "ReadoutSimProcessPool.hh"
+#include "ReadoutSimWLSPhysics.hh"
+#include "ReadoutSimOpticalPhysicsList.hh"
+#include "ReadoutSimStartup.hh"
+#include "ReadoutSimGuideTIRModel.hh"
+
+#include <cstdlib>
 
+namespace
+{
+    void PrintUsage()
+    {
+        G4cerr << " Usage: " << G4endl;
+        G4cerr << " ReadoutSim [macro] [-t nThreads] [-w alias|geant4] [-p full|optical] [-f nProcesses] [-g] [--resume]" << G4endl;
+        G4cerr << "   -t, --threads  number of worker threads (default: READOUTSIM_NTHREADS or all cores)" << G4endl;
+        G4cerr << "   -w, --wls      WLS process: alias tables (default) or G4OpWLS" << G4endl;
+        G4cerr << "   -p, --physics  FTFP_BERT with optical physics (default) or the optical processes only" << G4endl;
+        G4cerr << "   -f, --fork     sequential run manager, /RS/fork/run runs in this many forked processes" << G4endl;
+        G4cerr << "   -g, --guide    fast simulation of the photons trapped in the light guide (/RS/fastsim/guideTIR)" << G4endl;
+        G4cerr << "   --resume       continue /RS/checkpoint/run from its checkpoint file" << G4endl;
+    }
+}
 
 int main(int argc,char** argv)
 {
-    //detect interactive mode (if no arguments) and define UI session
+    // the startup time is printed at the first run
+    ReadoutSimStartup::Start();
+
+    // parse command line: an optional macro, thread count, WLS process, physics list,
+    // number of forked processes, guide fast simulation and resume flag
+    G4String macro;
+    G4int nThreads = 0;
+    G4String wlsProcess = "alias";
+    G4String physics = "full";
+    G4int nProcesses = 0;
+    G4bool guideTIR = false;
+    G4bool resume = false;
+    for (G4int i = 1; i < argc; i++)
+    {
+        G4String arg = argv[i];
+        if ((arg == "-t" || arg == "--threads") && i + 1 < argc) nThreads = std::atoi(argv[++i]);
+        else if ((arg == "-w" || arg == "--wls") && i + 1 < argc) wlsProcess = argv[++i];
+        else if ((arg == "-p" || arg == "--physics") && i + 1 < argc) physics = argv[++i];
+        else if ((arg == "-f" || arg == "--fork") && i + 1 < argc) nProcesses = std::atoi(argv[++i]);
+        else if (arg == "-g" || arg == "--guide") guideTIR = true;
+        else if (arg == "--resume") resume = true;
+        else if (macro.empty() && arg[0] != '-') macro = arg;
+        else
+        {
+            PrintUsage();
+            return 1;
+        }
+    }
+    if ((wlsProcess != "alias" && wlsProcess != "geant4") || (physics != "full" && physics != "optical") || nProcesses < 0)
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    // command line first, then environment, then all available cores.
+    // /run/numberOfThreads in the macro still overrides this value.
+    if (nThreads <= 0)
+    {
+        const char* envThreads = std::getenv("READOUTSIM_NTHREADS");
+        if (envThreads) nThreads = std::atoi(envThreads);
+    }
+    if (nThreads <= 0) nThreads = G4Threading::G4GetNumberOfCores();
+
+    //detect interactive mode (if no macro) and define UI session
     G4UIExecutive* ui = nullptr;
-    if (argc == 1) ui = new G4UIExecutive(argc,argv);
+    if (macro.empty()) ui = new G4UIExecutive(argc,argv);
 
-    G4MTRunManager * runManager = new G4MTRunManager;
-    G4int nThreads = std::min(G4Threading::G4GetNumberOfCores(), 1);
-    runManager->SetNumberOfThreads(nThreads);
-    G4cout << "===== ReadoutSim is started with "
-            <<  runManager->GetNumberOfThreads() << " threads =====" << G4endl;
+    // worker threads do not survive a fork: the process pool needs the sequential run manager
+    G4RunManager * runManager = nullptr;
+#ifdef G4MULTITHREADED
+    if (nProcesses == 0)
+    {
+        G4MTRunManager* mtRunManager = new G4MTRunManager;
+        mtRunManager->SetNumberOfThreads(nThreads);
+        // reseed every event from the master engine: results for a given
+        // /random/setSeeds do not depend on the number of threads
+        mtRunManager->SetSeedOncePerCommunication(0);
+        G4cout << "===== ReadoutSim is started with "
+                <<  mtRunManager->GetNumberOfThreads() << " threads =====" << G4endl;
+        runManager = mtRunManager;
+    }
+#endif
+    if (!runManager)
+    {
+        runManager = new G4RunManager;
+        if (nProcesses > 0)
+            G4cout << "===== ReadoutSim is started for " << nProcesses << " forked processes =====" << G4endl;
+    }
 
     // Set mandatory initialization classes
     //
     // Detector construction
     runManager-> SetUserInitialization(new ReadoutSimDetectorConstruction());
     //
-    // Physics list
-    G4VModularPhysicsList* physicsList = new FTFP_BERT;
-    physicsList->ReplacePhysics(new G4EmStandardPhysics_option4());
-    G4OpticalPhysics* opticalPhysics = new G4OpticalPhysics();
-    physicsList->RegisterPhysics(opticalPhysics);
+    // Physics list: the primaries are optical photons, on which only the
+    // optical processes act; the full list also builds EM and hadronic tables
+    G4VModularPhysicsList* physicsList = nullptr;
+    G4OpticalPhysics* opticalPhysics = nullptr;
+    if (physics == "optical")
+    {
+        ReadoutSimOpticalPhysicsList* opticalList = new ReadoutSimOpticalPhysicsList();
+        opticalPhysics = opticalList->GetOpticalPhysics();
+        physicsList = opticalList;
+    }
+    else
+    {
+        physicsList = new FTFP_BERT;
+        physicsList->ReplacePhysics(new G4EmStandardPhysics_option4());
+        opticalPhysics = new G4OpticalPhysics();
+        physicsList->RegisterPhysics(opticalPhysics);
+    }
+    G4cout << "===== Physics list: " << (physics == "optical" ? "optical processes only" : "FTFP_BERT + optical") << " =====" << G4endl;
+    // same WLS physics as G4OpWLS, with the tables sampled in constant time
+    if (wlsProcess == "alias")
+    {
+        opticalPhysics->Configure(kWLS, false);
+        physicsList->RegisterPhysics(new ReadoutSimWLSPhysics());
+    }
+    // fast simulation in the light guide, then switched by /RS/fastsim/guideTIR;
+    // without it no photon step goes through the fast-simulation process
+    if (guideTIR)
+    {
+        G4FastSimulationPhysics* fastSimulationPhysics = new G4FastSimulationPhysics();
+        fastSimulationPhysics->ActivateFastSimulation("opticalphoton");
+        physicsList->RegisterPhysics(fastSimulationPhysics);
+        ReadoutSimGuideTIRModel::SetPhysicsRegistered(true);
+        ReadoutSimGuideTIRModel::SetEnabled(true);
+    }
     runManager->SetUserInitialization(physicsList);
     //
     // User action initialization
     runManager->SetUserInitialization(new ReadoutSimActionInitialization());
-
-   //initialize visualization
-    G4VisManager* visManager = new G4VisExecutive;
-    visManager->Initialize();
+    //
+    // design-space scans in this process, /RS/sweep/
+    ReadoutSimSweep* sweep = new ReadoutSimSweep();
+    // long runs in segments with checkpoints, /RS/checkpoint/
+    ReadoutSimCheckpoint* checkpoint = new ReadoutSimCheckpoint();
+    checkpoint->SetResume(resume);
+    // one initialization, events in forked processes, /RS/fork/
+    ReadoutSimProcessPool* processPool = nProcesses > 0 ? new ReadoutSimProcessPool(nProcesses) : nullptr;
+    // runs that stop at a target precision, /RS/adaptive/
+    ReadoutSimAdaptiveRun* adaptiveRun = new ReadoutSimAdaptiveRun();
 
     //get the pointer to the User Interface manager 
     G4UImanager* UImanager = G4UImanager::GetUIpointer();
 
+    // visualization only for the interactive session, batch jobs start without it
+    G4VisManager* visManager = nullptr;
     if (ui)  {
         //interactive mode
+        visManager = new G4VisExecutive;
+        visManager->Initialize();
         UImanager->ApplyCommand("/control/execute init_vis.mac");
         ui->SessionStart();
         delete ui;
@@ -60,11 +182,14 @@ int main(int argc,char** argv)
     else  {
         //batch mode  
         G4String command = "/control/execute ";
-        G4String fileName = argv[1];
-        UImanager->ApplyCommand(command+fileName);
+        UImanager->ApplyCommand(command+macro);
     }
 
     // job termination
+    delete adaptiveRun;
+    delete processPool;
+    delete checkpoint;
+    delete sweep;
     delete visManager;
     delete runManager;
     return 0;
@@ -0,0 +1,199 @@
+#!/usr/bin/env python3
+"""Throughput benchmark of ReadoutSim.
+
+Runs a fixed set of fixed-seed workloads, reads the summary that ReadoutSim
+prints at the end of every run and writes the results as JSON. With a
+stored baseline, fails (exit code 1) when the photons/s of a workload fall
+more than the threshold below the baseline.
+
+    readoutsim_bench.py --executable ./ReadoutSim --output bench.json
+    readoutsim_bench.py ... --baseline readoutsim_bench_baseline.json --threshold 0.1
+    readoutsim_bench.py ... --baseline readoutsim_bench_baseline.json --update-baseline
+
+Used by the readoutsim_bench and readoutsim_bench_baseline CMake targets.
+"""
+
+import argparse
+import json
+import os
+import platform
+import re
+import resource
+import subprocess
+import sys
+import tempfile
+import time
+
+# name: (design commands before /run/initialize, commands before /run/beamOn)
+DESIGNS = {
+    "baseline": ([], []),
+    "wlsBack": (["/RS/guide/setWLSBack 1"], []),
+    "noWrap": (["/RS/guide/setWLSWrap 0"], []),
+    "fullPanel": ([], ["/RS/source/area panel"]),
+}
+
+# lines of Run::PrintThroughput, Run::EndOfRun and the startup report
+PATTERNS = {
+    "startup_s": re.compile(r"^\s*Job start to the first run:\s+([0-9.eE+-]+) s"),
+    "startup_rss_mb": re.compile(r"^\s*Resident memory:\s+([0-9.eE+-]+) MB"),
+    "wall_time_s": re.compile(r"^\s*Wall time:\s+([0-9.eE+-]+) s"),
+    "photons_per_s": re.compile(r"^\s*Photons/s:\s+([0-9.eE+-]+)"),
+    "steps_per_photon": re.compile(r"^\s*Steps per tracked photon:\s+([0-9.eE+-]+)"),
+    "time_per_step_ns": re.compile(r"^\s*Time per step:\s+([0-9.eE+-]+) ns"),
+    "peak_rss_mb": re.compile(r"^\s*Peak memory:\s+([0-9.eE+-]+) MB"),
+    "detected_percent": re.compile(r"^\s*Photons Detected:\s+([0-9.eE+-]+) %"),
+}
+RUN_START = re.compile(r"^### Run \d+ start")
+
+
+def write_macro(directory, name, design, photons, photons_per_event):
+    before_init, before_run = DESIGNS[design]
+    lines = ["/control/verbose 0", "/run/verbose 1", "/tracking/verbose 0"]
+    lines += before_init
+    lines += ["/run/initialize",
+              "/random/setSeeds 12345 67890",
+              "/RS/output/records 0",
+              "/RS/output/histograms 0",
+              "/RS/gun/photonsPerEvent %d" % photons_per_event]
+    lines += before_run
+    lines.append("/run/beamOn %d" % max(1, photons // photons_per_event))
+    path = os.path.join(directory, name + ".mac")
+    with open(path, "w") as f:
+        f.write("\n".join(lines) + "\n")
+    return path
+
+
+def run_workload(executable, macro, threads, physics):
+    """Runs one job, returns the parsed summary and the phase times."""
+    command = [executable, macro, "-t", str(threads), "-p", physics]
+    start = time.monotonic()
+    first_run = None
+    values = {}
+    log = []
+    process = subprocess.Popen(command, stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+                               universal_newlines=True, bufsize=1)
+    for line in process.stdout:
+        log.append(line)
+        if first_run is None and RUN_START.match(line):
+            first_run = time.monotonic()
+        for key, pattern in PATTERNS.items():
+            match = pattern.match(line)
+            if match:
+                values[key] = float(match.group(1))
+    process.wait()
+    total = time.monotonic() - start
+
+    if process.returncode != 0 or "photons_per_s" not in values:
+        sys.stderr.write("".join(log[-40:]))
+        raise RuntimeError("%s failed (exit code %d)" % (" ".join(command), process.returncode))
+
+    # startup: process start to the first run (geometry, physics tables);
+    # event loop: as measured by the master; the rest is teardown
+    loop = values.get("wall_time_s", 0.)
+    if first_run is not None:
+        startup = first_run - start
+    else:
+        startup = values.get("startup_s", total - loop)
+    values["phases_s"] = {
+        "startup": startup,
+        "event_loop": loop,
+        "teardown": max(0., total - startup - loop),
+        "total": total,
+    }
+    if "peak_rss_mb" not in values:
+        # largest child so far, in kB on Linux and bytes on macOS
+        rss = resource.getrusage(resource.RUSAGE_CHILDREN).ru_maxrss
+        values["peak_rss_mb"] = rss / (1024. * 1024.) if sys.platform == "darwin" else rss / 1024.
+    return values
+
+
+def compare(results, baseline, threshold):
+    """Workloads whose photons/s fell more than threshold below the baseline."""
+    failures = []
+    for name, result in results.items():
+        reference = baseline.get("workloads", {}).get(name)
+        if not reference:
+            continue
+        ratio = result["photons_per_s"] / reference["photons_per_s"]
+        status = "ok"
+        if ratio < 1. - threshold:
+            status = "SLOWER"
+            failures.append(name)
+        print("  %-24s %12.1f photons/s  %6.1f %% of baseline  %s"
+              % (name, result["photons_per_s"], 100. * ratio, status))
+    return failures
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--executable", required=True, help="ReadoutSim executable")
+    parser.add_argument("--output", default="readoutsim_bench.json", help="results, JSON")
+    parser.add_argument("--baseline", help="stored results to compare with, JSON")
+    parser.add_argument("--threshold", type=float, default=0.1,
+                        help="largest accepted loss of photons/s against the baseline (default 0.1)")
+    parser.add_argument("--update-baseline", action="store_true", help="write the results to --baseline")
+    parser.add_argument("--photons", type=int, default=200000, help="photons per workload (default 200000)")
+    parser.add_argument("--photons-per-event", type=int, default=100)
+    parser.add_argument("--physics", choices=["full", "optical"], default="full",
+                        help="physics list of ReadoutSim (-p), default full")
+    parser.add_argument("--threads", default="1,2,4,N",
+                        help="thread counts of the baseline design, N for all cores (default 1,2,4,N)")
+    args = parser.parse_args()
+
+    cores = os.cpu_count() or 1
+    thread_counts = []
+    for value in args.threads.split(","):
+        count = cores if value.strip() == "N" else int(value)
+        if count not in thread_counts:
+            thread_counts.append(count)
+
+    # the designs on one thread, the baseline design on every thread count
+    workloads = [(design, 1) for design in DESIGNS]
+    workloads += [("baseline", threads) for threads in thread_counts if threads != 1]
+
+    results = {}
+    with tempfile.TemporaryDirectory(prefix="readoutsim_bench_") as directory:
+        for design, threads in workloads:
+            name = "%s_t%d" % (design, threads)
+            macro = write_macro(directory, design, design, args.photons, args.photons_per_event)
+            print("running %s ..." % name, flush=True)
+            result = run_workload(os.path.abspath(args.executable), macro, threads, args.physics)
+            result.update({"design": design, "threads": threads, "photons": args.photons, "physics": args.physics})
+            results[name] = result
+            print("  %12.1f photons/s  %8.2f steps/photon  %8.1f MB peak"
+                  % (result["photons_per_s"], result.get("steps_per_photon", 0.), result["peak_rss_mb"]))
+
+    report = {
+        "host": platform.node(),
+        "platform": platform.platform(),
+        "cores": cores,
+        "date": time.strftime("%Y-%m-%dT%H:%M:%S"),
+        "workloads": results,
+    }
+    with open(args.output, "w") as f:
+        json.dump(report, f, indent=2, sort_keys=True)
+    print("results written to %s" % args.output)
+
+    if not args.baseline:
+        return 0
+    if args.update_baseline:
+        with open(args.baseline, "w") as f:
+            json.dump(report, f, indent=2, sort_keys=True)
+        print("baseline written to %s" % args.baseline)
+        return 0
+    if not os.path.exists(args.baseline):
+        print("no baseline %s yet, store one with --update-baseline" % args.baseline)
+        return 0
+
+    with open(args.baseline) as f:
+        baseline = json.load(f)
+    print("against %s (%s, %s):" % (args.baseline, baseline.get("host", "?"), baseline.get("date", "?")))
+    failures = compare(results, baseline, args.threshold)
+    if failures:
+        print("throughput dropped by more than %.0f %%: %s" % (100. * args.threshold, ", ".join(failures)))
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,41 @@
+#ifndef ReadoutSimAdaptiveRun_h
+#define ReadoutSimAdaptiveRun_h
+
+#include "G4GenericMessenger.hh"
+#include "globals.hh"
+
+#include <vector>
+
+// Runs until the detection efficiencies are known to a given precision.
+//
+// /RS/adaptive/run N runs chunks of /RS/adaptive/chunk events, each a run
+// tagged c0, c1, ... (after the current /RS/run/tag), and stops once the
+// relative uncertainty of both the right and the left efficiency is below
+// /RS/adaptive/precision, after N events, or before a chunk that would not
+// fit in /RS/adaptive/maxTime. The uncertainty comes from the batch means:
+// the spread of the chunk efficiencies over sqrt(number of chunks), which
+// also covers the correlated photons of an event (WLS, photonsPerEvent).
+// The chunks are summed as the checkpoint segments are; the summary of
+// all of them ends with the achieved precision and the reason to stop.
+class ReadoutSimAdaptiveRun
+{
+    public:
+        ReadoutSimAdaptiveRun();
+        ~ReadoutSimAdaptiveRun();
+
+    private:
+        void DefineCommands();
+        void RunChunks(G4int maxEvents);
+
+        // efficiency of all the chunks and its relative uncertainty from the batch means
+        static void Estimate(const std::vector<G4double>& efficiencies, G4double detected, G4long photons,
+                             G4double& efficiency, G4double& relativeError);
+
+        G4double fPrecision;
+        G4int fChunkEvents;
+        G4int fMinChunks;
+        G4double fMaxTime;
+        G4GenericMessenger* fMessenger;
+};
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef ReadoutSimAliasTable_h
+#define ReadoutSimAliasTable_h
+
+#include "G4Types.hh"
+
+#include <vector>
+
+// Walker alias table: picks bin i with probability weights[i] / sum(weights)
+// in constant time, with one random number, whatever the number of bins.
+class ReadoutSimAliasTable
+{
+    public:
+        // weights must not be negative; with no positive weight the table stays empty
+        void Build(const std::vector<G4double>& weights)
+        {
+            fProbability.clear();
+            fAlias.clear();
+
+            G4double sum = 0.;
+            for (G4double weight : weights) sum += weight;
+            if (!(sum > 0.)) return;
+
+            // Vose's construction: every column holds one bin up to its
+            // probability and one alias bin for the rest
+            std::size_t n = weights.size();
+            fProbability.resize(n);
+            fAlias.resize(n);
+            std::vector<G4double> scaled(n);
+            std::vector<std::size_t> small, large;
+            for (std::size_t i = 0; i < n; i++)
+            {
+                scaled[i] = weights[i] * n / sum;
+                fAlias[i] = G4int(i);
+                if (scaled[i] < 1.) small.push_back(i);
+                else large.push_back(i);
+            }
+            while (!small.empty() && !large.empty())
+            {
+                std::size_t s = small.back();
+                std::size_t l = large.back();
+                small.pop_back();
+                fProbability[s] = scaled[s];
+                fAlias[s] = G4int(l);
+                scaled[l] -= 1. - scaled[s];
+                if (scaled[l] < 1.)
+                {
+                    large.pop_back();
+                    small.push_back(l);
+                }
+            }
+            // what is left is 1 up to rounding
+            for (std::size_t i : large) fProbability[i] = 1.;
+            for (std::size_t i : small) fProbability[i] = 1.;
+        }
+
+        G4bool IsEmpty() const {return fProbability.empty();}
+        std::size_t GetSize() const {return fProbability.size();}
+
+        // bin for a uniform random number in [0, 1). The part of the number
+        // not used to pick the bin is returned in fraction: it is uniform in
+        // [0, 1) and independent of the bin.
+        G4int Sample(G4double rnd, G4double& fraction) const
+        {
+            G4int n = G4int(fProbability.size());
+            G4double x = rnd * n;
+            G4int column = G4int(x);
+            if (column >= n) column = n - 1;
+            G4double f = x - column;
+            G4double p = fProbability[column];
+            if (f < p)
+            {
+                fraction = f / p;
+                return column;
+            }
+            fraction = (f - p) / (1. - p);
+            return fAlias[column];
+        }
+
+    private:
+        std::vector<G4double> fProbability;
+        std::vector<G4int> fAlias;
+};
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef ReadoutSimBaselineLayout_h
+#define ReadoutSimBaselineLayout_h
+
+#include "G4Types.hh"
+#include "G4SystemOfUnits.hh"
+
+// Axis-aligned box, centre and half lengths in the world frame
+struct ReadoutSimBox
+{
+    G4double center[3];
+    G4double halfLength[3];
+};
+
+// Boxes of the baseline design (panel, PEN foil, light guide, end detectors).
+// Used by ReadoutSimDetectorConstruction::SetupBaselineDesign() and by the
+// standalone ray tracer, so that both see the same geometry.
+struct ReadoutSimBaselineLayout
+{
+    ReadoutSimBox world;
+    ReadoutSimBox panel;
+    ReadoutSimBox pen;
+    ReadoutSimBox guide;            // the guide is placed inside the PEN box
+    ReadoutSimBox rightDetector;
+    ReadoutSimBox leftDetector;
+    G4double guideOffset;           // guide centre relative to the PEN box centre, along y
+
+    // space:          gap between the panel and the PEN box (/RS/guide/setSpaceGuide)
+    // layerThickness: PEN foil thickness
+    // WLS_y:          1 for foil on the front of the guide only, 2 for front and back
+    // centerGuide:    1 to push the guide towards the panel when only the front is covered
+    static ReadoutSimBaselineLayout Compute(G4double space, G4double layerThickness, G4int WLS_y, G4int centerGuide)
+    {
+        ReadoutSimBaselineLayout layout;
+
+        layout.world = {{0., 0., 0.}, {2.5*m, 2.5*m, 2.5*m}};
+
+        G4double panel_x = 0.5*m;  // 1m
+        G4double panel_y = 0.05*m; // 10cm
+        G4double panel_z = 1.5*m;  // 3m
+        layout.panel = {{0., 0., 0.}, {panel_x, panel_y, panel_z}};
+
+        G4double pen_y = 0.005*m + layerThickness * WLS_y;  // 1cm (guide) + PEN foil thickness
+        G4double pen_z = 0.05*m + layerThickness * 2;       // 10cm (guide) + PEN foil thickness on top and bottom of the guide
+        G4double guide_y = panel_y + pen_y + space;
+        layout.pen = {{0., guide_y, 0.}, {panel_x, pen_y, pen_z}};
+
+        layout.guideOffset = -layerThickness * centerGuide;
+        layout.guide = {{0., guide_y + layout.guideOffset, 0.}, {panel_x, 0.005*m, 0.05*m}};
+
+        G4double detector_x = .5*cm;  // 1cm
+        layout.rightDetector = {{panel_x + detector_x, guide_y, 0.}, {detector_x, .5*cm, 0.05*m}};
+        layout.leftDetector  = {{- panel_x - detector_x, guide_y, 0.}, {detector_x, .5*cm, 0.05*m}};
+
+        return layout;
+    }
+};
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef ReadoutSimCheckpoint_h
+#define ReadoutSimCheckpoint_h
+
+#include "G4GenericMessenger.hh"
+#include "globals.hh"
+
+class Run;
+
+// Long production runs in segments, with a checkpoint after each one.
+//
+// /RS/checkpoint/run N runs N events as runs of /RS/checkpoint/segment
+// events, tagged s0, s1, ... (/RS/run/tag): the photon records of every
+// segment go to their own file, closed at the end of the segment. After
+// each segment the counters and histograms of all the segments so far and
+// the state of the master random engine are written to the checkpoint
+// file, which replaces the previous one only once complete, and the
+// summed histograms are written to the usual histogram file.
+//
+// The workers are reseeded from the master engine at every event, so the
+// master state is the random state of the whole job: started with
+// --resume, the same command reloads the checkpoint and runs the missing
+// segments with the random numbers they would have had without the stop.
+class ReadoutSimCheckpoint
+{
+    public:
+        ReadoutSimCheckpoint();
+        ~ReadoutSimCheckpoint();
+
+        // continue from the checkpoint file at the next /RS/checkpoint/run
+        void SetResume(G4bool val) {fResume = val;}
+
+    private:
+        void DefineCommands();
+        void RunSegments(G4int nEvents);
+
+        // total: the sum of the first nDone segments of a job of nEvents events
+        G4bool Save(const ::Run& total, G4int nEvents, G4int nDone) const;
+        // null if there is no checkpoint of a job of nEvents events with this segment size
+        ::Run* Load(G4int nEvents, G4int& nDone) const;
+
+        G4String fFileName;
+        G4int fSegmentEvents;
+        G4bool fResume;
+        G4GenericMessenger* fMessenger;
+};
+
+#endif
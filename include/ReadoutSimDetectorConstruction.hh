@@ -8,7 +8,13 @@
 #include "G4GenericMessenger.hh"
 #include "G4SystemOfUnits.hh"
 
+#include "ReadoutSimGuideTIRModel.hh"
+#include "ReadoutSimBaselineLayout.hh"
+#include "ReadoutSimModuleLayout.hh"
+
 class DetectorMessenger;
+class G4Region;
+class G4Box;
 
 class ReadoutSimDetectorConstruction : public G4VUserDetectorConstruction
 {
@@ -17,23 +23,49 @@ class ReadoutSimDetectorConstruction : public G4VUserDetectorConstruction
         ~ReadoutSimDetectorConstruction();
 
         virtual G4VPhysicalVolume *Construct(); 
+        virtual void ConstructSDandField();
 
-        // void SetGeometry(G4String name) {fGeometryName = name;};
+        // "baseline" is the only design built so far; a different design
+        // rebuilds the whole geometry before the next run
+        void SetGeometry(G4String name);
     
     private:
         void DefineMaterials();
         void DefineCommands();
         void SetOpticalProperties();
         void SetSpace(G4int);
+        void SetSpaceLength(G4double);
         void setWLSWrap(G4int);
         void SetWLSBack(G4int);
+        void SetFoilThickness(G4double);
+        void SetGuideTIR(G4bool);
+        void SetNumberOfBars(G4int);
+        void SetNumberOfPanels(G4int);
+        void SetPanelGap(G4double);
+        void SetPlacement(G4String);
+        void SetSmartless(G4double);
+
+        // boxes of the baseline design for the current settings
+        ReadoutSimBaselineLayout ComputeLayout();
+        void SetGuideSurroundings(const ReadoutSimBaselineLayout&);
+        // after a setting changed: resize and move the placed volumes,
+        // the materials, physics tables and the rest of the geometry are kept
+        void UpdateGeometry();
+        // drop all the volumes, Construct() runs again before the next run
+        void RebuildGeometry();
+        // bar and panel copies for the current settings
+        ReadoutSimModuleLayout ComputeModuleLayout(const ReadoutSimBaselineLayout&) const;
+        void PrintGeometrySummary(const G4VPhysicalVolume* world, G4double memoryBefore) const;
 
         G4VPhysicalVolume* SetupPanelOnly();
         G4VPhysicalVolume* SetupPanelWithCladding();
         G4VPhysicalVolume* SetupBaselineDesign();
+        G4VPhysicalVolume* SetupModuleDesign();
         G4VPhysicalVolume* SetupBaselineCladding();
 
-        // G4String fGeometryName;
+        G4String fGeometryName = "baseline";
+        DetectorMessenger* fDetectorMessenger;
+        G4bool fMaterialsBuilt = false;
 
         G4LogicalVolume *fRightPENLayerLogical, *fLeftPENLayerLogical;
         G4LogicalVolume *fTopPENLayerLogical, *fBotPENLayerLogical;
@@ -43,10 +75,33 @@ class ReadoutSimDetectorConstruction : public G4VUserDetectorConstruction
 
         G4double space;
         G4double layerThickness;
+        G4double fFoilThickness;   // PEN foil thickness when the guide is wrapped
+        G4bool fWLSWrap = true;
         G4int WLS_y = 1;
         G4int centerGuide = 1;
 
+        // module of bars along each panel and array of panels, /RS/module/
+        G4int fNumberOfBars = 1;
+        G4int fNumberOfPanels = 1;
+        G4double fPanelGap = 0.;
+        G4bool fReplicateSlots = true;    // G4PVReplica, otherwise one G4PVPlacement per copy
+        G4double fSmartless = 2.;         // G4 default
+
         G4MaterialPropertiesTable *pmmaMPT, *penMPT, *larMPT, *innerCladdingMPT, *outerCladdingMPT;
+
+        // light guide and its surroundings, for the fast TIR transport
+        G4Region *fGuideRegion = nullptr;
+        G4LogicalVolume *fGuideLogical = nullptr;
+        ReadoutSimGuideTIRModel::Surroundings fGuideSurroundings;
+
+        // baseline volumes that move or change with the settings, nullptr before Construct()
+        G4VPhysicalVolume *fWorldPhysical = nullptr;
+        G4Box *fPENSolid = nullptr;
+        G4LogicalVolume *fPENLogical = nullptr;
+        G4VPhysicalVolume *fPENPhysical = nullptr;
+        G4VPhysicalVolume *fGuidePhysical = nullptr;
+        G4VPhysicalVolume *fRightDetPhysical = nullptr;
+        G4VPhysicalVolume *fLeftDetPhysical = nullptr;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,38 @@
+#ifndef ReadoutSimEventAction_h
+#define ReadoutSimEventAction_h
+
+#include "G4UserEventAction.hh"
+
+#include <vector>
+
+class ReadoutSimLightMap;
+
+// Collects, for every primary photon of the event, whether one of its
+// descendants reached a detector, and fills the light map of the run
+class ReadoutSimEventAction : public G4UserEventAction
+{
+    public:
+        ReadoutSimEventAction();
+        virtual ~ReadoutSimEventAction();
+
+        virtual void BeginOfEventAction(const G4Event*);
+        virtual void EndOfEventAction(const G4Event*);
+
+        // a photon descending from the given primary reached a detector
+        void AddDetection(G4int primaryID, G4bool right);
+
+    private:
+        struct Primary
+        {
+            G4int bin;
+            G4double weight;
+            G4bool right;
+            G4bool left;
+        };
+
+        // indexed by primary track ID - 1
+        std::vector<Primary> fPrimaries;
+        ReadoutSimLightMap* fLightMap;  // nullptr unless the run fills a map
+};
+
+#endif
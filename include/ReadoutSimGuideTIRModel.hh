@@ -0,0 +1,80 @@
+#ifndef ReadoutSimGuideTIRModel_h
+#define ReadoutSimGuideTIRModel_h
+
+#include "G4VFastSimulationModel.hh"
+
+class G4Material;
+
+// Fast transport of optical photons trapped in the PMMA light guide.
+//
+// The guide is an axis-aligned polished box, so a photon keeps |u_x|, |u_y|
+// and |u_z| from one reflection to the next. When a side face reflects it by
+// total internal reflection, the path up to the guide end is known in closed
+// form. The model moves the photon in one step to the first point where full
+// tracking is needed again: just before a face where it can leave the guide,
+// or just before the end faces towards the detectors. Bulk absorption is
+// sampled from the guide ABSLENGTH along the way.
+//
+// Trapping is decided at the outer surface of the thin WLS foil around the
+// guide (n sin(theta) is conserved across parallel layers). The bounce where
+// a photon is likely absorbed in the foil is sampled from its ABSLENGTH and
+// WLSABSLENGTH, with the Fresnel reflection at the guide surface, and the
+// photon is handed back before it: absorption and re-emission in the foil
+// stay with Geant4. The fast-simulation process is only on the photons of jobs
+// started with -g; compare with full tracking with /RS/fastsim/guideTIR 0,
+// or without -g for no fast-simulation overhead at all.
+class ReadoutSimGuideTIRModel : public G4VFastSimulationModel
+{
+    public:
+        // side faces of the guide, in the guide frame
+        enum Face { kMinusY = 0, kPlusY, kMinusZ, kPlusZ, kNumberOfFaces };
+
+        // what surrounds each side face, filled by the detector construction
+        struct Surroundings
+        {
+            G4double foilThickness[kNumberOfFaces];
+            G4Material* foilMaterial[kNumberOfFaces];   // nullptr if the face is bare
+            G4Material* outerMaterial[kNumberOfFaces];  // material beyond the foil
+        };
+
+        ReadoutSimGuideTIRModel(const G4String&, G4Region*, const Surroundings*);
+        virtual ~ReadoutSimGuideTIRModel();
+
+        virtual G4bool IsApplicable(const G4ParticleDefinition&);
+        virtual G4bool ModelTrigger(const G4FastTrack&);
+        virtual void DoIt(const G4FastTrack&, G4FastStep&);
+
+        // shared by the models of all threads, set from the master
+        static void SetEnabled(G4bool val) {fEnabled = val;}
+        static G4bool IsEnabled() {return fEnabled;}
+        // G4FastSimulationPhysics is registered for optical photons (-g)
+        static void SetPhysicsRegistered(G4bool val) {fPhysicsRegistered = val;}
+        static G4bool IsPhysicsRegistered() {return fPhysicsRegistered;}
+
+    private:
+        // per-photon transport constants, see ComputePath()
+        struct Path
+        {
+            G4ThreeVector position;
+            G4ThreeVector direction;
+            G4double halfLength[3];
+            G4double firstHit[3];   // distance to the first wall along each axis
+            G4double period[3];     // distance between two walls along each axis
+            G4double endLength;     // distance to the end face
+            G4double escapeLength;  // distance to the first face the photon can cross
+            G4bool trapped[kNumberOfFaces];
+            G4double foilAbsorption[kNumberOfFaces];  // per reflection, Fresnel included
+            G4double refractiveIndex;
+            G4double absorptionLength;
+        };
+
+        G4bool ComputePath(const G4FastTrack&, Path&) const;
+        G4double FaceHit(const Path&, G4int face) const;
+
+        const Surroundings* fSurroundings;
+
+        static G4bool fEnabled;
+        static G4bool fPhysicsRegistered;
+};
+
+#endif
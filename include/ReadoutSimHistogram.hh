@@ -0,0 +1,76 @@
+#ifndef ReadoutSimHistogram_h
+#define ReadoutSimHistogram_h
+
+#include "G4String.hh"
+
+#include <iosfwd>
+#include <vector>
+
+// Fixed-binning 1D or 2D histogram owned by a Run.
+//
+// Every worker fills the histograms of its own run without any locking,
+// and Run::Merge() adds them bin by bin into the master run, which writes
+// them out as ROOT TH1D/TH2D at the end of the run. Entries outside the
+// range go to the under/overflow bins, as in ROOT.
+class ReadoutSimHistogram
+{
+    public:
+        // 1D
+        ReadoutSimHistogram(const G4String& name, const G4String& title,
+                            G4int nx, G4double xmin, G4double xmax);
+        // 2D
+        ReadoutSimHistogram(const G4String& name, const G4String& title,
+                            G4int nx, G4double xmin, G4double xmax,
+                            G4int ny, G4double ymin, G4double ymax);
+
+        void Fill(G4double x) {FillWeighted(x, 1.);}
+        void Fill(G4double x, G4double y) {FillWeighted(x, y, 1.);}
+        // the sums of the squared weights give the errors, as ROOT's Sumw2()
+        void FillWeighted(G4double x, G4double weight) {FillCell(Index(x, fX), weight);}
+        void FillWeighted(G4double x, G4double y, G4double weight) {FillCell(Index(x, fX) * fY.cells + Index(y, fY), weight);}
+        void Add(const ReadoutSimHistogram&);
+
+        G4double GetEntries() const {return fEntries;}
+
+        // to the current ROOT directory
+        void Write() const;
+
+        // contents as text, for the checkpoints; Load() fails if the binning differs
+        void Save(std::ostream&) const;
+        G4bool Load(std::istream&);
+
+    private:
+        struct Axis
+        {
+            G4int bins;
+            G4int cells;     // bins + under/overflow, 1 for the y axis of a 1D histogram
+            G4double min;
+            G4double max;
+        };
+
+        // 0 underflow, 1..bins, bins + 1 overflow
+        static G4int Index(G4double value, const Axis& axis)
+        {
+            if (axis.cells == 1) return 0;
+            if (value < axis.min) return 0;
+            if (value >= axis.max) return axis.bins + 1;
+            return 1 + G4int((value - axis.min) / (axis.max - axis.min) * axis.bins);
+        }
+
+        void FillCell(G4int cell, G4double weight)
+        {
+            fCounts[cell] += weight;
+            fSquares[cell] += weight * weight;
+            fEntries += 1.;
+        }
+
+        G4String fName;
+        G4String fTitle;
+        Axis fX;
+        Axis fY;
+        std::vector<G4double> fCounts;
+        std::vector<G4double> fSquares;
+        G4double fEntries;
+};
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef ReadoutSimImportanceSampler_h
+#define ReadoutSimImportanceSampler_h
+
+#include "ReadoutSimAliasTable.hh"
+#include "ReadoutSimLightMap.hh"
+
+#include <vector>
+
+// Biased sampling of the primary photons, learnt from a light map filled
+// in a pilot run (/RS/bias/pilot).
+//
+// Instead of uniformly over the N bins of the map, as ReadoutSimSource
+// does, the bin of a photon is drawn with probability
+//   q = alpha / N + (1 - alpha) sqrt(P) / sum(sqrt(P))
+// where P is the detection probability of the bin in the pilot; within
+// the bin the point stays uniform. The photon carries the weight
+// (1 / N) / q, at most 1 / alpha, and weighted counts estimate the same
+// efficiencies as an unbiased run. sqrt(P) minimizes the variance for a
+// photon that is either detected or not; the uniform part alpha keeps
+// every bin in reach, whatever the pilot missed.
+class ReadoutSimImportanceSampler
+{
+    public:
+        ReadoutSimImportanceSampler(const ReadoutSimLightMap&, G4double uniformFraction);
+
+        // the four uniform numbers of ReadoutSimSource::Sample(), returns the weight of the photon
+        G4double Sample(G4double rnd[4]) const;
+
+        G4double GetMinWeight() const {return fMinWeight;}
+        G4double GetMaxWeight() const {return fMaxWeight;}
+
+    private:
+        G4int fBins[ReadoutSimLightMap::kNumberOfAxes];
+        ReadoutSimAliasTable fAlias;
+        std::vector<G4double> fWeights;  // per bin
+        G4double fMinWeight;
+        G4double fMaxWeight;
+};
+
+#endif
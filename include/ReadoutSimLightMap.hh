@@ -0,0 +1,68 @@
+#ifndef ReadoutSimLightMap_h
+#define ReadoutSimLightMap_h
+
+#include "G4ThreeVector.hh"
+#include "G4String.hh"
+
+#include <vector>
+
+// Probability that a photon of the baseline source reaches the right and/or
+// left detector, binned over the source plane and the photon direction.
+//
+// The axes are those of ReadoutSimSource::Sample(): x and z on the source
+// plane, u = cos(theta) along z, and the azimuth v of the direction.
+// Every bin counts the photons started in it and how many of them had at
+// least one descendant detected on the right, on the left, or on both sides.
+class ReadoutSimLightMap
+{
+    public:
+        enum Outcome { kNone = 0, kRight, kLeft, kBoth };
+        enum Axis { kX = 0, kZ, kU, kV, kNumberOfAxes };
+
+        ReadoutSimLightMap(G4int nx = 20, G4int nz = 4, G4int nu = 10, G4int nv = 10);
+
+        G4int GetBin(const G4ThreeVector& position, const G4ThreeVector& direction) const;
+        G4int GetNumberOfBins() const {return G4int(fCounts.size()) / kEntriesPerBin;}
+        G4int GetNumberOfBins(Axis axis) const {return fBins[axis];}
+
+        // weight: of an importance sampled photon, the counts are sums of weights
+        void Fill(G4int bin, G4bool right, G4bool left, G4double weight = 1.);
+        void Add(const ReadoutSimLightMap&);
+
+        // outcome for one photon started in the bin, rnd uniform in [0, 1)
+        Outcome Sample(G4int bin, G4double rnd) const
+        {
+            const G4double* counts = &fCounts[bin * kEntriesPerBin];
+            G4double x = rnd * counts[0];
+            if (x < counts[kRight]) return kRight;
+            x -= counts[kRight];
+            if (x < counts[kLeft]) return kLeft;
+            x -= counts[kLeft];
+            if (x < counts[kBoth]) return kBoth;
+            return kNone;
+        }
+        G4double GetEntries(G4int bin) const {return fCounts[bin * kEntriesPerBin];}
+        // photons of the bin detected on either side
+        G4double GetDetected(G4int bin) const
+        {
+            const G4double* counts = &fCounts[bin * kEntriesPerBin];
+            return counts[kRight] + counts[kLeft] + counts[kBoth];
+        }
+        G4double GetEntries() const;
+        G4int GetNumberOfEmptyBins() const;
+
+        // plain text, one line per bin
+        G4bool Write(const G4String& fileName) const;
+        G4bool Read(const G4String& fileName);
+
+    private:
+        // entries, right only, left only, both
+        static const G4int kEntriesPerBin = 4;
+
+        G4int fBins[kNumberOfAxes];
+        G4double fMin[kNumberOfAxes];
+        G4double fMax[kNumberOfAxes];
+        std::vector<G4double> fCounts;
+};
+
+#endif
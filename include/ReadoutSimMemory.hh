@@ -0,0 +1,58 @@
+#ifndef ReadoutSimMemory_h
+#define ReadoutSimMemory_h
+
+#include "G4Types.hh"
+
+#include <cstdio>
+#include <sys/resource.h>
+#include <unistd.h>
+
+// Memory footprint of the process, in MB; 0 where it cannot be read
+namespace ReadoutSimMemory
+{
+    // current resident set size, Linux only
+    inline G4double GetResident()
+    {
+        G4double resident = 0.;
+        std::FILE* file = std::fopen("/proc/self/statm", "r");
+        if (!file) return resident;
+        long size = 0, pages = 0;
+        if (std::fscanf(file, "%ld %ld", &size, &pages) == 2)
+            resident = G4double(pages) * sysconf(_SC_PAGESIZE) / (1024. * 1024.);
+        std::fclose(file);
+        return resident;
+    }
+
+    // resident set size with the pages shared with other processes split
+    // between them, e.g. the copy-on-write pages of forked workers; Linux 4.14+
+    inline G4double GetProportional()
+    {
+        G4double proportional = 0.;
+        std::FILE* file = std::fopen("/proc/self/smaps_rollup", "r");
+        if (!file) return proportional;
+        char line[256];
+        long kB = 0;
+        while (std::fgets(line, sizeof(line), file))
+            if (std::sscanf(line, "Pss: %ld", &kB) == 1)
+            {
+                proportional = G4double(kB) / 1024.;
+                break;
+            }
+        std::fclose(file);
+        return proportional;
+    }
+
+    // largest resident set size so far
+    inline G4double GetPeakResident()
+    {
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) != 0) return 0.;
+#ifdef __APPLE__
+        return G4double(usage.ru_maxrss) / (1024. * 1024.);  // bytes
+#else
+        return G4double(usage.ru_maxrss) / 1024.;           // kB
+#endif
+    }
+}
+
+#endif
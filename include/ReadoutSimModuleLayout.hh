@@ -0,0 +1,38 @@
+#ifndef ReadoutSimModuleLayout_h
+#define ReadoutSimModuleLayout_h
+
+#include "G4Types.hh"
+
+#include <cmath>
+
+// Copies of the baseline cell (one guide with its PEN foil and two end
+// detectors) in a module of bars along z on each panel, and an array of
+// panels side by side along x. One bar on one panel is the baseline design.
+// Bar b of panel p is the baseline cell moved by (PanelOffset(p), 0, BarOffset(b)).
+struct ReadoutSimModuleLayout
+{
+    G4int nBars = 1;
+    G4int nPanels = 1;
+    G4double barPitch = 0.;     // along z, the panel length divided by nBars
+    G4double panelPitch = 0.;   // along x
+
+    G4bool IsBaseline() const {return nBars == 1 && nPanels == 1;}
+    G4int GetNumberOfChannels() const {return nBars * nPanels;}
+
+    G4double BarOffset(G4int bar) const {return (bar - 0.5 * (nBars - 1)) * barPitch;}
+    G4double PanelOffset(G4int panel) const {return (panel - 0.5 * (nPanels - 1)) * panelPitch;}
+
+    // nearest bar and panel to a point, clamped to the module
+    G4int FindBar(G4double z) const {return Nearest(z, barPitch, nBars);}
+    G4int FindPanel(G4double x) const {return Nearest(x, panelPitch, nPanels);}
+
+    private:
+        static G4int Nearest(G4double u, G4double pitch, G4int n)
+        {
+            if (n <= 1 || pitch <= 0.) return 0;
+            G4int i = G4int(std::floor(u / pitch + 0.5 * n));
+            return i < 0 ? 0 : (i >= n ? n - 1 : i);
+        }
+};
+
+#endif
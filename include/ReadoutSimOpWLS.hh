@@ -0,0 +1,61 @@
+#ifndef ReadoutSimOpWLS_h
+#define ReadoutSimOpWLS_h
+
+#include "G4VDiscreteProcess.hh"
+#include "G4GenericMessenger.hh"
+#include "ReadoutSimWLSTables.hh"
+
+#include <vector>
+
+// Wavelength shifting of optical photons, a drop-in for G4OpWLS.
+//
+// Same physics and the same material properties (WLSABSLENGTH, WLSCOMPONENT,
+// WLSTIMECONSTANT, WLSMEANNUMBERPHOTONS), but the tables are built once per
+// material in BuildPhysicsTable(): the emission energy is drawn from an
+// alias table and the absorption length read from a uniform energy grid, so
+// neither needs a search or a property-table lookup per photon. The
+// distribution of the emitted energies is that of G4OpWLS, see
+// ReadoutSimWLSEmission. Registered as "OpWLS" with subtype fOpWLS, so the
+// /process/ commands and the fate classification see no difference.
+//
+// /RS/wls/emission weighted replaces the Poisson number of photons by a
+// single photon carrying the mean number as a weight: the same expected
+// light, without the conversions that emit nothing or several photons.
+// /RS/wls/timeProfile exponential delays the emission by WLSTIMECONSTANT,
+// as /process/optical/wls/setTimeProfile does for G4OpWLS, which does not
+// reach this process. The commands exist once the physics is built (after
+// /run/initialize).
+class ReadoutSimOpWLS : public G4VDiscreteProcess
+{
+    public:
+        ReadoutSimOpWLS(const G4String& processName = "OpWLS", G4ProcessType type = fOptical);
+        virtual ~ReadoutSimOpWLS();
+
+        virtual G4bool IsApplicable(const G4ParticleDefinition&);
+        virtual void BuildPhysicsTable(const G4ParticleDefinition&);
+
+        virtual G4double GetMeanFreePath(const G4Track&, G4double, G4ForceCondition*);
+        virtual G4VParticleChange* PostStepDoIt(const G4Track&, const G4Step&);
+
+        // "delta" (default, as G4OpticalPhysics) or "exponential" delay, /RS/wls/timeProfile
+        void UseTimeProfile(G4String);
+
+        // one photon weighted by the mean number instead of a Poisson number
+        G4bool IsWeightedEmission() const {return fEmission == "weighted";}
+
+    private:
+        struct MaterialTables
+        {
+            ReadoutSimGridVector absorptionLength;   // empty: no WLS in the material
+            ReadoutSimWLSEmission emission;          // empty: absorbed without emission
+            G4double timeConstant = 0.;
+            G4double meanNumberPhotons = -1.;    // negative: one photon per absorption
+        };
+
+        std::vector<MaterialTables> fTables;     // by material index
+        G4bool fExponentialTime;
+        G4String fEmission;
+        G4GenericMessenger* fMessenger;
+};
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef ReadoutSimOpticalPhysicsList_h
+#define ReadoutSimOpticalPhysicsList_h
+
+#include "G4VModularPhysicsList.hh"
+
+class G4OpticalPhysics;
+
+// Transportation and the optical processes only, for jobs whose primaries
+// are optical photons (ReadoutSim -p optical). Nothing else acts on an
+// optical photon, so the results are those of FTFP_BERT + G4OpticalPhysics,
+// without building the EM and hadronic tables at the first run.
+class ReadoutSimOpticalPhysicsList : public G4VModularPhysicsList
+{
+    public:
+        ReadoutSimOpticalPhysicsList(G4int verbose = 1);
+        virtual ~ReadoutSimOpticalPhysicsList();
+
+        virtual void ConstructParticle();
+
+        G4OpticalPhysics* GetOpticalPhysics() const {return fOpticalPhysics;}
+
+    private:
+        G4OpticalPhysics* fOpticalPhysics;
+};
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef ReadoutSimOpticalTables_h
+#define ReadoutSimOpticalTables_h
+
+#include "G4Types.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+// Optical properties of the materials. Shared by the detector construction
+// and the standalone ray tracer, so that both use the same numbers.
+namespace ReadoutSimOpticalTables
+{
+    // PMMA
+    const G4double pmmaRIndex = 1.50;       // for PMMA @ 430nm
+    const G4double pmmaAbsorption = 2.*m;   // for PMMA @ 430nm, try 1.5/2/2.5/3 m
+
+    // PEN
+    const G4double penRIndex = 1.7;         // for PEN @ 430nm
+    const G4int absorption_entries = 136;
+    const G4double absorption_energy[136] = {12.*eV, 3.25814*eV,3.23948*eV,3.22315*eV,3.20819*eV,3.19096*eV,3.17511*eV,3.15942*eV,3.14388*eV,3.12612*eV,3.10698*eV,3.09271*eV,3.07916*eV,3.06507*eV,3.05309*eV,3.04186*eV,3.02973*eV,3.02013*eV,3.00802*eV,2.99648*eV,2.98503*eV,2.97493*eV,2.96239*eV,2.95244*eV,2.94243*eV,2.93218*eV,2.92149*eV,2.90902*eV,2.90005*eV,2.89053*eV,2.88579*eV,2.87611*eV,2.86416*eV,2.85268*eV,2.84109*eV,2.82832*eV,2.82095*eV,2.80855*eV,2.79673*eV,2.78961*eV,2.78390*eV,2.77279*eV,2.76498*eV,2.75155*eV,2.74112*eV,2.72878*eV,2.71710*eV,2.70530*eV,2.69350*eV,2.66995*eV,2.65884*eV,2.64937*eV,2.61333*eV,2.60607*eV,2.58887*eV,2.57971*eV,2.56882*eV,2.55787*eV,2.53466*eV,2.51224*eV,2.50293*eV,2.49215*eV,2.48426*eV,2.47415*eV,2.46551*eV,2.45629*eV,2.43998*eV,2.42426*eV,2.38991*eV,2.36889*eV,2.35666*eV,2.34899*eV,2.34214*eV,2.32433*eV,2.30188*eV,2.29362*eV,2.28542*eV,2.27912*eV,2.25971*eV,2.23884*eV,2.23103*eV,2.22327*eV,2.21801*eV,2.20065*eV,2.18052*eV,2.17310*eV,2.16574*eV,2.16041*eV,2.14329*eV,2.12515*eV,2.11811*eV,2.11111*eV,2.10574*eV,2.08947*eV,2.07314*eV,2.06644*eV,2.05972*eV,2.05466*eV,2.03887*eV,2.02186*eV,2.01549*eV,2.00915*eV,2.00486*eV,1.99038*eV,1.97695*eV,1.97085*eV,1.96480*eV,1.96123*eV,1.94927*eV,1.93665*eV,1.93004*eV,1.92578*eV,1.91555*eV,1.90491*eV,1.90002*eV,1.89541*eV,1.88600*eV,1.87689*eV,1.87244*eV,1.87020*eV,1.86030*eV,1.85376*eV,1.84856*eV,1.84033*eV,1.83314*eV,1.82837*eV,1.82401*eV,1.81985*eV,1.81248*eV,1.80920*eV,1.80189*eV,1.79320*eV,1.78871*eV,1.77977*eV,1.77483*eV, 1.77147*eV};
+    const G4double absorption_values[136] = {0.3758, 0.3758,0.4457,0.5604,0.2549,0.2937,0.4058,0.7564,1.172,1.7744,2.4753,3.9466,5.0731,6.8639,8.2917,10.1109,12.2749,14.3209,16.8414,19.0424,21.3319,23.6221,25.7956,28.0331,30.1711,32.3501,34.6198,37.2724,39.1275,41.383,43.0375,44.6318,46.6015,48.5223,50.7679,53.0692,55.1642,57.0244,58.3387,58.7343,60.8373,61.3766,63.1698,63.6815,64.6267,65.4004,66.1446,67.7824,68.2573,69.166,69.421,69.0529,69.7186,69.5965,70.9755,71.1224,71.3394,71.5693,71.2311,71.1341,70.3446,69.7107,69.2227,67.7364,67.5254,67.4859,67.6422,67.7565,67.0881,67.1796,67.4574,67.6737,68.077,69.1077,69.8746,70.3309,70.3277,70.4992,70.2329,69.1941,68.8777,68.3743,68.0007,66.5712,65.4022,65.2242,64.7695,64.5717,64.538,65.1323,65.8164,66.3866,66.4781,67.5016,68.6281,68.8893,69.1024,69.3924,70.5099,71.3434,72.3067,72.736,72.948,74.0237,76.4575,76.9708,78.4357,78.9934,80.8292,84.1252,86.2386,87.2857,90.7117,94.4017,96.5345,98.0538,101.6405,104.496,106.4628,108.5769,111.8888,115.6327,116.6733,116.8666,120.3332,122.1505,122.0227,120.9319,125.004,127.1816,128.182,130.8079,132.2029,134.2453,132.8147,133.6449};
+    const G4int emission_entries = 200;
+    const G4double emission_energy[200] = {4.121*eV, 4.076*eV,4.034*eV,3.995*eV,3.956*eV,3.918*eV,3.882*eV,3.845*eV,3.806*eV,3.773*eV,3.738*eV,3.704*eV,3.671*eV,3.639*eV,3.606*eV,3.574*eV,3.543*eV,3.513*eV,3.483*eV,3.453*eV,3.424*eV,3.411*eV,3.387*eV,3.373*eV,3.364*eV,3.355*eV,3.350*eV,3.346*eV,3.338*eV,3.334*eV,3.331*eV,3.322*eV,3.319*eV,3.317*eV,3.310*eV,3.301*eV,3.295*eV,3.294*eV,3.288*eV,3.282*eV,3.280*eV,3.278*eV,3.271*eV,3.266*eV,3.265*eV,3.258*eV,3.252*eV,3.246*eV,3.246*eV,3.242*eV,3.234*eV,3.232*eV,3.228*eV,3.220*eV,3.217*eV,3.213*eV,3.205*eV,3.197*eV,3.192*eV,3.184*eV,3.177*eV,3.177*eV,3.169*eV,3.165*eV,3.163*eV,3.156*eV,3.151*eV,3.145*eV,3.145*eV,3.137*eV,3.132*eV,3.130*eV,3.122*eV,3.118*eV,3.118*eV,3.110*eV,3.105*eV,3.104*eV,3.094*eV,3.085*eV,3.081*eV,3.073*eV,3.066*eV,3.051*eV,3.035*eV,3.013*eV,2.991*eV,2.969*eV,2.948*eV,2.929*eV,2.918*eV,2.905*eV,2.897*eV,2.890*eV,2.881*eV,2.874*eV,2.869*eV,2.861*eV,2.859*eV,2.850*eV,2.846*eV,2.839*eV,2.837*eV,2.830*eV,2.821*eV,2.814*eV,2.813*eV,2.806*eV,2.799*eV,2.795*eV,2.789*eV,2.781*eV,2.775*eV,2.771*eV,2.761*eV,2.761*eV,2.755*eV,2.744*eV,2.736*eV,2.729*eV,2.725*eV,2.723*eV,2.717*eV,2.708*eV,2.700*eV,2.691*eV,2.681*eV,2.676*eV,2.667*eV,2.664*eV,2.653*eV,2.649*eV,2.640*eV,2.631*eV,2.627*eV,2.619*eV,2.610*eV,2.601*eV,2.589*eV,2.586*eV,2.577*eV,2.566*eV,2.554*eV,2.545*eV,2.535*eV,2.525*eV,2.516*eV,2.501*eV,2.484*eV,2.471*eV,2.459*eV,2.450*eV,2.440*eV,2.425*eV,2.414*eV,2.400*eV,2.387*eV,2.373*eV,2.362*eV,2.349*eV,2.336*eV,2.323*eV,2.310*eV,2.296*eV,2.284*eV,2.271*eV,2.258*eV,2.245*eV,2.233*eV,2.222*eV,2.210*eV,2.197*eV,2.185*eV,2.174*eV,2.163*eV,2.152*eV,2.140*eV,2.129*eV,2.118*eV,2.107*eV,2.096*eV,2.085*eV,2.075*eV,2.064*eV,2.054*eV,2.043*eV,2.033*eV,2.023*eV,2.013*eV,2.003*eV,1.994*eV,1.985*eV,1.974*eV,1.965*eV,1.956*eV,1.946*eV,1.936*eV,1.928*eV,1.918*eV,1.911*eV};
+    const G4double emission_values[200] = {7.0293,16.9415,10.7047,45.726,50.7554,55.2072,77.4307,61.2781,45.8031,16.3452,55.7023,14.6248,-13.1988,6.555,2.6498,-11.4939,-4.7904,25.487,49.7759,96.5219,209.3136,339.5284,512.1626,725.255,927.58,1143.9247,1351.3291,1644.9531,1925.6427,2196.7536,2442.0504,2618.048,2776.4256,2996.688,3263.9944,3500.9443,3742.1178,3983.4344,4230.3848,4398.3571,4600.1356,4827.7794,5078.4118,5300.7009,5571.4976,5856.4642,6061.7348,6266.8834,6405.6897,6594.1269,6841.5772,6978.9624,7170.03,7420.6595,7568.734,7797.5579,8031.0384,8247.0488,8535.363,8787.8291,8922.142,9141.1737,9406.8964,9567.665,9782.9677,10063.6821,10283.1786,10456.5366,10688.7506,10967.5929,11178.9257,11444.6893,11714.6674,11897.2054,12072.3493,12339.7591,12495.3968,12730.9516,13001.2756,13216.637,13448.1597,13627.8594,13827.8985,14053.2262,14269.0933,14441.0115,14501.9804,14524.0235,14458.484,14325.3404,14134.0736,13963.8366,13768.8243,13593.031,13393.594,13145.8641,12952.8068,12782.246,12560.672,12346.54,12124.4686,11936.6808,11725.3635,11529.9927,11302.2122,11015.0504,10797.0964,10562.8642,10434.8026,10173.7304,10030.1194,9757.0008,9550.5153,9328.0247,9179.752,8931.5451,8733.5726,8491.1374,8272.8068,7956.0463,7868.4239,7649.2608,7485.9592,7262.1554,7048.2165,6675.112,6386.5461,6167.6057,5951.6386,5694.8763,5468.461,5314.9438,5024.5664,4838.6677,4640.787,4426.4052,4231.3355,4044.6662,3855.5094,3652.9909,3430.2043,3196.1524,3011.6655,2784.6268,2605.7246,2452.9249,2302.4445,2118.9833,1899.8405,1748.9089,1623.6297,1489.8054,1371.2659,1239.6131,1171.9962,1046.581,938.7413,868.631,772.7616,701.2099,625.1904,579.8622,545.0141,494.4586,503.6137,472.2251,452.3345,494.5934,508.9393,542.4361,608.6249,707.8472,777.5688,870.1675,877.0437,869.6932,812.2685,734.182,622.9797,513.2745,419.066,359.4056,291.2013,278.2788,237.0143,213.6086,207.9547,159.0263,171.1955,158.1363,175.3452,142.3859,135.165,137.5661,119.57,134.6123,105.92,93.3617,89.2049,47.6809};
+    const G4double wlsTimeConstant = 25.3*ns;    // from L. Manzanillas et al. “Optical properties of low background PEN structural components for the LEGEND-200 experiment”. In: JINST 17 P09007 (2022), https://doi.org/10.1088/1748-0221/17/09/P09007
+    const G4double wlsMeanNumberPhotons = 0.69;  // from [Araujo2022] at LAr temperature
+
+    // LAr
+    const G4double larRIndex = 1.23;        // for lAr @ 430nm, from Sellmeier formula
+    const G4double larAbsorption = 0.1*m;   // for lAr @ 430nm, random value to just kill photons when they enter in lAr volume
+
+    // The PEN tables are listed from high to low energy. Property vectors
+    // interpolate on ascending energies, so copy them in that order.
+    inline void Ascending(const G4double* energy, const G4double* values, G4int n,
+                          std::vector<G4double>& sortedEnergy, std::vector<G4double>& sortedValues)
+    {
+        std::vector<std::pair<G4double, G4double> > points;
+        for (G4int i = 0; i < n; i++) points.push_back(std::make_pair(energy[i], values[i]));
+        std::sort(points.begin(), points.end());
+
+        sortedEnergy.clear();
+        sortedValues.clear();
+        for (const auto& point : points)
+        {
+            sortedEnergy.push_back(point.first);
+            sortedValues.push_back(point.second);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef ReadoutSimOutputWriter_h
+#define ReadoutSimOutputWriter_h
+
+#include "ReadoutSimPhotonRecord.hh"
+#include "ReadoutSimRecordBuffer.hh"
+
+#include "globals.hh"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class TFile;
+class TTree;
+
+// Writes the photon records of all worker threads to a single ROOT file.
+//
+// Every thread that pushes a record gets its own ReadoutSimRecordBuffer.
+// A dedicated writer thread drains the buffers into one compressed TTree,
+// so tracking never waits on disk; a worker only waits when its buffer is
+// full. The tree has the branches of the Score ntuple (ReadoutSimPhotonRecord).
+// With a maximum file size, ROOT continues in name_1.root, name_2.root, ...
+class ReadoutSimOutputWriter
+{
+    public:
+        static ReadoutSimOutputWriter* Instance();
+
+        // master thread, at the begin of the run; false if the file cannot be
+        // written, the records of the run are then dropped
+        G4bool Open(const G4String& fileName, G4bool withDirection, G4double maxFileSize);
+        // master thread, once all workers have finished the run
+        void Close();
+
+        // any worker thread
+        void Push(const ReadoutSimPhotonRecord&);
+        G4bool IsRunning() const {return fRunning;}
+
+    private:
+        ReadoutSimOutputWriter();
+        ~ReadoutSimOutputWriter();
+
+        ReadoutSimRecordBuffer* GetBuffer();
+        void Loop();
+        std::size_t Drain();
+
+        std::vector<std::unique_ptr<ReadoutSimRecordBuffer> > fBuffers;
+        std::mutex fBuffersMutex;
+
+        std::thread fThread;
+        std::atomic<bool> fStop;
+        std::atomic<bool> fRunning;  // a writer thread drains the buffers
+        std::atomic<long> fStalls;   // pushes that found the buffer full
+
+        TFile* fFile;
+        TTree* fTree;
+        ReadoutSimPhotonRecord fRow;  // branch addresses
+        long fWritten;
+        long long fPreviousMaxTreeSize;  // ROOT's global limit, restored by Close()
+};
+
+#endif
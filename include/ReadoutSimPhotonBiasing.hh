@@ -0,0 +1,60 @@
+#ifndef ReadoutSimPhotonBiasing_h
+#define ReadoutSimPhotonBiasing_h
+
+#include "ReadoutSimVolumeRegistry.hh"
+
+#include "G4GenericMessenger.hh"
+#include "G4Track.hh"
+#include "globals.hh"
+
+class G4Step;
+class Run;
+
+// Russian roulette and splitting of the tracked photons.
+//
+// Roulette (/RS/roulette/), for photons that are unlikely to be detected:
+//   length     every time the track length of a photon crosses a multiple
+//              of it, 0 for never
+//   volumes    when a photon goes into one of these volumes (world, panel,
+//              pen, guide), empty for none
+// the photon survives with probability /RS/roulette/survival and its
+// weight is divided by it, otherwise it is killed with weight 0.
+//
+// Splitting (/RS/split/), for photons that are likely to be detected: a
+// photon going into the guide with |cos| of its direction to the guide
+// axis (x, towards the detectors) of at least minCosine goes on as
+// /RS/split/guide photons of 1/N of its weight. A photon is split once,
+// the WLS photons of a split one are not split again.
+//
+// Both keep every expectation value of a weighted sum and change only the
+// variance; compare with them off before using them for production. They
+// are off by default and while a light map is filled, which counts photons.
+class ReadoutSimPhotonBiasing
+{
+    public:
+        ReadoutSimPhotonBiasing();
+        ~ReadoutSimPhotonBiasing();
+
+        // called by the stepping action at the end of a step of a photon that
+        // is still alive; split copies are added to the secondaries of the step
+        void Apply(G4Track*, const G4Step*, ReadoutSimVolumeRegistry::VolumeID startVolume,
+                   ReadoutSimVolumeRegistry::VolumeID endVolume, G4TrackVector* secondaries, Run*) const;
+
+    private:
+        void DefineCommands();
+        void SetRouletteVolumes(G4String);
+
+        // false if the photon was killed
+        G4bool PlayRoulette(G4Track*, Run*) const;
+        void Split(G4Track*, const G4Step*, G4TrackVector* secondaries, Run*) const;
+
+        G4double fRouletteLength;
+        G4bool fRouletteIn[ReadoutSimVolumeRegistry::kNumberOfVolumes];
+        G4double fSurvival;
+        G4int fGuideSplit;
+        G4double fMinCosine;
+        G4GenericMessenger* fRouletteMessenger;
+        G4GenericMessenger* fSplitMessenger;
+};
+
+#endif
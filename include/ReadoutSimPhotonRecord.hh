@@ -0,0 +1,78 @@
+#ifndef ReadoutSimPhotonRecord_h
+#define ReadoutSimPhotonRecord_h
+
+#include <cmath>
+#include <cstdint>
+
+// One row of the photon ntuple: fixed-size, no strings.
+//
+// Volumes are ReadoutSimVolumeRegistry::VolumeID codes, positions are in cm
+// and energies in eV, stored as float. The initial direction is packed in a
+// single integer (octahedral mapping, 16 bits per coordinate, about 1e-4 rad)
+// or left out of the file. Rows of undetected photons can be prescaled, the
+// weight column says how many photons a row stands for: the prescale times
+// the importance sampling weight of the photon.
+struct ReadoutSimPhotonRecord
+{
+    enum Fate
+    {
+        kUnknownFate = 0,
+        kDetectedRight,
+        kDetectedLeft,
+        kAbsorbed,          // bulk absorption (OpAbsorption)
+        kWLSAbsorbed,       // absorbed by the WLS process, the energy goes to re-emitted photons
+        kEscaped,           // left the world volume
+        kKilled             // stopped by anything else, e.g. a user kill rule
+    };
+
+    std::int32_t initialVolume;
+    std::int32_t finalVolume;
+    std::int32_t fate;
+    float vertex[3];
+    float position[3];
+    float energy;
+    float weight;
+    std::int32_t direction;
+
+    // ntuple columns, the direction is the last one and optional
+    static void Book(bool withDirection);
+    void AddRow(bool withDirection) const;
+
+    static std::int32_t EncodeDirection(double x, double y, double z)
+    {
+        double norm = std::fabs(x) + std::fabs(y) + std::fabs(z);
+        double u = x / norm;
+        double v = y / norm;
+        if (z < 0.)
+        {
+            double foldedU = (1. - std::fabs(v)) * (u < 0. ? -1. : 1.);
+            double foldedV = (1. - std::fabs(u)) * (v < 0. ? -1. : 1.);
+            u = foldedU;
+            v = foldedV;
+        }
+        std::uint32_t qu = std::uint32_t(std::lround((u * 0.5 + 0.5) * 65535.));
+        std::uint32_t qv = std::uint32_t(std::lround((v * 0.5 + 0.5) * 65535.));
+        return std::int32_t((qu << 16) | qv);
+    }
+
+    static void DecodeDirection(std::int32_t code, double& x, double& y, double& z)
+    {
+        std::uint32_t bits = std::uint32_t(code);
+        x = (bits >> 16) / 65535. * 2. - 1.;
+        y = (bits & 0xFFFF) / 65535. * 2. - 1.;
+        z = 1. - std::fabs(x) - std::fabs(y);
+        if (z < 0.)
+        {
+            double unfoldedX = (1. - std::fabs(y)) * (x < 0. ? -1. : 1.);
+            double unfoldedY = (1. - std::fabs(x)) * (y < 0. ? -1. : 1.);
+            x = unfoldedX;
+            y = unfoldedY;
+        }
+        double norm = std::sqrt(x * x + y * y + z * z);
+        x /= norm;
+        y /= norm;
+        z /= norm;
+    }
+};
+
+#endif
@@ -5,8 +5,14 @@
 
 #include "G4VUserPrimaryGeneratorAction.hh"
 
-#include "TRandom3.h"
 #include "G4ParticleGun.hh"
+#include "G4GenericMessenger.hh"
+
+#include <cstdint>
+#include <vector>
+
+class Run;
+class ReadoutSimImportanceSampler;
 
 class ReadoutSimPrimaryGenerator : public G4VUserPrimaryGeneratorAction
 {
@@ -20,14 +26,23 @@ class ReadoutSimPrimaryGenerator : public G4VUserPrimaryGeneratorAction
         void SetOptPhotonPolar(G4double);
 
     private:
+        void DefineCommands();
+        // returns the weight of the photon
+        G4double GeneratePhoton(G4Event*, G4double sourceZHalfWidth, const ReadoutSimImportanceSampler*);
+        void LookUpPhotons(Run*);
+        // the next vertex of ReadoutSimVertexLibrary, false once it is used up
+        G4bool ReadPhoton(G4Event*);
+
         G4ParticleGun *fParticleGun; 
+        G4GenericMessenger *fMessenger;
+
+        G4int fPhotonsPerEvent;
+        std::vector<G4double> fWeights;  // of the photons of the event
 
-        TRandom3* surfaceGenerator = new TRandom3(0);
-        TRandom3* xPosGenerator = new TRandom3(0);
-        TRandom3* yPosGenerator = new TRandom3(0);
-        TRandom3* zPosGenerator = new TRandom3(0);
-        TRandom3* thetaGenerator = new TRandom3(0); // cos(theta) 
-        TRandom3* phiGenerator   = new TRandom3(0); // phi angle 
+        // chunk of the vertex library claimed by this thread, [next, end)
+        std::uint64_t fNextVertex;
+        std::uint64_t fEndVertex;
+        std::uint64_t fVertexGeneration;
 
         G4bool fPolarized;
 
@@ -0,0 +1,44 @@
+#ifndef ReadoutSimProcessPool_h
+#define ReadoutSimProcessPool_h
+
+#include "G4GenericMessenger.hh"
+#include "globals.hh"
+
+#include <vector>
+
+// Multi-process runs from one initialization, ReadoutSim -f N.
+//
+// /RS/fork/run N builds the physics tables with /run/beamOn 0, then forks
+// /RS/fork/processes children that share the geometry and the tables
+// copy-on-write. Every child seeds its engine from a pair of seeds drawn
+// from the parent engine before the fork, runs its share of the N events
+// as a run tagged f0, f1, ... and sends its counters and histograms back
+// through a pipe. The parent adds them up, prints the summary of all
+// processes, writes the summed histograms and merges the photon records
+// of the children into one file.
+//
+// The worker threads of G4MTRunManager are started by /run/initialize and
+// do not survive a fork, so in this mode the job has a sequential run
+// manager and every child is a single-threaded process.
+class ReadoutSimProcessPool
+{
+    public:
+        ReadoutSimProcessPool(G4int nProcesses);
+        ~ReadoutSimProcessPool();
+
+    private:
+        void DefineCommands();
+        void Run(G4int nEvents);
+
+        // in the child: runs nEvents and writes the results to fd, never returns
+        [[noreturn]] void RunChild(G4int index, G4int nEvents, const long* seeds, int fd);
+        static G4String ReadAll(int fd);
+        static G4bool WriteAll(int fd, const std::string&);
+        // the async files of the children into fileName, which replaces them
+        static G4bool MergeRecords(const G4String& fileName, const std::vector<G4String>& parts);
+
+        G4int fNumberOfProcesses;
+        G4GenericMessenger* fMessenger;
+};
+
+#endif
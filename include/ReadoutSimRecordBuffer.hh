@@ -0,0 +1,57 @@
+#ifndef ReadoutSimRecordBuffer_h
+#define ReadoutSimRecordBuffer_h
+
+#include "ReadoutSimPhotonRecord.hh"
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Lock-free ring of fixed-size records with one producer (a worker thread)
+// and one consumer (the output writer or the stream sender thread).
+template <typename Record>
+class ReadoutSimRingBuffer
+{
+    public:
+        // capacity is rounded up to a power of two
+        explicit ReadoutSimRingBuffer(std::size_t capacity)
+        : fHead(0), fTail(0)
+        {
+            std::size_t size = 1;
+            while (size < capacity) size <<= 1;
+            fRecords.resize(size);
+            fMask = size - 1;
+        }
+
+        // producer side, false if the ring is full
+        bool Push(const Record& record)
+        {
+            std::size_t head = fHead.load(std::memory_order_relaxed);
+            if (head - fTail.load(std::memory_order_acquire) > fMask) return false;
+            fRecords[head & fMask] = record;
+            fHead.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        // consumer side, copies up to max records and returns how many
+        std::size_t Pop(Record* records, std::size_t max)
+        {
+            std::size_t tail = fTail.load(std::memory_order_relaxed);
+            std::size_t available = fHead.load(std::memory_order_acquire) - tail;
+            std::size_t n = available < max ? available : max;
+            for (std::size_t i = 0; i < n; i++) records[i] = fRecords[(tail + i) & fMask];
+            fTail.store(tail + n, std::memory_order_release);
+            return n;
+        }
+
+    private:
+        std::vector<Record> fRecords;
+        std::size_t fMask;
+        // on separate cache lines, each written by one side only
+        alignas(64) std::atomic<std::size_t> fHead;
+        alignas(64) std::atomic<std::size_t> fTail;
+};
+
+typedef ReadoutSimRingBuffer<ReadoutSimPhotonRecord> ReadoutSimRecordBuffer;
+
+#endif
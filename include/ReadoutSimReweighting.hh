@@ -0,0 +1,53 @@
+#ifndef ReadoutSimReweighting_h
+#define ReadoutSimReweighting_h
+
+#include "globals.hh"
+
+#include <vector>
+
+class ReadoutSimTrackInformation;
+
+// Detection efficiency for other PMMA/LAr absorption lengths and WLS
+// yields, from the photons tracked with the nominal ones.
+//
+// A detected photon is weighted by the ratio of the probabilities of its
+// history (its own and its ancestors'):
+//   exp(-L (1/lambda' - 1/lambda))              per absorbing material
+//   (mu'/mu)^k exp(-(mu' - mu))                 per WLS conversion that emitted k photons
+//   mu'/mu                                      per weighted WLS emission (/RS/wls/emission)
+// where L is the optical path in the material. Weights far from 1 mean
+// few photons carry the estimate: the effective number of photons
+// (sum w)^2 / sum w^2 and the largest weight tell how far it can be trusted.
+class ReadoutSimReweighting
+{
+    public:
+        struct Point
+        {
+            G4double pmmaAbsorption;
+            G4double larAbsorption;
+            G4double wlsYield;
+        };
+
+        // the nominal values are those of ReadoutSimOpticalTables
+        ReadoutSimReweighting(const std::vector<Point>&);
+
+        // a detected photon, with its importance sampling weight
+        void Fill(const ReadoutSimTrackInformation&, G4double weight = 1.);
+        void Add(const ReadoutSimReweighting&);
+
+        void Print(G4long nPrimaries) const;
+
+    private:
+        std::vector<Point> fPoints;
+        // G4Material indices of the optical path lengths
+        std::size_t fPMMAIndex;
+        std::size_t fLArIndex;
+
+        // per point
+        std::vector<G4double> fSumWeights;
+        std::vector<G4double> fSumSquaredWeights;
+        std::vector<G4double> fMaxWeight;
+        G4long fDetected;
+};
+
+#endif
@@ -2,6 +2,8 @@
 #define ReadoutSimRunAction_h
 
 #include "G4UserRunAction.hh"
+#include "G4GenericMessenger.hh"
+#include "G4Timer.hh"
 
 #include "Run.hh"
 
@@ -15,8 +17,85 @@ class ReadoutSimRunAction : public G4UserRunAction
         virtual void EndOfRunAction(const G4Run *aRun);
         G4Run* GenerateRun();
 
+        // run of this thread, counts the fate of every track
+        Run* GetRun() const {return fRun;}
+
+        // photon ntuple settings, see ReadoutSimPhotonRecord
+        G4bool GetWriteRecords() const {return fWriteRecords;}
+        G4int GetPrescale() const {return fPrescale;}
+        G4bool GetWriteDirection() const {return fWriteDirection;}
+        // records go to ReadoutSimOutputWriter instead of the G4AnalysisManager ntuple
+        G4bool UseAsyncOutput() const {return fBackend == "async";}
+        // track records go to ReadoutSimStreamSender as well
+        G4bool IsStreaming() const {return !fStreamPath.empty();}
+
+        // fileName with the tag before the extension, as the output files of a tagged run
+        static G4String TagFileName(const G4String& fileName, const G4String& tag);
+
     private:
+        void DefineCommands();
+        // unbiased run filling the map the importance sampling learns from
+        void RunPilot(G4int nEvents);
+        // primaries from a vertex file, see ReadoutSimVertexLibrary; empty for the source
+        void SetVertexLibrary(G4String fileName);
+        void SetVertexChunk(G4int nVertices);
+        void SetVertexLoop(G4bool loop);
+        void RewindVertexLibrary();
+        // fileName with the tag of the run before the extension
+        G4String Tagged(const G4String& fileName) const;
+
         Run* fRun;
+
+        G4Timer fTimer;
+        G4double fReferenceRate;  // single-thread photons/s, for the scaling efficiency
+        G4String fTag;            // labels the summary and the output files, see ReadoutSimSweep
+        G4GenericMessenger* fMessenger;
+
+        G4String fFileName;
+        G4bool fWriteRecords;
+        G4String fHistogramFileName;
+        G4bool fWriteHistograms;
+        G4int fPrescale;
+        G4bool fWriteDirection;
+        G4bool fNtupleBooked;
+        G4String fBackend;
+        G4double fMaxFileSize;  // MB, 0 for a single file
+        G4GenericMessenger* fOutputMessenger;
+
+        // light map, see ReadoutSimLightMap
+        G4String fMapMode;
+        G4String fMapFile;
+        G4int fMapXBins;
+        G4int fMapZBins;
+        G4int fMapUBins;
+        G4int fMapVBins;
+        G4GenericMessenger* fMapMessenger;
+
+        // reweighting scan, see ReadoutSimReweighting: lists of values, empty for the nominal one
+        G4String fReweightPMMA;
+        G4String fReweightLAr;
+        G4String fReweightYield;
+        G4GenericMessenger* fReweightMessenger;
+
+        // importance sampling of the primaries, see ReadoutSimImportanceSampler
+        G4String fBiasMode;
+        G4String fBiasFile;
+        G4double fBiasUniformFraction;
+        G4GenericMessenger* fBiasMessenger;
+
+        // extent of the source plane, see ReadoutSimSource
+        G4String fSourceArea;
+        G4GenericMessenger* fSourceMessenger;
+
+        // step profiler, see ReadoutSimStepProfiler
+        G4bool fProfileSteps;
+        G4int fProfileSampleEvery;
+        G4int fProfileRows;
+        G4GenericMessenger* fProfileMessenger;
+
+        // live record stream, see ReadoutSimStreamSender; empty for none
+        G4String fStreamPath;
+        G4GenericMessenger* fStreamMessenger;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,50 @@
+#ifndef ReadoutSimSource_h
+#define ReadoutSimSource_h
+
+#include "G4Types.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <cmath>
+
+// Baseline VUV source: photons start in the LAr just in front of the light
+// guide, uniformly over its face, with the directions pointing towards it.
+// Shared by ReadoutSimPrimaryGenerator and the standalone ray tracer.
+namespace ReadoutSimSource
+{
+    // const G4double energy = 2.88 * eV; // optical photon @ 430nm
+    const G4double energy = 9.69 * eV; // VUV photon @ 128nm
+
+    // source plane y = height, |x| < xHalfWidth, |z| < zHalfWidth
+    const G4double height = 7.1 * cm;
+    const G4double xHalfWidth = 50. * cm;
+    const G4double zHalfWidth = 5. * cm;
+    // the same plane over the whole length of the panel (/RS/source/area panel)
+    const G4double panelZHalfWidth = 150. * cm;
+
+    // position and direction from four uniform numbers in [0, 1)
+    inline void Sample(const G4double rnd[4], G4double position[3], G4double direction[3], G4double zHalfLength = zHalfWidth)
+    {
+        const G4double pi = 3.14159265359;
+
+        position[0] = xHalfWidth * (-1. + 2. * rnd[0]);
+        position[1] = height;
+        position[2] = zHalfLength * (-1. + 2. * rnd[1]);
+
+        G4double u = -1. + 2. * rnd[2];
+        G4double v = pi * (rnd[3] - 0.5);
+
+        direction[0] = std::sqrt(1-u*u) * std::sin(v);
+        direction[1] = -std::sqrt(1-u*u) * std::cos(v);
+        direction[2] = u;
+    }
+
+    // inverse of the direction sampling: u = cos(theta) along z and the
+    // azimuth v in [-pi/2, pi/2], measured from -y towards +x
+    inline void Angles(const G4double direction[3], G4double& u, G4double& v)
+    {
+        u = direction[2];
+        v = std::atan2(direction[0], -direction[1]);
+    }
+}
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef ReadoutSimStackingAction_h
+#define ReadoutSimStackingAction_h
+
+#include "G4UserStackingAction.hh"
+#include "G4GenericMessenger.hh"
+
+class G4StepPoint;
+
+// Early termination of optical photons that cannot be detected.
+//
+// Rules, set with /RS/kill/ and counted by reason in the Run:
+//   enterWorld  kill a photon as soon as it goes into the LAr
+//   minEnergy   kill new photons below an energy (above a wavelength)
+//   escape      kill a photon in the LAr that no longer points to any
+//               volume, at creation and when it goes into the LAr
+// The escape rule does not change the result as long as the LAr only
+// absorbs (no scattering, no re-emission); the others do, compare with
+// them off before using them for production.
+class ReadoutSimStackingAction : public G4UserStackingAction
+{
+    public:
+        ReadoutSimStackingAction();
+        virtual ~ReadoutSimStackingAction();
+
+        virtual G4ClassificationOfNewTrack ClassifyNewTrack(const G4Track*);
+
+        // called by the stepping action for a photon that goes into the
+        // LAr from another volume, true if it should be killed
+        G4bool KillInWorld(const G4StepPoint*) const;
+
+    private:
+        void DefineCommands();
+        void SetMaxWavelength(G4double);
+
+        G4bool fKillEnterWorld;
+        G4double fMinEnergy;
+        G4bool fKillEscape;
+        G4GenericMessenger* fMessenger;
+};
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef ReadoutSimStartup_h
+#define ReadoutSimStartup_h
+
+#include "G4Types.hh"
+
+#include <chrono>
+
+// Wall clock of the job, started at the top of main(): the time to the
+// first run is the startup cost (geometry, physics list, physics tables)
+namespace ReadoutSimStartup
+{
+    inline std::chrono::steady_clock::time_point& GetStart()
+    {
+        static std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        return start;
+    }
+
+    inline void Start() {GetStart() = std::chrono::steady_clock::now();}
+
+    // seconds since Start()
+    inline G4double GetElapsed()
+    {
+        std::chrono::duration<G4double> elapsed = std::chrono::steady_clock::now() - GetStart();
+        return elapsed.count();
+    }
+}
+
+#endif
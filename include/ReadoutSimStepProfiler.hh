@@ -0,0 +1,110 @@
+#ifndef ReadoutSimStepProfiler_h
+#define ReadoutSimStepProfiler_h
+
+#include "globals.hh"
+#include "ReadoutSimVolumeRegistry.hh"
+
+#include <vector>
+
+class G4VProcess;
+
+// Where the steps go: number of steps, tracked length and CPU time per
+// (volume, process that defined the step, boundary status).
+//
+// Every thread fills the profiler of its own run, Run::Merge() adds them
+// up by process name. Counting a step is an increment in a flat table; the
+// thread CPU clock is read only around one step in sampleEvery, and the
+// time of the sampled steps stands for all the steps of their key. A step
+// is timed from the end of the previous stepping action of the same track,
+// or from the start of the track for its first step, so its time includes
+// the navigation, the physics and the user actions. A sample started at the
+// last step of a track goes to the first step of the next track.
+// Switched on with /RS/profile/steps: when off, the stepping action only
+// checks for a null pointer.
+class ReadoutSimStepProfiler
+{
+    public:
+        // boundary statuses above this are counted with the last one
+        static const G4int kMaxStatus = 48;
+
+        // sampleEvery: one timed step in this many, 0 for no timing
+        ReadoutSimStepProfiler(G4int sampleEvery);
+
+        // volume: ReadoutSimVolumeRegistry ID of the pre-step point
+        // status: G4OpBoundaryProcessStatus, NotAtBoundary off the boundaries
+        inline void Fill(G4int volume, const G4VProcess* process, G4int status, G4double length, G4int trackID);
+        // called by the tracking action around the steps of a track
+        inline void StartTrack(G4int trackID);
+        inline void EndTrack();
+        void Add(const ReadoutSimStepProfiler&);
+
+        // the maxRows keys with the most time (or steps without timing)
+        void Print(G4int maxRows) const;
+
+    private:
+        struct Counters
+        {
+            G4long steps = 0;
+            G4double length = 0.;
+            G4double time = 0.;     // s, of the timed steps only
+            G4long timed = 0;
+        };
+
+        static G4double GetThreadTime();
+        G4int AddProcess(const G4VProcess*, const G4String& name);
+        inline G4int GetProcessIndex(const G4VProcess*);
+        void Sample(std::size_t index, G4int trackID);
+
+        G4int fSampleEvery;
+        G4int fCountdown;
+        G4double fStartTime;        // < 0: no step being timed
+        G4int fTimedTrack;
+
+        // processes by first appearance, 0 is "none" (e.g. user limits)
+        std::vector<const G4VProcess*> fProcesses;
+        std::vector<G4String> fProcessNames;
+        const G4VProcess* fLastProcess;
+        G4int fLastProcessIndex;
+
+        // [process][volume][status]
+        std::vector<Counters> fCounters;
+};
+
+inline G4int ReadoutSimStepProfiler::GetProcessIndex(const G4VProcess* process)
+{
+    // consecutive steps mostly end in the same process
+    if (process == fLastProcess) return fLastProcessIndex;
+    G4int index = -1;
+    for (std::size_t i = 0; i < fProcesses.size(); i++)
+        if (fProcesses[i] == process) index = G4int(i);
+    if (index < 0) index = AddProcess(process, "");
+    fLastProcess = process;
+    fLastProcessIndex = index;
+    return index;
+}
+
+inline void ReadoutSimStepProfiler::Fill(G4int volume, const G4VProcess* process, G4int status, G4double length, G4int trackID)
+{
+    if (status < 0 || status >= kMaxStatus) status = kMaxStatus - 1;
+    std::size_t index = (std::size_t(GetProcessIndex(process)) * ReadoutSimVolumeRegistry::kNumberOfVolumes + volume) * kMaxStatus + status;
+    Counters& counters = fCounters[index];
+    counters.steps += 1;
+    counters.length += length;
+
+    if (fSampleEvery > 0 && (fStartTime >= 0. || --fCountdown <= 0)) Sample(index, trackID);
+}
+
+inline void ReadoutSimStepProfiler::StartTrack(G4int trackID)
+{
+    if (fSampleEvery == 0 || fStartTime >= 0. || fCountdown > 0) return;
+    fStartTime = GetThreadTime();
+    fTimedTrack = trackID;
+}
+
+inline void ReadoutSimStepProfiler::EndTrack()
+{
+    // no next step of this track: the countdown stays over for the next track
+    fStartTime = -1.;
+}
+
+#endif
@@ -5,17 +5,36 @@
 #include "G4Types.hh"
 #include "G4SystemOfUnits.hh"
 
+class ReadoutSimEventAction;
+class ReadoutSimStackingAction;
+class ReadoutSimRunAction;
+class ReadoutSimPhotonBiasing;
+class G4OpBoundaryProcess;
+class G4Track;
+class G4StepPoint;
 
 class ReadoutSimSteppingAction : public G4UserSteppingAction
 {
   public:
-    ReadoutSimSteppingAction();
+    ReadoutSimSteppingAction(ReadoutSimEventAction*, const ReadoutSimStackingAction*, const ReadoutSimRunAction*,
+                             const ReadoutSimPhotonBiasing*);
     virtual ~ReadoutSimSteppingAction();
 
     // method from the base class
     virtual void UserSteppingAction(const G4Step*);
 
   private:
+    // credit the detection to the primary the photon descends from
+    void AddDetection(const G4Track*, const G4StepPoint* detectorPoint, G4bool right);
+
+    // for the step profiler: boundary status of a step ending on a boundary
+    G4int GetBoundaryStatus(const G4Step*);
+
+    ReadoutSimEventAction* fEventAction;
+    const ReadoutSimStackingAction* fStackingAction;  // kill rules
+    const ReadoutSimRunAction* fRunAction;            // step profiler of the run
+    const ReadoutSimPhotonBiasing* fBiasing;          // roulette and splitting, owned
+    G4OpBoundaryProcess* fBoundaryProcess;            // of this thread, found at the first profiled step
     G4double trackLength;
 };
 
@@ -0,0 +1,44 @@
+#ifndef ReadoutSimStreamRecord_h
+#define ReadoutSimStreamRecord_h
+
+#include <cstdint>
+
+// Wire format of /RS/stream/, read by monitor/readoutsim_monitor.py.
+//
+// The stream is a sequence of messages in native byte order, each a
+// header followed by count records. Every finished track is one record;
+// the primaries give the source points, the detected photons (primaries
+// or not) carry the source point of their primary, so detected over
+// primaries per source bin is the efficiency, as for the histograms.
+// Sums are over the weights of the records (1 unless the primaries are
+// importance sampled, see ReadoutSimImportanceSampler).
+struct ReadoutSimStreamHeader
+{
+    enum Type { kRecords = 1, kEndOfRun = 2 };
+    static const std::uint32_t kMagic = 0x31535352;  // "RSS1"
+
+    std::uint32_t magic;
+    std::uint32_t type;
+    std::uint32_t runID;
+    std::uint32_t count;
+    std::uint64_t dropped;  // records dropped in this run so far
+};
+
+struct ReadoutSimStreamRecord
+{
+    enum Flags { kPrimary = 1 };
+    static const std::uint16_t kNoChannel = 0xFFFF;
+
+    std::uint8_t fate;      // ReadoutSimPhotonRecord::Fate
+    std::uint8_t flags;
+    std::uint16_t channel;  // readout channel of a detected photon, see ReadoutSimModuleLayout
+    float sourceX;          // cm, source point of the primary
+    float sourceZ;
+    float energy;           // eV, at the end of the track
+    float weight;           // of the photon, inherited from its primary
+};
+
+static_assert(sizeof(ReadoutSimStreamHeader) == 24, "stream header layout");
+static_assert(sizeof(ReadoutSimStreamRecord) == 20, "stream record layout");
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef ReadoutSimStreamSender_h
+#define ReadoutSimStreamSender_h
+
+#include "ReadoutSimStreamRecord.hh"
+#include "ReadoutSimRecordBuffer.hh"
+
+#include "globals.hh"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Sends a record of every finished track to a local consumer while the
+// run goes on, for online monitoring. /RS/stream/path is a Unix domain
+// socket the consumer listens on, or a named pipe it reads.
+//
+// As in ReadoutSimOutputWriter, every thread pushes into its own lock-free
+// ring and a sender thread drains the rings in batches. The socket is
+// non-blocking: when the consumer falls behind, the sender holds the batch
+// it could not send and stops draining, the rings fill up and further
+// records are dropped and counted; a worker never waits. Without a
+// consumer the records are dropped as well, and the sender tries to
+// connect again once a second.
+class ReadoutSimStreamSender
+{
+    public:
+        static ReadoutSimStreamSender* Instance();
+
+        // master thread, at the begin of the run
+        void Open(const G4String& path, G4int runID);
+        // master thread, once all workers have finished the run
+        void Close();
+
+        // any worker thread
+        void Push(const ReadoutSimStreamRecord&);
+
+    private:
+        struct Buffer
+        {
+            Buffer();
+            ReadoutSimRingBuffer<ReadoutSimStreamRecord> ring;
+            std::atomic<long> dropped;
+        };
+
+        ReadoutSimStreamSender();
+        ~ReadoutSimStreamSender();
+
+        Buffer* GetBuffer();
+        void Loop();
+        // records of all the rings, sent (if there is a consumer) or dropped; returns how many
+        std::size_t Drain(G4bool send);
+        // false while the consumer cannot take the pending bytes
+        G4bool Flush();
+        void Queue(ReadoutSimStreamHeader::Type, const ReadoutSimStreamRecord*, std::size_t n);
+        void Connect();
+        void Disconnect();
+        long GetDropped() const;
+
+        std::vector<std::unique_ptr<Buffer> > fBuffers;
+        mutable std::mutex fBuffersMutex;  // workers add their buffers while the sender reads them
+
+        std::thread fThread;
+        std::atomic<bool> fStop;
+
+        G4String fPath;
+        G4int fRunID;
+        int fDescriptor;   // < 0: no consumer
+        G4bool fIsSocket;
+        std::chrono::steady_clock::time_point fLastAttempt;
+
+        // bytes of the last batch not taken by the consumer yet
+        std::vector<char> fPending;
+        std::size_t fPendingOffset;
+        long fPendingRecords;
+
+        long fSent;
+        long fDiscarded;   // dropped by the sender: no consumer, or lost with it
+};
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef ReadoutSimSweep_h
+#define ReadoutSimSweep_h
+
+#include "G4GenericMessenger.hh"
+#include "globals.hh"
+
+#include <vector>
+
+// Design-space scan in one process.
+//
+// /RS/sweep/space, wrap, back, foilThickness and geometry give the values
+// of each parameter, /RS/sweep/run N runs N events for every point of the
+// grid. Every point is set with the usual /RS/guide/ commands, so the
+// detector construction only moves and resizes the volumes that changed,
+// and materials and physics tables are built once for the whole scan.
+// Each point is a run tagged p0, p1, ... (/RS/run/tag): the summary and
+// the output files of the run carry the tag. With /RS/sweep/adaptive the
+// points are run by /RS/adaptive/run instead, each until its own target
+// precision, with the number of events as the limit.
+class ReadoutSimSweep
+{
+    public:
+        ReadoutSimSweep();
+        ~ReadoutSimSweep();
+
+        // a list of values, with an optional unit at the end; also used by /RS/reweight/
+        static std::vector<G4double> ParseValues(const G4String&, const char* defaultUnit);
+
+    private:
+        void DefineCommands();
+
+        // a list of values, lengths with an optional unit at the end
+        void SetSpace(G4String);
+        void SetWrap(G4String);
+        void SetBack(G4String);
+        void SetFoilThickness(G4String);
+        void SetGeometry(G4String);
+        void Clear();
+        void Run(G4int nEvents);
+
+        static std::vector<G4String> ParseWords(const G4String&);
+
+        // empty: the parameter is left as it is
+        std::vector<G4double> fSpace;
+        std::vector<G4double> fWrap;
+        std::vector<G4double> fBack;
+        std::vector<G4double> fFoilThickness;
+        std::vector<G4String> fGeometry;
+        G4bool fAdaptive;
+
+        G4GenericMessenger* fMessenger;
+};
+
+#endif
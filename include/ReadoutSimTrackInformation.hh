@@ -0,0 +1,77 @@
+#ifndef ReadoutSimTrackInformation_h
+#define ReadoutSimTrackInformation_h
+
+#include "G4VUserTrackInformation.hh"
+#include "G4ThreeVector.hh"
+#include "G4ios.hh"
+
+// Carried by every photon and copied to its secondaries (WLS re-emission),
+// so that a detection can be traced back to the primary it descends from.
+class ReadoutSimTrackInformation : public G4VUserTrackInformation
+{
+    public:
+        // materials are told apart by G4Material::GetIndex(), higher indices are not recorded
+        static const G4int kMaxMaterials = 16;
+
+        ReadoutSimTrackInformation(G4int primaryID, const G4ThreeVector& source)
+        : fPrimaryID(primaryID), fSource(source), fDetector(0), fChannel(0), fVolumeBeforeWorld(0),
+          fConversions(0), fConvertedPhotons(0), fSplit(false)
+        {
+            for (G4int i = 0; i < kMaxMaterials; i++) fLength[i] = 0.;
+        }
+        virtual ~ReadoutSimTrackInformation() {}
+
+        G4int GetPrimaryID() const {return fPrimaryID;}
+        // start position of the primary
+        const G4ThreeVector& GetSource() const {return fSource;}
+
+        // ReadoutSimVolumeRegistry ID of the detector that counted this photon, 0 if none
+        void SetDetector(G4int val) {fDetector = val;}
+        G4int GetDetector() const {return fDetector;}
+        // bar of the module it was counted in, see ReadoutSimVolumeRegistry::GetChannel()
+        void SetChannel(G4int val) {fChannel = val;}
+        G4int GetChannel() const {return fChannel;}
+
+        // ReadoutSimVolumeRegistry ID of the last volume this photon left for the LAr, 0 if none
+        void SetVolumeBeforeWorld(G4int val) {fVolumeBeforeWorld = val;}
+        G4int GetVolumeBeforeWorld() const {return fVolumeBeforeWorld;}
+
+        // optical path per material, summed over the photon and its ancestors
+        void AddLength(std::size_t material, G4double length) {if (material < std::size_t(kMaxMaterials)) fLength[material] += length;}
+        G4double GetLength(std::size_t material) const {return material < std::size_t(kMaxMaterials) ? fLength[material] : 0.;}
+
+        // WLS conversions in the ancestry of the photon that emitted a Poisson
+        // number of photons, and the sum of the numbers of photons emitted by
+        // all conversions; a weighted emission adds one photon and no conversion
+        G4int GetConversions() const {return fConversions;}
+        G4int GetConvertedPhotons() const {return fConvertedPhotons;}
+
+        // for a photon re-emitted by the WLS absorption of its parent, together
+        // with nPhotons - 1 others; weighted: the single photon of a weighted emission
+        void InheritConversion(const ReadoutSimTrackInformation& parent, G4int nPhotons, G4bool weighted = false)
+        {
+            for (G4int i = 0; i < kMaxMaterials; i++) fLength[i] = parent.fLength[i];
+            fConversions = parent.fConversions + (weighted ? 0 : 1);
+            fConvertedPhotons = parent.fConvertedPhotons + (weighted ? 1 : nPhotons);
+            fSplit = parent.fSplit;
+        }
+
+        // the photon or one of its ancestors was split, see ReadoutSimPhotonBiasing
+        void SetSplit() {fSplit = true;}
+        G4bool IsSplit() const {return fSplit;}
+
+        virtual void Print() const {G4cout << "Primary track ID " << fPrimaryID << G4endl;}
+
+    private:
+        G4int fPrimaryID;
+        G4ThreeVector fSource;
+        G4int fDetector;
+        G4int fChannel;
+        G4int fVolumeBeforeWorld;
+        G4double fLength[kMaxMaterials];
+        G4int fConversions;
+        G4int fConvertedPhotons;
+        G4bool fSplit;
+};
+
+#endif
@@ -3,16 +3,23 @@
 
 #include "G4UserTrackingAction.hh"
 
+class ReadoutSimRunAction;
+
 class ReadoutSimTrackingAction : public G4UserTrackingAction 
 {
 public:
-  ReadoutSimTrackingAction();
+  ReadoutSimTrackingAction(const ReadoutSimRunAction*);
   virtual ~ReadoutSimTrackingAction(){};
    
   virtual void PreUserTrackingAction(const G4Track*);
   virtual void PostUserTrackingAction(const G4Track*);
 
 private:
+    // ReadoutSimPhotonRecord::Fate of a finished track
+    G4int ClassifyFate(const G4Track*, G4int finalVolume) const;
+
+    const ReadoutSimRunAction* fRunAction;  // output settings
+    G4int fInitialVolume;
     double track_length_g4;
   
 };
@@ -0,0 +1,74 @@
+#ifndef ReadoutSimVertexLibrary_h
+#define ReadoutSimVertexLibrary_h
+
+#include "ReadoutSimVertexRecord.hh"
+
+#include "globals.hh"
+
+#include <atomic>
+#include <cstdint>
+
+// Primary photons read from a file of vertices, e.g. the scintillation of
+// an upstream LAr simulation, instead of sampled from ReadoutSimSource.
+//
+// The file (ReadoutSimVertexRecord.hh) is mapped read-only into memory
+// once for the whole job, so the threads read the records in place from
+// the page cache: no file I/O per event, no parsing, no lock. A generator
+// claims a chunk of consecutive records by adding the chunk size to a
+// shared cursor, and uses it up before it claims the next one. The cursor
+// lives in shared memory, so the processes forked by ReadoutSimProcessPool
+// after the library is opened take their chunks from the same cursor too.
+// Without looping, the run of a thread ends once the library is used up.
+class ReadoutSimVertexLibrary
+{
+    public:
+        static ReadoutSimVertexLibrary* Instance();
+
+        // master thread, between runs; false if the file is not a library
+        G4bool Open(const G4String& fileName);
+        void Close();
+        G4bool IsOpen() const {return fRecords != nullptr;}
+
+        void SetChunkSize(G4int val) {fChunkSize = val > 0 ? std::uint64_t(val) : 1;}
+        void SetLoop(G4bool val) {fLoop = val;}
+        // start again from the first record
+        void Rewind();
+        // in a forked process: the chunks claimed by the parent are not this process's
+        void ForgetChunks() {fProcessGeneration++;}
+
+        // any thread: the records [begin, end) are this caller's; false
+        // once the library is used up. The generation changes with every
+        // Open() and Rewind(), when chunks claimed before are void.
+        G4bool Claim(std::uint64_t& begin, std::uint64_t& end, std::uint64_t& generation);
+        std::uint64_t GetGeneration() const
+        {
+            return fProcessGeneration + (fShared ? fShared->generation.load(std::memory_order_relaxed) : 0);
+        }
+
+        const ReadoutSimVertexRecord& Get(std::uint64_t i) const {return fRecords[i];}
+        std::uint64_t GetNumberOfVertices() const {return fCount;}
+        const G4String& GetFileName() const {return fFileName;}
+
+    private:
+        // in a shared anonymous mapping, so that forked processes see one cursor
+        struct Shared
+        {
+            std::atomic<unsigned long long> cursor;      // first vertex of the next chunk
+            std::atomic<unsigned long long> generation;
+        };
+
+        ReadoutSimVertexLibrary();
+        ~ReadoutSimVertexLibrary();
+
+        G4String fFileName;
+        void* fMapping;
+        std::size_t fMappingSize;
+        const ReadoutSimVertexRecord* fRecords;
+        std::uint64_t fCount;
+        std::uint64_t fChunkSize;
+        G4bool fLoop;
+        Shared* fShared;
+        std::uint64_t fProcessGeneration;
+};
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef ReadoutSimVertexRecord_h
+#define ReadoutSimVertexRecord_h
+
+#include <cstdint>
+
+// File format of /RS/source/library, see ReadoutSimVertexLibrary.
+//
+// A header followed by count records, in native byte order, with nothing
+// in between: the file is mapped and the records are read in place.
+struct ReadoutSimVertexHeader
+{
+    static const std::uint32_t kMagic = 0x31565352;  // "RSV1"
+
+    std::uint32_t magic;
+    std::uint32_t recordSize;  // sizeof(ReadoutSimVertexRecord)
+    std::uint64_t count;
+};
+
+struct ReadoutSimVertexRecord
+{
+    float position[3];   // cm, in the world frame
+    float direction[3];  // need not be normalized
+    float wavelength;    // nm, <= 0 for the energy of ReadoutSimSource
+    float time;          // ns
+};
+
+static_assert(sizeof(ReadoutSimVertexHeader) == 16, "vertex library header layout");
+static_assert(sizeof(ReadoutSimVertexRecord) == 32, "vertex library record layout");
+
+#endif
@@ -0,0 +1,118 @@
+#ifndef ReadoutSimVolumeRegistry_h
+#define ReadoutSimVolumeRegistry_h
+
+#include "globals.hh"
+#include "G4ThreeVector.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4VTouchable.hh"
+#include "ReadoutSimModuleLayout.hh"
+
+#include <cfloat>
+#include <vector>
+
+class G4LogicalVolume;
+
+// Maps the volumes placed by ReadoutSimDetectorConstruction to small integer
+// IDs, so that user actions classify steps with pointer compares instead of
+// volume-name strings. Filled once per Construct() and read-only afterwards.
+class ReadoutSimVolumeRegistry
+{
+    public:
+        enum VolumeID
+        {
+            kUnknownVolume = 0,
+            kOutOfWorld,        // post-step point of a track leaving the world
+            kWorld,
+            kPanel,
+            kPENFoil,
+            kGuide,
+            kRightDetector,
+            kLeftDetector,
+            kNumberOfVolumes
+        };
+
+        static ReadoutSimVolumeRegistry* Instance();
+
+        void Clear();
+        void Register(const G4VPhysicalVolume*, VolumeID);
+
+        inline VolumeID GetID(const G4VPhysicalVolume*) const;
+        inline VolumeID GetID(const G4LogicalVolume*) const;
+
+        static const G4String& GetName(VolumeID);
+
+        // bars and panels of the module, see ReadoutSimModuleLayout
+        void SetModuleLayout(const ReadoutSimModuleLayout& val) {fModule = val;}
+        const ReadoutSimModuleLayout& GetModuleLayout() const {return fModule;}
+        // readout channel of a detector from the copy numbers of its bar
+        // and panel slots, panel * nBars + bar; 0 in the baseline design
+        inline G4int GetChannel(const G4VTouchable* detector) const;
+
+        // axis-aligned box around all the daughters of the world, to be
+        // called once the geometry is placed
+        void ComputeEnvelope(const G4LogicalVolume* world);
+        // false if a photon in the LAr can no longer reach any volume
+        inline G4bool CanReachEnvelope(const G4ThreeVector& position, const G4ThreeVector& direction) const;
+
+    private:
+        ReadoutSimVolumeRegistry() = default;
+
+        std::vector<const G4VPhysicalVolume*> fPhysicalVolumes;
+        std::vector<VolumeID> fPhysicalIDs;
+        // logical volumes shared by several placements map to the first one registered
+        std::vector<const G4LogicalVolume*> fLogicalVolumes;
+        std::vector<VolumeID> fLogicalIDs;
+        ReadoutSimModuleLayout fModule;
+        G4bool fHasEnvelope = false;
+        G4double fEnvelopeMin[3];
+        G4double fEnvelopeMax[3];
+};
+
+// a handful of volumes: a linear scan is faster than any map
+inline ReadoutSimVolumeRegistry::VolumeID ReadoutSimVolumeRegistry::GetID(const G4VPhysicalVolume* volume) const
+{
+    if (!volume) return kOutOfWorld;
+    for (std::size_t i = 0; i < fPhysicalVolumes.size(); i++)
+        if (fPhysicalVolumes[i] == volume) return fPhysicalIDs[i];
+    // other placements of a registered logical volume, e.g. the slots of the module
+    return GetID(volume->GetLogicalVolume());
+}
+
+inline ReadoutSimVolumeRegistry::VolumeID ReadoutSimVolumeRegistry::GetID(const G4LogicalVolume* volume) const
+{
+    for (std::size_t i = 0; i < fLogicalVolumes.size(); i++)
+        if (fLogicalVolumes[i] == volume) return fLogicalIDs[i];
+    return kUnknownVolume;
+}
+
+inline G4int ReadoutSimVolumeRegistry::GetChannel(const G4VTouchable* detector) const
+{
+    // detector > bar slot > module > panel slot, see SetupModuleDesign()
+    if (fModule.IsBaseline()) return 0;
+    return detector->GetCopyNumber(3) * fModule.nBars + detector->GetCopyNumber(1);
+}
+
+// slab test of the ray against the envelope
+inline G4bool ReadoutSimVolumeRegistry::CanReachEnvelope(const G4ThreeVector& position, const G4ThreeVector& direction) const
+{
+    if (!fHasEnvelope) return true;
+    G4double near = 0.;
+    G4double far = DBL_MAX;
+    for (G4int axis = 0; axis < 3; axis++)
+    {
+        G4double p = position[axis];
+        G4double u = direction[axis];
+        if (u == 0.)
+        {
+            if (p < fEnvelopeMin[axis] || p > fEnvelopeMax[axis]) return false;
+            continue;
+        }
+        G4double t1 = (fEnvelopeMin[axis] - p) / u;
+        G4double t2 = (fEnvelopeMax[axis] - p) / u;
+        near = std::max(near, std::min(t1, t2));
+        far = std::min(far, std::max(t1, t2));
+    }
+    return near <= far;
+}
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef ReadoutSimWLSPhysics_h
+#define ReadoutSimWLSPhysics_h
+
+#include "G4VPhysicsConstructor.hh"
+
+// Adds ReadoutSimOpWLS to optical photons. Register it together with
+// G4OpticalPhysics configured without its own WLS process.
+class ReadoutSimWLSPhysics : public G4VPhysicsConstructor
+{
+    public:
+        ReadoutSimWLSPhysics(const G4String& name = "ReadoutSimWLS");
+        virtual ~ReadoutSimWLSPhysics();
+
+        virtual void ConstructParticle();
+        virtual void ConstructProcess();
+};
+
+#endif
@@ -0,0 +1,150 @@
+#ifndef ReadoutSimWLSTables_h
+#define ReadoutSimWLSTables_h
+
+#include "G4Types.hh"
+#include "ReadoutSimAliasTable.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// Constant-time versions of the two table lookups of G4OpWLS, built once
+// from the material property vectors. Used by ReadoutSimOpWLS and by the
+// standalone ray tracer, so that both sample the same spectrum.
+
+// Emission spectrum (WLSCOMPONENT). G4OpWLS integrates the spectrum with the
+// trapezoidal rule and inverts the integral by bisection and linear
+// interpolation. That inverse is linear between consecutive values of the
+// integral, so the emitted energy is uniform on one energy segment per
+// interval between these values: the alias table picks the segment, the
+// rest of the random number the point on it. This gives the G4OpWLS
+// distribution also where the measured spectrum goes negative.
+class ReadoutSimWLSEmission
+{
+    public:
+        // energies ascending, as in the material property vector
+        void Build(const std::vector<G4double>& energy, const std::vector<G4double>& intensity)
+        {
+            fLow.clear();
+            fHigh.clear();
+            fAlias.Build(std::vector<G4double>());
+
+            std::size_t n = energy.size();
+            if (n < 2 || intensity[0] < 0.) return;
+
+            std::vector<G4double> integral(n, 0.);
+            for (std::size_t i = 1; i < n; i++)
+                integral[i] = integral[i-1] + (energy[i] - energy[i-1]) * 0.5 * (intensity[i-1] + intensity[i]);
+            G4double minValue = integral.front();
+            G4double maxValue = integral.back();
+            if (!(maxValue > minValue)) return;
+
+            // random values fall between minValue and maxValue
+            std::vector<G4double> edges;
+            for (G4double value : integral)
+                if (value > minValue && value < maxValue) edges.push_back(value);
+            edges.push_back(minValue);
+            edges.push_back(maxValue);
+            std::sort(edges.begin(), edges.end());
+            edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+            std::vector<G4double> weights;
+            for (std::size_t k = 0; k + 1 < edges.size(); k++)
+            {
+                std::size_t bin = FindValueBin(integral, 0.5 * (edges[k] + edges[k+1]));
+                G4double slope = (energy[bin+1] - energy[bin]) / (integral[bin+1] - integral[bin]);
+                fLow.push_back(energy[bin] + (edges[k] - integral[bin]) * slope);
+                fHigh.push_back(energy[bin] + (edges[k+1] - integral[bin]) * slope);
+                weights.push_back(edges[k+1] - edges[k]);
+            }
+            fAlias.Build(weights);
+        }
+
+        G4bool IsEmpty() const {return fAlias.IsEmpty();}
+
+        // emitted energy for a uniform random number in [0, 1)
+        G4double Sample(G4double rnd) const
+        {
+            G4double fraction;
+            G4int segment = fAlias.Sample(rnd, fraction);
+            return fLow[segment] + fraction * (fHigh[segment] - fLow[segment]);
+        }
+
+    private:
+        // the bisection of G4PhysicsOrderedFreeVector::FindValueBinLocation,
+        // which does not need the integral to be increasing
+        static std::size_t FindValueBin(const std::vector<G4double>& data, G4double value)
+        {
+            std::size_t n1 = 0;
+            std::size_t n2 = data.size() / 2;
+            std::size_t n3 = data.size() - 1;
+            while (n1 != n3 - 1)
+            {
+                if (value > data[n2]) n1 = n2;
+                else n3 = n2;
+                n2 = n1 + (n3 - n1 + 1) / 2;
+            }
+            return n1;
+        }
+
+        ReadoutSimAliasTable fAlias;
+        std::vector<G4double> fLow;
+        std::vector<G4double> fHigh;
+};
+
+// Linearly interpolated table (WLSABSLENGTH) with a uniform energy grid on
+// top: the grid cell gives the first node to look at, so a lookup costs a
+// multiplication and about one comparison instead of a binary search. The
+// values are those of G4PhysicsVector::Value() without spline, constant
+// beyond the first and last node.
+class ReadoutSimGridVector
+{
+    public:
+        void Build(const std::vector<G4double>& energy, const std::vector<G4double>& value)
+        {
+            fEnergy = energy;
+            fValue = value;
+            fFirstNode.clear();
+            if (fEnergy.size() < 2) return;
+
+            // about one node per cell, with cells no larger than the smallest step
+            const std::size_t maxCells = 1 << 16;
+            G4double minStep = fEnergy.back() - fEnergy.front();
+            for (std::size_t i = 1; i < fEnergy.size(); i++)
+                if (fEnergy[i] > fEnergy[i-1]) minStep = std::min(minStep, fEnergy[i] - fEnergy[i-1]);
+            G4double range = fEnergy.back() - fEnergy.front();
+            std::size_t nCells = std::min<std::size_t>(maxCells, std::max<std::size_t>(fEnergy.size(), std::ceil(range / minStep)));
+            fInvCellWidth = nCells / range;
+
+            std::size_t node = 0;
+            for (std::size_t cell = 0; cell < nCells; cell++)
+            {
+                G4double low = fEnergy.front() + cell / fInvCellWidth;
+                while (node + 2 < fEnergy.size() && fEnergy[node+1] <= low) node++;
+                fFirstNode.push_back(G4int(node));
+            }
+        }
+
+        G4bool IsEmpty() const {return fValue.empty();}
+
+        G4double Value(G4double e) const
+        {
+            if (fFirstNode.empty()) return fValue.empty() ? 0. : fValue.front();
+            if (e <= fEnergy.front()) return fValue.front();
+            if (e >= fEnergy.back()) return fValue.back();
+
+            std::size_t cell = std::size_t((e - fEnergy.front()) * fInvCellWidth);
+            if (cell >= fFirstNode.size()) cell = fFirstNode.size() - 1;
+            std::size_t i = fFirstNode[cell];
+            while (e > fEnergy[i+1]) i++;
+            return fValue[i] + (e - fEnergy[i]) * (fValue[i+1] - fValue[i]) / (fEnergy[i+1] - fEnergy[i]);
+        }
+
+    private:
+        std::vector<G4double> fEnergy;
+        std::vector<G4double> fValue;
+        std::vector<G4int> fFirstNode;
+        G4double fInvCellWidth = 0.;
+};
+
+#endif
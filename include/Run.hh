@@ -2,11 +2,25 @@
 #define Run_h
 
 #include "G4Run.hh"
+#include "ReadoutSimImportanceSampler.hh"
+#include "ReadoutSimLightMap.hh"
+#include "ReadoutSimHistogram.hh"
+#include "ReadoutSimReweighting.hh"
+#include "ReadoutSimSource.hh"
+#include "ReadoutSimStepProfiler.hh"
+
+#include <chrono>
+#include <iosfwd>
+#include <vector>
 
 class Run : public G4Run
 {
     public:
-        Run();
+        // reasons for ReadoutSimStackingAction to kill a photon
+        enum KillReason { kKillEnterWorld = 0, kKillBelowEnergy, kKillEscape, kNumberOfKillReasons };
+
+        // sourceZHalfWidth: half length of the source plane along z, for the histograms
+        Run(G4double sourceZHalfWidth = ReadoutSimSource::zHalfWidth);
         ~Run();
 
         void AddToTotal(void) {fTotal += 1;}
@@ -22,23 +36,120 @@ class Run : public G4Run
         void AddPENTowardLAr(void) {fPENTowardLAr += 1;}
         void AddLightGuideTowardLAr(void) {fLightGuideTowardLAr += 1;}
 
+        // once per finished track, fate as in ReadoutSimPhotonRecord::Fate,
+        // volumes as in ReadoutSimVolumeRegistry. The fates, kills, channels
+        // and histograms add up the weight of the photons (1 unless
+        // importance sampled); the numbers of photons and tracks count them.
+        void CountTrack(G4int fate, G4int finalVolume, G4int volumeBeforeWorld, G4double weight = 1.);
+        void AddKill(KillReason reason, G4double weight = 1.) {fKills[reason] += weight;}
+        // Russian roulette played on a photon, and copies made by splitting, see ReadoutSimPhotonBiasing
+        void AddRoulette(G4bool killed) {fRoulettes += 1; if (killed) fRouletteKills += 1;}
+        void AddSplitCopies(G4int n) {fSplitCopies += n;}
+        // steps of a finished track, for the time per step
+        void AddSteps(G4int steps) {fSteps += steps;}
+        // detected photon, by readout channel (bar) of the module
+        void AddChannelDetection(G4int channel, G4bool right, G4double weight = 1.);
+
+        // source position of every primary, and of the primary of every detected photon
+        void FillSource(G4double x, G4double z, G4double weight = 1.);
+        void FillDetection(G4int fate, G4double sourceX, G4double sourceZ, G4double energy, G4double weight = 1.);
+        // master, to a ROOT file
+        G4bool WriteHistograms(const G4String& fileName) const;
+
+        G4long GetNumberOfPhotons() const {return fTotal;}
+        G4double GetRightDetections() const {return fRightDetection;}
+        G4double GetLeftDetections() const {return fLeftDetection;}
+
+        virtual void RecordEvent(const G4Event*);
         virtual void Merge(const G4Run*);
+        // counters and histograms of another run, e.g. a segment of a checkpointed job
+        void Add(const Run&);
+
+        // counters and histograms as text, see ReadoutSimCheckpoint;
+        // Load() fails if the run was saved with another binning or module
+        void Save(std::ostream&) const;
+        G4bool Load(std::istream&);
+
+        // tag: name of the configuration, e.g. the point of a sweep
+        void EndOfRun(const G4String& tag = "");
+        void PrintThroughput(G4double wallTime, G4double referenceRate) const;
+
+        // light map of the run, owned by the run: filled from tracked
+        // photons, or looked up instead of tracking
+        void SetLightMap(ReadoutSimLightMap* map, G4bool lookup);
+        ReadoutSimLightMap* GetLightMap() const {return fLightMap;}
+        G4bool IsFillingLightMap() const {return fLightMap && !fLightMapLookup;}
+        G4bool IsLookingUpLightMap() const {return fLightMap && fLightMapLookup;}
+        // emptyBin: the photon fell into a bin the fill never reached, it counts as not detected
+        void AddLookup(ReadoutSimLightMap::Outcome, G4bool emptyBin);
+        G4long GetEmptyBinLookups() const {return fEmptyBinLookups;}
+
+        // efficiency for other absorption lengths and WLS yields, owned by the run
+        void SetReweighting(ReadoutSimReweighting* val) {delete fReweighting; fReweighting = val;}
+        ReadoutSimReweighting* GetReweighting() const {return fReweighting;}
+        G4double GetSourceZHalfWidth() const {return fSourceZHalfWidth;}
 
-        void EndOfRun();
+        // biased sampling of the primaries, owned by the run; null when off
+        void SetImportanceSampler(ReadoutSimImportanceSampler* val) {delete fImportanceSampler; fImportanceSampler = val;}
+        const ReadoutSimImportanceSampler* GetImportanceSampler() const {return fImportanceSampler;}
+
+        // steps by volume, process and boundary status, owned by the run; null when off
+        void SetStepProfiler(ReadoutSimStepProfiler* val) {delete fStepProfiler; fStepProfiler = val;}
+        ReadoutSimStepProfiler* GetStepProfiler() const {return fStepProfiler;}
+        void PrintLookup(G4double wallTime) const;
 
     private:
-        G4int fTotal;
-        G4int fDetection;
-        G4int fPanelAbsorption;
-        G4int fLightGuideAbsorption;
-        G4int fPenAbsorption;
-        G4int fLArAbsorption;
-        G4int fOuterCladdingAbsorption;
-        G4int fInnerCladdingAbsorption;
-
-        G4int fPanelTowardLAr;
-        G4int fPENTowardLAr;
-        G4int fLightGuideTowardLAr;
+        G4long fTotal;
+        G4long fTracks;
+
+        // sums of weights
+        G4double fDetection;
+        G4double fPanelAbsorption;
+        G4double fLightGuideAbsorption;
+        G4double fPenAbsorption;
+        G4double fLArAbsorption;
+        G4double fOuterCladdingAbsorption;
+        G4double fInnerCladdingAbsorption;
+        G4double fRightDetection;
+        G4double fLeftDetection;
+        G4double fWLSAbsorption;
+        G4double fEscaped;
+        G4double fKilled;
+        G4double fTrackWeights;
+        G4double fDetectionSquares;  // squared weights of the detected photons
+
+        G4double fPanelTowardLAr;
+        G4double fPENTowardLAr;
+        G4double fLightGuideTowardLAr;
+
+        G4double fKills[kNumberOfKillReasons];
+        G4long fRoulettes;
+        G4long fRouletteKills;
+        G4long fSplitCopies;
+        G4long fSteps;
+        std::vector<G4double> fChannelDetections;  // right and left per channel
+
+        // in cm and eV
+        ReadoutSimHistogram fSourceXZ;
+        ReadoutSimHistogram fDetectedXZ;
+        ReadoutSimHistogram fDetectedRightX;
+        ReadoutSimHistogram fDetectedLeftX;
+        ReadoutSimHistogram fArrivalEnergy;
+
+        ReadoutSimLightMap* fLightMap;
+        G4bool fLightMapLookup;
+        G4long fLookups[4];  // per ReadoutSimLightMap::Outcome
+        G4long fEmptyBinLookups;
+
+        ReadoutSimReweighting* fReweighting;
+        ReadoutSimStepProfiler* fStepProfiler;
+        ReadoutSimImportanceSampler* fImportanceSampler;
+        G4double fSourceZHalfWidth;
+
+        // busy time of the worker runs merged into this one
+        std::chrono::steady_clock::time_point fStartTime;
+        G4double fWorkerTime;
+        G4int fNumberOfWorkers;
 };
 
 #endif 
\ No newline at end of file
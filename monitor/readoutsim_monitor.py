@@ -0,0 +1,242 @@
+#!/usr/bin/env python3
+"""Live efficiency monitor for the ReadoutSim record stream.
+
+Listens on a Unix domain socket (or reads a named pipe) that ReadoutSim
+sends one record per finished track to (/RS/stream/path), and prints the
+detection efficiency while the job runs: overall, right and left, per
+readout channel and as a histogram of the source x of the primaries.
+
+    readoutsim_monitor.py /tmp/readout.sock
+    ReadoutSim job.mac          # with /RS/stream/path /tmp/readout.sock
+
+    readoutsim_monitor.py --fifo /tmp/readout.fifo --json live.json
+
+Several jobs (e.g. the processes of ReadoutSim -f N) can send to the same
+socket at once; their records are added up. The wire format is defined in
+include/ReadoutSimStreamRecord.hh.
+"""
+
+import argparse
+import json
+import os
+import selectors
+import socket
+import stat
+import struct
+import sys
+import time
+
+HEADER = struct.Struct("=IIIIQ")      # magic, type, runID, count, dropped
+RECORD = struct.Struct("=BBHffff")    # fate, flags, channel, sourceX, sourceZ, energy, weight
+MAGIC = 0x31535352
+RECORDS, END_OF_RUN = 1, 2
+PRIMARY = 1
+NO_CHANNEL = 0xFFFF
+
+# ReadoutSimPhotonRecord::Fate
+FATES = ["unknown", "detectedRight", "detectedLeft", "absorbed", "wlsAbsorbed", "escaped", "killed"]
+DETECTED_RIGHT, DETECTED_LEFT = 1, 2
+
+
+class Monitor:
+    def __init__(self, bins, x_range):
+        self.bins = bins
+        self.x_range = x_range
+        # sums of weights, except for the numbers of records and primaries
+        self.primaries = [0.] * bins
+        self.detected = [0.] * bins
+        self.right = 0.
+        self.left = 0.
+        self.n_primaries = 0
+        self.fates = [0.] * len(FATES)
+        self.channels = {}
+        self.records = 0
+        self.dropped = {}    # (connection, run) -> dropped so far
+        self.runs_done = 0
+        self.start = time.monotonic()
+
+    def bin(self, x):
+        i = int((x + self.x_range) / (2. * self.x_range) * self.bins)
+        return min(max(i, 0), self.bins - 1)
+
+    def add(self, payload, count):
+        for fate, flags, channel, source_x, _source_z, _energy, weight in RECORD.iter_unpack(payload[:count * RECORD.size]):
+            self.fates[fate if fate < len(FATES) else 0] += weight
+            if flags & PRIMARY:
+                # the overall efficiency is per generated photon, the one
+                # per bin per weighted primary, as detectedXZ / sourceXZ
+                self.n_primaries += 1
+                self.primaries[self.bin(source_x)] += weight
+            if fate in (DETECTED_RIGHT, DETECTED_LEFT):
+                if fate == DETECTED_RIGHT:
+                    self.right += weight
+                else:
+                    self.left += weight
+                self.detected[self.bin(source_x)] += weight
+                if channel != NO_CHANNEL:
+                    self.channels[channel] = self.channels.get(channel, 0.) + weight
+        self.records += count
+
+    def summary(self):
+        n = max(self.n_primaries, 1)
+        return {
+            "elapsed_s": time.monotonic() - self.start,
+            "records": self.records,
+            "dropped": sum(self.dropped.values()),
+            "runs_done": self.runs_done,
+            "primaries": self.n_primaries,
+            "efficiency": (self.right + self.left) / n,
+            "efficiency_right": self.right / n,
+            "efficiency_left": self.left / n,
+            "fates": dict(zip(FATES, self.fates)),
+            "channels": {str(c): d / n for c, d in sorted(self.channels.items())},
+            "source_x_cm": [-self.x_range + (i + 0.5) * 2. * self.x_range / self.bins for i in range(self.bins)],
+            "efficiency_vs_x": [d / p if p else None for d, p in zip(self.detected, self.primaries)],
+        }
+
+    def print_report(self):
+        s = self.summary()
+        print("\n[%7.1f s] records %d (%.0f/s), dropped %d, runs done %d"
+              % (s["elapsed_s"], s["records"], s["records"] / max(s["elapsed_s"], 1e-9), s["dropped"], s["runs_done"]))
+        if not self.n_primaries:
+            print("  no primaries yet")
+            return
+        print("  primaries %d, detected %.3f %% (right %.3f %%, left %.3f %%)"
+              % (self.n_primaries, 100 * s["efficiency"], 100 * s["efficiency_right"], 100 * s["efficiency_left"]))
+        if len(self.channels) > 1:
+            print("  per channel [%]: " + " ".join("%s:%.2f" % (c, 100 * e) for c, e in s["channels"].items()))
+        top = max((e for e in s["efficiency_vs_x"] if e is not None), default=0.) or 1.
+        print("  source x [cm]   efficiency")
+        for x, e in zip(s["source_x_cm"], s["efficiency_vs_x"]):
+            bar = "" if e is None else "#" * int(round(40 * e / top))
+            value = "      -" if e is None else "%6.3f%%" % (100 * e)
+            print("  %8.1f     %s %s" % (x, value, bar))
+        sys.stdout.flush()
+
+
+class Connection:
+    def __init__(self, stream, name):
+        self.stream = stream
+        self.name = name
+        self.data = bytearray()
+
+    def fileno(self):
+        return self.stream.fileno()
+
+    def read(self):
+        try:
+            chunk = os.read(self.stream.fileno(), 1 << 20)
+        except BlockingIOError:
+            return True
+        if not chunk:
+            return False
+        self.data += chunk
+        return True
+
+    def messages(self):
+        while len(self.data) >= HEADER.size:
+            magic, kind, run, count, dropped = HEADER.unpack_from(self.data)
+            if magic != MAGIC:
+                raise ValueError("%s: not a ReadoutSim stream" % self.name)
+            size = HEADER.size + count * RECORD.size
+            if len(self.data) < size:
+                return
+            payload = bytes(self.data[HEADER.size:size])
+            del self.data[:size]
+            yield kind, run, count, dropped, payload
+
+
+def open_source(path, fifo):
+    if fifo:
+        if not os.path.exists(path):
+            os.mkfifo(path)
+        elif not stat.S_ISFIFO(os.stat(path).st_mode):
+            sys.exit("%s exists and is not a named pipe" % path)
+        return None
+    if os.path.exists(path):
+        # left over from a monitor that did not stop cleanly
+        if not stat.S_ISSOCK(os.stat(path).st_mode):
+            sys.exit("%s exists and is not a socket" % path)
+        os.unlink(path)
+    server = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    server.bind(path)
+    server.listen(64)
+    server.setblocking(False)
+    return server
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("path", help="socket to listen on (or named pipe with --fifo)")
+    parser.add_argument("--fifo", action="store_true", help="read a named pipe instead of listening on a socket")
+    parser.add_argument("--interval", type=float, default=2., help="seconds between reports (default 2)")
+    parser.add_argument("--bins", type=int, default=20, help="bins in source x (default 20)")
+    parser.add_argument("--x-range", type=float, default=50., help="half range of source x in cm (default 50)")
+    parser.add_argument("--json", help="also write the latest report to this file")
+    parser.add_argument("--slow", type=float, default=0., help="sleep this long per message, to try the backpressure")
+    parser.add_argument("--exit-after-runs", type=int, default=0, help="stop after this many end-of-run messages")
+    args = parser.parse_args()
+
+    monitor = Monitor(args.bins, args.x_range)
+    server = open_source(args.path, args.fifo)
+    selector = selectors.DefaultSelector()
+    if server:
+        selector.register(server, selectors.EVENT_READ, None)
+    fifo = None
+
+    def report():
+        monitor.print_report()
+        if args.json:
+            with open(args.json + ".tmp", "w") as out:
+                json.dump(monitor.summary(), out, indent=1)
+            os.replace(args.json + ".tmp", args.json)
+
+    next_report = time.monotonic() + args.interval
+    try:
+        while True:
+            if args.fifo and fifo is None:
+                # blocks until ReadoutSim opens the pipe for writing
+                fd = os.open(args.path, os.O_RDONLY)
+                fifo = Connection(os.fdopen(fd, "rb", buffering=0), args.path)
+                selector.register(fifo, selectors.EVENT_READ, fifo)
+
+            timeout = max(0., next_report - time.monotonic())
+            for key, _ in selector.select(timeout):
+                if key.data is None:
+                    stream, _ = server.accept()
+                    stream.setblocking(False)
+                    connection = Connection(stream, "connection %d" % stream.fileno())
+                    selector.register(connection, selectors.EVENT_READ, connection)
+                    continue
+                connection = key.data
+                alive = connection.read()
+                for kind, run, count, dropped, payload in connection.messages():
+                    monitor.dropped[(id(connection), run)] = dropped
+                    if kind == RECORDS:
+                        monitor.add(payload, count)
+                    elif kind == END_OF_RUN:
+                        monitor.runs_done += 1
+                        report()
+                    if args.slow:
+                        time.sleep(args.slow)
+                if not alive:
+                    selector.unregister(connection)
+                    connection.stream.close()
+                    if connection is fifo:
+                        fifo = None
+            if args.exit_after_runs and monitor.runs_done >= args.exit_after_runs:
+                break
+            if time.monotonic() >= next_report:
+                report()
+                next_report = time.monotonic() + args.interval
+    except KeyboardInterrupt:
+        pass
+    finally:
+        report()
+        if server:
+            server.close()
+            os.unlink(args.path)
+
+
+if __name__ == "__main__":
+    main()
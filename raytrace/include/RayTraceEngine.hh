@@ -0,0 +1,63 @@
+#ifndef RayTraceEngine_h
+#define RayTraceEngine_h
+
+#include "RayTraceScene.hh"
+#include "RayTraceTally.hh"
+
+#include <cstdint>
+#include <vector>
+
+// Traces batches of optical photons through a RayTraceScene.
+//
+// Photons of a batch are stored as structure of arrays. Each step runs two
+// loops over the whole batch that the compiler vectorizes (distance to the
+// next box face, sampled absorption length), then a scalar pass that applies
+// the outcome: absorption and WLS re-emission, detection, Fresnel reflection
+// or refraction. Finished photons are removed and re-emitted ones appended
+// until the batch is empty.
+//
+// Every primary draws from its own counter-based random stream, derived from
+// the seed and its index, so results do not depend on batching or threads.
+class RayTraceEngine
+{
+    public:
+        RayTraceEngine(const RayTraceScene&, std::uint64_t seed);
+
+        // trace primaries first .. first+n-1 and add their fates to the tally
+        void Trace(std::uint64_t first, G4int n, RayTraceTally&);
+
+        void SetMaxSteps(G4int val) {fMaxSteps = val;}
+
+    private:
+        void AddPhoton(const G4double position[3], const G4double direction[3], G4double energy,
+                       G4int volume, std::uint64_t rng);
+        void ComputeDistances();
+        void Resolve(RayTraceTally&);
+        void Compact();
+
+        void Absorb(std::size_t, RayTraceTally&);
+        void CrossBoundary(std::size_t, RayTraceTally&);
+
+        const RayTraceScene& fScene;
+        std::uint64_t fSeed;
+        G4int fMaxSteps;
+
+        // batch, one entry per photon in flight
+        std::vector<G4double> fX, fY, fZ;
+        std::vector<G4double> fUx, fUy, fUz;
+        std::vector<G4double> fInvUx, fInvUy, fInvUz;
+        std::vector<G4double> fEnergy;
+        std::vector<G4double> fInvWLSLength;   // 1/WLSABSLENGTH at the photon energy
+        std::vector<G4double> fBoundary;       // distance to the next box face
+        std::vector<G4double> fAbsorption;     // sampled absorption length
+        std::vector<std::uint64_t> fRng;
+        std::vector<G4int> fVolume;
+        std::vector<G4int> fHitBox;            // box owning the next face
+        std::vector<G4int> fFrom;              // volume left when entering the LAr
+        std::vector<G4int> fSteps;
+        std::vector<char> fAlive;
+        std::size_t fSize;
+        std::size_t fActive;                   // photons the current step applies to
+};
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef RayTraceScene_h
+#define RayTraceScene_h
+
+#include "G4Types.hh"
+#include "ReadoutSimWLSTables.hh"
+
+// Geometry and materials of the baseline design as seen by the ray tracer.
+// Boxes come from ReadoutSimBaselineLayout and optical properties from
+// ReadoutSimOpticalTables, the same sources the Geant4 application uses.
+class RayTraceScene
+{
+    public:
+        enum Volume { kOutside = -1, kWorld = 0, kPanel, kPEN, kGuide, kRightDetector, kLeftDetector, kNumberOfVolumes };
+
+        // same meaning as the /RS/guide/ commands
+        RayTraceScene(G4int spaceGuide, G4int WLSBack, G4int WLSWrap = 1);
+
+        // innermost volume containing the point
+        G4int Locate(G4double x, G4double y, G4double z) const;
+
+        static const char* GetName(G4int volume);
+
+        G4double GetWLSAbsorptionLength(G4double energy) const {return fWLSAbsLength.Value(energy);}
+        // energy of a re-emitted photon, rnd uniform in [0, 1)
+        G4double SampleWLSEnergy(G4double rnd) const {return fWLSEmission.Sample(rnd);}
+
+        // box bounds, indexed by Volume
+        G4double lo[kNumberOfVolumes][3];
+        G4double hi[kNumberOfVolumes][3];
+
+        G4double rindex[kNumberOfVolumes];
+        G4double invAbsLength[kNumberOfVolumes];   // bulk absorption, 0 if none
+        G4bool wls[kNumberOfVolumes];
+        G4double wlsMeanNumberPhotons;
+
+    private:
+        // the tables of ReadoutSimOpWLS
+        ReadoutSimGridVector fWLSAbsLength;
+        ReadoutSimWLSEmission fWLSEmission;
+};
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef RayTraceTally_h
+#define RayTraceTally_h
+
+#include "RayTraceScene.hh"
+
+#include <cstdint>
+#include <ostream>
+
+// Photon fates, counted per thread and summed at the end
+struct RayTraceTally
+{
+    RayTraceTally();
+
+    void Add(const RayTraceTally&);
+
+    // same summary as Run::EndOfRun, fractions of the generated photons
+    void Print(std::ostream&) const;
+
+    std::uint64_t primaries;
+    std::uint64_t tracks;          // primaries and re-emitted photons
+    std::uint64_t steps;
+    std::uint64_t detectedRight;
+    std::uint64_t detectedLeft;
+    std::uint64_t absorbed[RayTraceScene::kNumberOfVolumes];
+    std::uint64_t towardLAr[RayTraceScene::kNumberOfVolumes];  // by the volume left before the LAr absorption
+    std::uint64_t escaped;         // left the world volume
+    std::uint64_t lost;            // stopped by the step limit
+};
+
+#endif
@@ -0,0 +1,361 @@
+#include "RayTraceEngine.hh"
+
+#include "ReadoutSimSource.hh"
+
+#include "G4PhysicalConstants.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+    const G4double kInfinity = std::numeric_limits<G4double>::infinity();
+    // faces closer than this are the one the photon sits on
+    const G4double kTolerance = 1e-9*mm;
+    // step across a face before looking up the next volume
+    const G4double kNudge = 1e-6*mm;
+
+    // SplitMix64: small state, good enough statistics, and cheap to vectorize
+    inline std::uint64_t NextRandom(std::uint64_t& state)
+    {
+        std::uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    // uniform in [0, 1), like G4UniformRand
+    inline G4double Flat(std::uint64_t& state)
+    {
+        return G4double(NextRandom(state) >> 11) * (1. / 9007199254740992.);
+    }
+
+    // uniform in (0, 1], safe for logarithms
+    inline G4double Uniform(std::uint64_t& state)
+    {
+        return 1. - Flat(state);
+    }
+
+    G4int Poisson(G4double mean, std::uint64_t& state)
+    {
+        G4double limit = std::exp(-mean);
+        G4int n = 0;
+        G4double p = Uniform(state);
+        while (p > limit)
+        {
+            n++;
+            p *= Uniform(state);
+        }
+        return n;
+    }
+}
+
+RayTraceEngine::RayTraceEngine(const RayTraceScene& scene, std::uint64_t seed)
+: fScene(scene)
+{
+    fSeed = seed;
+    fMaxSteps = 100000;
+    fSize = 0;
+    fActive = 0;
+}
+
+void RayTraceEngine::AddPhoton(const G4double position[3], const G4double direction[3], G4double energy,
+                               G4int volume, std::uint64_t rng)
+{
+    if (fX.size() <= fSize)
+    {
+        std::size_t capacity = std::max<std::size_t>(1024, 2 * fX.size());
+        for (auto* v : {&fX, &fY, &fZ, &fUx, &fUy, &fUz, &fInvUx, &fInvUy, &fInvUz, &fEnergy, &fInvWLSLength, &fBoundary, &fAbsorption}) v->resize(capacity);
+        for (auto* v : {&fVolume, &fHitBox, &fFrom, &fSteps}) v->resize(capacity);
+        fRng.resize(capacity);
+        fAlive.resize(capacity);
+    }
+
+    std::size_t i = fSize++;
+    fX[i] = position[0];
+    fY[i] = position[1];
+    fZ[i] = position[2];
+    fUx[i] = direction[0];
+    fUy[i] = direction[1];
+    fUz[i] = direction[2];
+    fEnergy[i] = energy;
+    fInvWLSLength[i] = 1. / fScene.GetWLSAbsorptionLength(energy);
+    fRng[i] = rng;
+    fVolume[i] = volume;
+    fFrom[i] = volume;
+    fSteps[i] = 0;
+    fAlive[i] = 1;
+}
+
+void RayTraceEngine::Trace(std::uint64_t first, G4int n, RayTraceTally& tally)
+{
+    fSize = 0;
+    for (G4int k = 0; k < n; k++)
+    {
+        // independent stream per primary
+        std::uint64_t rng = fSeed ^ ((first + k) * 0xD1B54A32D192ED03ULL);
+        NextRandom(rng);
+
+        G4double rnd[4], position[3], direction[3];
+        for (G4int j = 0; j < 4; j++) rnd[j] = Flat(rng);
+        ReadoutSimSource::Sample(rnd, position, direction);
+        AddPhoton(position, direction, ReadoutSimSource::energy, fScene.Locate(position[0], position[1], position[2]), rng);
+    }
+    tally.primaries += n;
+    tally.tracks += n;
+
+    while (fSize > 0)
+    {
+        fActive = fSize;
+        ComputeDistances();
+        Resolve(tally);
+        Compact();
+    }
+}
+
+void RayTraceEngine::ComputeDistances()
+{
+    const std::size_t n = fActive;
+    G4double* __restrict x = fX.data();
+    G4double* __restrict y = fY.data();
+    G4double* __restrict z = fZ.data();
+    G4double* __restrict ux = fUx.data();
+    G4double* __restrict uy = fUy.data();
+    G4double* __restrict uz = fUz.data();
+    G4double* __restrict ix = fInvUx.data();
+    G4double* __restrict iy = fInvUy.data();
+    G4double* __restrict iz = fInvUz.data();
+    G4double* __restrict boundary = fBoundary.data();
+    G4int* __restrict hitBox = fHitBox.data();
+
+    #pragma omp simd
+    for (std::size_t i = 0; i < n; i++)
+    {
+        // a zero component gives huge, finite slab distances instead of 0*inf
+        ix[i] = 1. / (ux[i] != 0. ? ux[i] : 1e-300);
+        iy[i] = 1. / (uy[i] != 0. ? uy[i] : 1e-300);
+        iz[i] = 1. / (uz[i] != 0. ? uz[i] : 1e-300);
+        boundary[i] = kInfinity;
+        hitBox[i] = RayTraceScene::kWorld;
+    }
+
+    // slab test against every box: the photon either enters a box it is not
+    // in, or leaves the ones it is in; the nearest of these is the next face
+    for (G4int box = 0; box < RayTraceScene::kNumberOfVolumes; box++)
+    {
+        const G4double lx = fScene.lo[box][0], ly = fScene.lo[box][1], lz = fScene.lo[box][2];
+        const G4double hx = fScene.hi[box][0], hy = fScene.hi[box][1], hz = fScene.hi[box][2];
+
+        // written without branches so that it vectorizes
+        #pragma omp simd
+        for (std::size_t i = 0; i < n; i++)
+        {
+            G4double tx1 = (lx - x[i]) * ix[i], tx2 = (hx - x[i]) * ix[i];
+            G4double ty1 = (ly - y[i]) * iy[i], ty2 = (hy - y[i]) * iy[i];
+            G4double tz1 = (lz - z[i]) * iz[i], tz2 = (hz - z[i]) * iz[i];
+
+            G4double tmin = std::max(std::max(std::min(tx1, tx2), std::min(ty1, ty2)), std::min(tz1, tz2));
+            G4double tmax = std::min(std::min(std::max(tx1, tx2), std::max(ty1, ty2)), std::max(tz1, tz2));
+
+            G4double t = tmin > kTolerance ? tmin : tmax;
+            t = (tmin > tmax || t <= kTolerance) ? kInfinity : t;
+            G4bool closer = t < boundary[i];
+            boundary[i] = closer ? t : boundary[i];
+            hitBox[i] = closer ? box : hitBox[i];
+        }
+    }
+
+    // absorption length for this step: bulk, plus WLS in the foil
+    G4double* __restrict absorption = fAbsorption.data();
+    const G4double* __restrict invWLS = fInvWLSLength.data();
+    const G4int* __restrict volume = fVolume.data();
+    std::uint64_t* __restrict rng = fRng.data();
+    G4double invAbs[RayTraceScene::kNumberOfVolumes], isWLS[RayTraceScene::kNumberOfVolumes];
+    for (G4int v = 0; v < RayTraceScene::kNumberOfVolumes; v++)
+    {
+        invAbs[v] = fScene.invAbsLength[v];
+        isWLS[v] = fScene.wls[v] ? 1. : 0.;
+    }
+
+    #pragma omp simd
+    for (std::size_t i = 0; i < n; i++)
+    {
+        G4double invLength = invAbs[volume[i]] + isWLS[volume[i]] * invWLS[i];
+        G4double u = Uniform(rng[i]);
+        absorption[i] = invLength > 0. ? -std::log(u) / invLength : kInfinity;
+    }
+}
+
+void RayTraceEngine::Resolve(RayTraceTally& tally)
+{
+    for (std::size_t i = 0; i < fActive; i++)
+    {
+        tally.steps++;
+        if (++fSteps[i] > fMaxSteps)
+        {
+            tally.lost++;
+            fAlive[i] = 0;
+        }
+        else if (fAbsorption[i] < fBoundary[i]) Absorb(i, tally);
+        else if (fBoundary[i] == kInfinity)
+        {
+            tally.escaped++;
+            fAlive[i] = 0;
+        }
+        else CrossBoundary(i, tally);
+    }
+}
+
+void RayTraceEngine::Absorb(std::size_t i, RayTraceTally& tally)
+{
+    G4double d = fAbsorption[i];
+    G4double position[3] = {fX[i] + d * fUx[i], fY[i] + d * fUy[i], fZ[i] + d * fUz[i]};
+    G4int volume = fVolume[i];
+
+    tally.absorbed[volume]++;
+    if (volume == RayTraceScene::kWorld) tally.towardLAr[fFrom[i]]++;
+    fAlive[i] = 0;
+
+    // no bulk absorption in the foil: every absorption there is WLS
+    G4double invBulk = fScene.invAbsLength[volume];
+    if (!fScene.wls[volume]) return;
+    if (invBulk > 0. && Flat(fRng[i]) * (invBulk + fInvWLSLength[i]) < invBulk) return;
+
+    // G4OpWLS: Poisson number of photons, isotropic, energies from the
+    // emission spectrum below the absorbed energy
+    G4int nPhotons = Poisson(fScene.wlsMeanNumberPhotons, fRng[i]);
+    for (G4int k = 0; k < nPhotons; k++)
+    {
+        G4double energy = 0.;
+        for (G4int j = 0; j < 100; j++)
+        {
+            energy = fScene.SampleWLSEnergy(Flat(fRng[i]));
+            if (energy <= fEnergy[i]) break;
+        }
+        if (energy > fEnergy[i]) continue;
+
+        G4double cost = 1. - 2. * Flat(fRng[i]);
+        G4double sint = std::sqrt((1. - cost) * (1. + cost));
+        G4double phi = twopi * Flat(fRng[i]);
+        G4double direction[3] = {sint * std::cos(phi), sint * std::sin(phi), cost};
+
+        std::uint64_t rng = NextRandom(fRng[i]);
+        AddPhoton(position, direction, energy, volume, rng);
+        tally.tracks++;
+    }
+}
+
+void RayTraceEngine::CrossBoundary(std::size_t i, RayTraceTally& tally)
+{
+    G4double d = fBoundary[i];
+    G4double p[3] = {fX[i] + d * fUx[i], fY[i] + d * fUy[i], fZ[i] + d * fUz[i]};
+    G4double u[3] = {fUx[i], fUy[i], fUz[i]};
+    fX[i] = p[0];
+    fY[i] = p[1];
+    fZ[i] = p[2];
+
+    G4int current = fVolume[i];
+    G4int next = fScene.Locate(p[0] + kNudge * u[0], p[1] + kNudge * u[1], p[2] + kNudge * u[2]);
+
+    if (next == RayTraceScene::kOutside)
+    {
+        tally.escaped++;
+        fAlive[i] = 0;
+        return;
+    }
+
+    // same rule as ReadoutSimSteppingAction: from the guide into a detector
+    if (current == RayTraceScene::kGuide && next == RayTraceScene::kRightDetector)
+    {
+        tally.detectedRight++;
+        fAlive[i] = 0;
+        return;
+    }
+    if (current == RayTraceScene::kGuide && next == RayTraceScene::kLeftDetector)
+    {
+        tally.detectedLeft++;
+        fAlive[i] = 0;
+        return;
+    }
+
+    G4double n1 = fScene.rindex[current];
+    G4double n2 = fScene.rindex[next];
+    G4bool transmit = true;
+
+    if (n1 != n2)
+    {
+        // the face normal is along the axis where the point is closest to the box
+        const G4int box = fHitBox[i];
+        G4int axis = 0;
+        G4double closest = kInfinity;
+        for (G4int a = 0; a < 3; a++)
+        {
+            G4double distance = std::min(std::fabs(p[a] - fScene.lo[box][a]), std::fabs(p[a] - fScene.hi[box][a]));
+            if (distance < closest)
+            {
+                closest = distance;
+                axis = a;
+            }
+        }
+
+        // Fresnel coefficients averaged over the two polarizations
+        G4double cos1 = std::fabs(u[axis]);
+        G4double ratio = n1 / n2;
+        G4double sin2Squared = ratio * ratio * (1. - cos1 * cos1);
+        if (sin2Squared >= 1.) transmit = false;
+        else
+        {
+            G4double cos2 = std::sqrt(1. - sin2Squared);
+            G4double rs = (n1 * cos1 - n2 * cos2) / (n1 * cos1 + n2 * cos2);
+            G4double rp = (n1 * cos2 - n2 * cos1) / (n1 * cos2 + n2 * cos1);
+            G4double reflectivity = 0.5 * (rs * rs + rp * rp);
+            if (Flat(fRng[i]) < reflectivity) transmit = false;
+            else
+            {
+                for (G4int a = 0; a < 3; a++) if (a != axis) u[a] *= ratio;
+                u[axis] = u[axis] > 0. ? cos2 : -cos2;
+            }
+        }
+        if (!transmit) u[axis] = -u[axis];
+
+        fUx[i] = u[0];
+        fUy[i] = u[1];
+        fUz[i] = u[2];
+    }
+
+    if (transmit)
+    {
+        if (next == RayTraceScene::kWorld) fFrom[i] = current;
+        fVolume[i] = next;
+    }
+}
+
+void RayTraceEngine::Compact()
+{
+    // keep the photons still in flight, then the re-emitted ones added after them
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < fSize; i++)
+    {
+        if (i < fActive && !fAlive[i]) continue;
+        if (kept != i)
+        {
+            fX[kept] = fX[i];
+            fY[kept] = fY[i];
+            fZ[kept] = fZ[i];
+            fUx[kept] = fUx[i];
+            fUy[kept] = fUy[i];
+            fUz[kept] = fUz[i];
+            fEnergy[kept] = fEnergy[i];
+            fInvWLSLength[kept] = fInvWLSLength[i];
+            fRng[kept] = fRng[i];
+            fVolume[kept] = fVolume[i];
+            fFrom[kept] = fFrom[i];
+            fSteps[kept] = fSteps[i];
+            fAlive[kept] = 1;
+        }
+        kept++;
+    }
+    fSize = kept;
+}
@@ -0,0 +1,68 @@
+#include "RayTraceScene.hh"
+
+#include "ReadoutSimBaselineLayout.hh"
+#include "ReadoutSimOpticalTables.hh"
+
+RayTraceScene::RayTraceScene(G4int spaceGuide, G4int WLSBack, G4int WLSWrap)
+{
+    using namespace ReadoutSimOpticalTables;
+
+    // same defaults and switches as ReadoutSimDetectorConstruction
+    G4double space = spaceGuide == 1 ? 2.*cm : 0.*cm;
+    G4int WLS_y = WLSBack == 1 ? 2 : 1;
+    G4int centerGuide = WLSBack == 1 ? 0 : 1;
+    // without wrapping the PEN box is a PMMA box of the guide size
+    G4double layerThickness = WLSWrap == 1 ? 0.005*cm : 0.*cm;
+
+    ReadoutSimBaselineLayout layout = ReadoutSimBaselineLayout::Compute(space, layerThickness, WLS_y, centerGuide);
+    const ReadoutSimBox* boxes[kNumberOfVolumes] = {
+        &layout.world, &layout.panel, &layout.pen, &layout.guide, &layout.rightDetector, &layout.leftDetector};
+
+    for (G4int volume = 0; volume < kNumberOfVolumes; volume++)
+    {
+        for (G4int axis = 0; axis < 3; axis++)
+        {
+            lo[volume][axis] = boxes[volume]->center[axis] - boxes[volume]->halfLength[axis];
+            hi[volume][axis] = boxes[volume]->center[axis] + boxes[volume]->halfLength[axis];
+        }
+        wls[volume] = false;
+    }
+
+    // the detectors are PMMA, like the guide
+    rindex[kWorld] = larRIndex;
+    invAbsLength[kWorld] = 1. / larAbsorption;
+    rindex[kPEN] = WLSWrap == 1 ? penRIndex : pmmaRIndex;
+    invAbsLength[kPEN] = WLSWrap == 1 ? 0. : 1. / pmmaAbsorption;
+    wls[kPEN] = (WLSWrap == 1);
+    for (G4int volume : {kPanel, kGuide, kRightDetector, kLeftDetector})
+    {
+        rindex[volume] = pmmaRIndex;
+        invAbsLength[volume] = 1. / pmmaAbsorption;
+    }
+
+    wlsMeanNumberPhotons = ReadoutSimOpticalTables::wlsMeanNumberPhotons;
+    std::vector<G4double> energy, values;
+    Ascending(absorption_energy, absorption_values, absorption_entries, energy, values);
+    fWLSAbsLength.Build(energy, values);
+    Ascending(emission_energy, emission_values, emission_entries, energy, values);
+    fWLSEmission.Build(energy, values);
+}
+
+G4int RayTraceScene::Locate(G4double x, G4double y, G4double z) const
+{
+    // daughters first, the guide sits inside the PEN box
+    static const G4int order[kNumberOfVolumes] = {kGuide, kPEN, kPanel, kRightDetector, kLeftDetector, kWorld};
+    for (G4int volume : order)
+    {
+        if (x > lo[volume][0] && x < hi[volume][0] &&
+            y > lo[volume][1] && y < hi[volume][1] &&
+            z > lo[volume][2] && z < hi[volume][2]) return volume;
+    }
+    return kOutside;
+}
+
+const char* RayTraceScene::GetName(G4int volume)
+{
+    static const char* names[kNumberOfVolumes] = {"LAr", "PMMA panel", "PEN", "PMMA guide", "right detector", "left detector"};
+    return volume >= 0 && volume < kNumberOfVolumes ? names[volume] : "outside";
+}
@@ -0,0 +1,70 @@
+#include "RayTraceTally.hh"
+
+#include <iomanip>
+
+RayTraceTally::RayTraceTally()
+{
+    primaries = 0;
+    tracks = 0;
+    steps = 0;
+    detectedRight = 0;
+    detectedLeft = 0;
+    for (G4int volume = 0; volume < RayTraceScene::kNumberOfVolumes; volume++)
+    {
+        absorbed[volume] = 0;
+        towardLAr[volume] = 0;
+    }
+    escaped = 0;
+    lost = 0;
+}
+
+void RayTraceTally::Add(const RayTraceTally& other)
+{
+    primaries += other.primaries;
+    tracks += other.tracks;
+    steps += other.steps;
+    detectedRight += other.detectedRight;
+    detectedLeft += other.detectedLeft;
+    for (G4int volume = 0; volume < RayTraceScene::kNumberOfVolumes; volume++)
+    {
+        absorbed[volume] += other.absorbed[volume];
+        towardLAr[volume] += other.towardLAr[volume];
+    }
+    escaped += other.escaped;
+    lost += other.lost;
+}
+
+void RayTraceTally::Print(std::ostream& os) const
+{
+    typedef RayTraceScene Scene;
+    double total = double(primaries);
+    double lar = double(absorbed[Scene::kWorld]);
+    std::uint64_t detected = detectedRight + detectedLeft;
+    std::uint64_t detectors = absorbed[Scene::kRightDetector] + absorbed[Scene::kLeftDetector];
+    std::uint64_t all = detected + absorbed[Scene::kPEN] + absorbed[Scene::kGuide] + absorbed[Scene::kPanel] + absorbed[Scene::kWorld];
+
+    os << "\n   Summary\n";
+    os <<   "---------------------------------\n";
+    os << "  # of generated photons:          " << std::setw(8) << primaries << "\n";
+    os << "  Photons Detected:                 " << std::setw(8) << detected/total*100 << " %\n";
+    os << "    right / left:                   " << std::setw(8) << detectedRight/total*100 << " / " << detectedLeft/total*100 << " %\n";
+    os << "  Photons Absorbed in PEN:          " << std::setw(8) << absorbed[Scene::kPEN]/total*100 << " %\n";
+    os << "  Photons Absorbed in PMMA guide:   " << std::setw(8) << absorbed[Scene::kGuide]/total*100 << " %\n";
+    os << "  Photons Absorbed in PMMA panel:   " << std::setw(8) << absorbed[Scene::kPanel]/total*100 << " %\n";
+    os << "  Photons Absorbed in LAr:          " << std::setw(8) << lar/total*100 << " %\n";
+    os << "  TOTAL:          " << std::setw(8) << all/total*100 << " %\n";
+    os << "  Photons Absorbed in detectors:    " << std::setw(8) << detectors/total*100 << " %\n";
+    os << "  Photons leaving the world:        " << std::setw(8) << escaped/total*100 << " %\n";
+    os << "  Photons stopped by step limit:    " << std::setw(8) << lost/total*100 << " %\n";
+    os << "  Tracks per generated photon:      " << std::setw(8) << tracks/total << "\n";
+    os << "  Steps per track:                  " << std::setw(8) << double(steps)/double(tracks) << "\n";
+    os <<   "---------------------------------\n";
+
+    os << "\n   Where are photon before going into LAr?\n";
+    os <<   "---------------------------------\n";
+    os << "  Photons coming from Panel        " << std::setw(8) << towardLAr[Scene::kPanel]/lar*100 << " %\n";
+    os << "  Photons coming from PEN          " << std::setw(8) << towardLAr[Scene::kPEN]/lar*100 << " %\n";
+    os << "  Photons coming from PMMA guide   " << std::setw(8) << towardLAr[Scene::kGuide]/lar*100 << " %\n";
+    os << "  TOTAL:          " << std::setw(8) << (towardLAr[Scene::kPanel]+towardLAr[Scene::kPEN]+towardLAr[Scene::kGuide])/lar*100 << " %\n";
+    os << "\n";
+}
@@ -3,6 +3,9 @@
 #include "ReadoutSimPrimaryGenerator.hh"
 #include "ReadoutSimSteppingAction.hh"
 #include "ReadoutSimTrackingAction.hh"
+#include "ReadoutSimEventAction.hh"
+#include "ReadoutSimStackingAction.hh"
+#include "ReadoutSimPhotonBiasing.hh"
 
 ReadoutSimActionInitialization::ReadoutSimActionInitialization()
 {}
@@ -18,8 +21,12 @@ void ReadoutSimActionInitialization::BuildForMaster() const
 void ReadoutSimActionInitialization::Build() const
 {
   SetUserAction(new ReadoutSimPrimaryGenerator());
-  SetUserAction(new ReadoutSimRunAction());
-  SetUserAction(new ReadoutSimSteppingAction());
-  SetUserAction(new ReadoutSimTrackingAction);
-//   SetUserAction(new OpNoviceStackingAction());
+  ReadoutSimRunAction* runAction = new ReadoutSimRunAction();
+  SetUserAction(runAction);
+  ReadoutSimEventAction* eventAction = new ReadoutSimEventAction();
+  SetUserAction(eventAction);
+  ReadoutSimStackingAction* stackingAction = new ReadoutSimStackingAction();
+  SetUserAction(stackingAction);
+  SetUserAction(new ReadoutSimSteppingAction(eventAction, stackingAction, runAction, new ReadoutSimPhotonBiasing()));
+  SetUserAction(new ReadoutSimTrackingAction(runAction));
 }
\ No newline at end of file
@@ -0,0 +1,177 @@
+#include "ReadoutSimAdaptiveRun.hh"
+#include "ReadoutSimRunAction.hh"
+#include "Run.hh"
+
+#include "G4RunManager.hh"
+#include "G4UImanager.hh"
+#include "G4UIcommand.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <sstream>
+
+ReadoutSimAdaptiveRun::ReadoutSimAdaptiveRun()
+{
+    fPrecision = 0.01;
+    fChunkEvents = 10000;
+    fMinChunks = 5;
+    fMaxTime = 0.;
+
+    DefineCommands();
+}
+
+ReadoutSimAdaptiveRun::~ReadoutSimAdaptiveRun()
+{
+    delete fMessenger;
+}
+
+void ReadoutSimAdaptiveRun::Estimate(const std::vector<G4double>& efficiencies, G4double detected, G4long photons,
+                                     G4double& efficiency, G4double& relativeError)
+{
+    efficiency = photons > 0 ? detected / G4double(photons) : 0.;
+    relativeError = std::numeric_limits<G4double>::infinity();
+    std::size_t n = efficiencies.size();
+    if (n < 2 || efficiency <= 0.) return;
+
+    G4double mean = 0.;
+    for (G4double e : efficiencies) mean += e;
+    mean /= n;
+    G4double variance = 0.;
+    for (G4double e : efficiencies) variance += (e - mean) * (e - mean);
+    variance /= (n - 1);
+    relativeError = std::sqrt(variance / n) / efficiency;
+}
+
+void ReadoutSimAdaptiveRun::RunChunks(G4int maxEvents)
+{
+    G4UImanager* UImanager = G4UImanager::GetUIpointer();
+
+    // the chunks carry the tag of the configuration, e.g. the point of a sweep
+    G4String baseTag = UImanager->GetCurrentValues("/RS/run/tag");
+    G4bool writeHistograms = G4UIcommand::ConvertToBool(UImanager->GetCurrentValues("/RS/output/histograms"));
+    G4String histogramFileName = UImanager->GetCurrentValues("/RS/output/histogramFileName");
+    UImanager->ApplyCommand("/RS/output/histograms 0");
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    ::Run* total = nullptr;
+    std::vector<G4double> right, left;
+    G4double rightEfficiency = 0., rightError = 0., leftEfficiency = 0., leftError = 0.;
+    G4int nEvents = 0;
+    G4int nChunks = 0;
+    G4String reason = "event limit";
+    while (nEvents < maxEvents)
+    {
+        // a chunk that would end beyond the budget is not started
+        std::chrono::duration<G4double> elapsed = std::chrono::steady_clock::now() - start;
+        if (fMaxTime > 0. && nChunks > 0 && elapsed.count() * (nChunks + 1) / nChunks * s > fMaxTime)
+        {
+            reason = "time budget";
+            break;
+        }
+
+        G4int n = std::min(fChunkEvents, maxEvents - nEvents);
+        std::ostringstream tag;
+        if (!baseTag.empty()) tag << baseTag << "_";
+        tag << "c" << nChunks;
+        UImanager->ApplyCommand("/RS/run/tag " + tag.str());
+        if (UImanager->ApplyCommand("/run/beamOn " + G4UIcommand::ConvertToString(n)) != 0)
+        {
+            reason = "failed run";
+            break;
+        }
+
+        const ::Run* run = static_cast<const ::Run*>(G4RunManager::GetRunManager()->GetCurrentRun());
+        if (!run || run->GetNumberOfEvent() != n || run->GetNumberOfPhotons() == 0)
+        {
+            reason = "failed run";
+            break;
+        }
+        if (!total) total = new ::Run(run->GetSourceZHalfWidth());
+        total->Add(*run);
+        nEvents += n;
+        nChunks++;
+
+        right.push_back(run->GetRightDetections() / run->GetNumberOfPhotons());
+        left.push_back(run->GetLeftDetections() / run->GetNumberOfPhotons());
+        Estimate(right, total->GetRightDetections(), total->GetNumberOfPhotons(), rightEfficiency, rightError);
+        Estimate(left, total->GetLeftDetections(), total->GetNumberOfPhotons(), leftEfficiency, leftError);
+        G4cout << "Adaptive chunk " << nChunks << ": right " << rightEfficiency * 100 << " % +- " << rightError * 100
+               << " %, left " << leftEfficiency * 100 << " % +- " << leftError * 100 << " % (relative)" << G4endl;
+
+        if (nChunks >= fMinChunks && rightError <= fPrecision && leftError <= fPrecision)
+        {
+            reason = "precision reached";
+            break;
+        }
+    }
+    std::chrono::duration<G4double> wallTime = std::chrono::steady_clock::now() - start;
+
+    UImanager->ApplyCommand("/RS/run/tag " + baseTag);
+    UImanager->ApplyCommand(G4String("/RS/output/histograms ") + (writeHistograms ? "1" : "0"));
+    if (!total) return;
+
+    total->EndOfRun(baseTag.empty() ? G4String("all chunks") : baseTag);
+    G4cout << "\n   Adaptive run\n";
+    G4cout <<   "---------------------------------\n";
+    G4cout << "  Chunks:                          " << std::setw(8) << nChunks << G4endl;
+    G4cout << "  Events:                          " << std::setw(8) << nEvents << G4endl;
+    G4cout << "  Wall time:                       " << std::setw(8) << wallTime.count() << " s" << G4endl;
+    G4cout << "  Right efficiency:                " << std::setw(8) << rightEfficiency * 100 << " % +- " << rightError * 100 << " %" << G4endl;
+    G4cout << "  Left efficiency:                 " << std::setw(8) << leftEfficiency * 100 << " % +- " << leftError * 100 << " %" << G4endl;
+    G4cout << "  Target precision:                " << std::setw(8) << fPrecision * 100 << " %" << G4endl;
+    G4cout << "  Stopped by:                      " << reason << G4endl;
+    G4cout <<   "---------------------------------\n";
+
+    if (writeHistograms)
+    {
+        G4String fileName = ReadoutSimRunAction::TagFileName(histogramFileName, baseTag);
+        if (total->WriteHistograms(fileName))
+            G4cout << "Histograms of all chunks written to " << fileName << G4endl;
+        else
+            G4cerr << "Cannot write the histograms to " << fileName << G4endl;
+    }
+    delete total;
+}
+
+void ReadoutSimAdaptiveRun::DefineCommands()
+{
+    fMessenger = new G4GenericMessenger(this, "/RS/adaptive/", "Commands for runs that stop at a target precision");
+
+    fMessenger->DeclareProperty("precision", fPrecision)
+    .SetGuidance("Target relative uncertainty of both the right and the left detection efficiency")
+    .SetParameterName("precision", false)
+    .SetRange("precision>0.")
+    .SetDefaultValue("0.01")
+    .SetToBeBroadcasted(false);
+
+    fMessenger->DeclareProperty("chunk", fChunkEvents)
+    .SetGuidance("Events per chunk: the precision is checked after every chunk")
+    .SetGuidance("Chunks much longer than the correlation of the photons of an event give a sound batch-means error")
+    .SetParameterName("nEvents", false)
+    .SetRange("nEvents>0")
+    .SetDefaultValue("10000")
+    .SetToBeBroadcasted(false);
+
+    fMessenger->DeclareProperty("minChunks", fMinChunks)
+    .SetGuidance("Do not stop on the precision before this many chunks")
+    .SetParameterName("n", false)
+    .SetRange("n>=2")
+    .SetDefaultValue("5")
+    .SetToBeBroadcasted(false);
+
+    fMessenger->DeclarePropertyWithUnit("maxTime", "s", fMaxTime)
+    .SetGuidance("Wall-clock budget: no chunk is started that would end beyond it, 0 for none")
+    .SetParameterName("time", false)
+    .SetRange("time>=0.")
+    .SetDefaultValue("0.")
+    .SetToBeBroadcasted(false);
+
+    fMessenger->DeclareMethod("run", &ReadoutSimAdaptiveRun::RunChunks)
+    .SetGuidance("Run chunks until the target precision, the time budget or this many events")
+    .SetParameterName("maxEvents", false)
+    .SetRange("maxEvents>0")
+    .SetToBeBroadcasted(false);
+}
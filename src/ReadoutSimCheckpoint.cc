@@ -0,0 +1,175 @@
+#include "ReadoutSimCheckpoint.hh"
+#include "Run.hh"
+
+#include "G4RunManager.hh"
+#include "G4UImanager.hh"
+#include "G4UIcommand.hh"
+#include "G4Exception.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+ReadoutSimCheckpoint::ReadoutSimCheckpoint()
+{
+    fFileName = "readout_checkpoint.txt";
+    fSegmentEvents = 100000;
+    fResume = false;
+
+    DefineCommands();
+}
+
+ReadoutSimCheckpoint::~ReadoutSimCheckpoint()
+{
+    delete fMessenger;
+}
+
+void ReadoutSimCheckpoint::RunSegments(G4int nEvents)
+{
+    G4UImanager* UImanager = G4UImanager::GetUIpointer();
+    G4int nSegments = (nEvents + fSegmentEvents - 1) / fSegmentEvents;
+
+    G4int nDone = 0;
+    ::Run* total = nullptr;
+    if (fResume)
+    {
+        total = Load(nEvents, nDone);
+        if (total)
+            G4cout << "\n===== Resuming from " << fFileName << ": " << nDone << "/" << nSegments << " segments done =====" << G4endl;
+        else
+        {
+            G4ExceptionDescription msg;
+            msg << "No checkpoint of " << nEvents << " events in segments of " << fSegmentEvents
+                << " in " << fFileName << ", starting from the first segment";
+            G4Exception("ReadoutSimCheckpoint::RunSegments()", "RS0005", JustWarning, msg);
+        }
+        // only the first job after the start resumes
+        fResume = false;
+    }
+
+    // the histograms of the segments are summed here and written after every segment
+    G4bool writeHistograms = G4UIcommand::ConvertToBool(UImanager->GetCurrentValues("/RS/output/histograms"));
+    G4String histogramFileName = UImanager->GetCurrentValues("/RS/output/histogramFileName");
+    UImanager->ApplyCommand("/RS/output/histograms 0");
+
+    for (G4int segment = nDone; segment < nSegments; segment++)
+    {
+        G4int n = std::min(fSegmentEvents, nEvents - segment * fSegmentEvents);
+        std::ostringstream tag;
+        tag << "s" << segment;
+
+        G4cout << "\n===== Segment " << segment + 1 << "/" << nSegments << " [" << tag.str() << "]: "
+               << n << " events =====" << G4endl;
+
+        UImanager->ApplyCommand("/RS/run/tag " + tag.str());
+        if (UImanager->ApplyCommand("/run/beamOn " + G4UIcommand::ConvertToString(n)) != 0) break;
+
+        // the master run stays with the run manager until the next run starts
+        const ::Run* run = static_cast<const ::Run*>(G4RunManager::GetRunManager()->GetCurrentRun());
+        if (!run || run->GetNumberOfEvent() != n)
+        {
+            G4cerr << "Segment " << tag.str() << " did not complete, no checkpoint written" << G4endl;
+            break;
+        }
+        if (!total) total = new ::Run(run->GetSourceZHalfWidth());
+        total->Add(*run);
+        nDone = segment + 1;
+
+        if (Save(*total, nEvents, nDone))
+            G4cout << "Checkpoint after " << nDone << " segments written to " << fFileName << G4endl;
+        else
+            G4cerr << "Cannot write the checkpoint to " << fFileName << G4endl;
+        if (writeHistograms && !total->WriteHistograms(histogramFileName))
+            G4cerr << "Cannot write the histograms to " << histogramFileName << G4endl;
+    }
+
+    UImanager->ApplyCommand("/RS/run/tag");
+    UImanager->ApplyCommand(G4String("/RS/output/histograms ") + (writeHistograms ? "1" : "0"));
+
+    if (total && nDone == nSegments)
+    {
+        total->EndOfRun("all segments");
+        if (writeHistograms) G4cout << "Histograms of all segments written to " << histogramFileName << G4endl;
+    }
+    delete total;
+}
+
+G4bool ReadoutSimCheckpoint::Save(const ::Run& total, G4int nEvents, G4int nDone) const
+{
+    // a job killed while writing leaves the previous checkpoint in place
+    G4String tmpFileName = fFileName + ".tmp";
+    {
+        std::ofstream file(tmpFileName);
+        if (!file) return false;
+
+        file.precision(17);
+        file << "# ReadoutSim checkpoint\n";
+        file << "events " << nEvents << " segment " << fSegmentEvents << " done " << nDone
+             << " source " << total.GetSourceZHalfWidth() << "\n";
+        total.Save(file);
+        file << "engine\n";
+        G4Random::getTheEngine()->put(file);
+        file << "\n";
+        if (!file.good()) return false;
+    }
+    return std::rename(tmpFileName.c_str(), fFileName.c_str()) == 0;
+}
+
+::Run* ReadoutSimCheckpoint::Load(G4int nEvents, G4int& nDone) const
+{
+    std::ifstream file(fFileName);
+    if (!file) return nullptr;
+
+    std::string line;
+    std::getline(file, line);
+
+    std::string events, segment, done, source;
+    G4int fileEvents, fileSegmentEvents;
+    G4double sourceZHalfWidth;
+    file >> events >> fileEvents >> segment >> fileSegmentEvents >> done >> nDone >> source >> sourceZHalfWidth;
+    if (!file || events != "events" || fileEvents != nEvents || fileSegmentEvents != fSegmentEvents) return nullptr;
+
+    ::Run* total = new ::Run(sourceZHalfWidth);
+    std::string engine;
+    if (!total->Load(file) || !(file >> engine) || engine != "engine")
+    {
+        delete total;
+        return nullptr;
+    }
+    std::getline(file, line);
+    G4Random::getTheEngine()->get(file);
+    if (file.fail())
+    {
+        delete total;
+        return nullptr;
+    }
+    return total;
+}
+
+void ReadoutSimCheckpoint::DefineCommands()
+{
+    fMessenger = new G4GenericMessenger(this, "/RS/checkpoint/", "Commands for long runs with checkpoints");
+
+    fMessenger->DeclareProperty("file", fFileName)
+    .SetGuidance("Checkpoint file, rewritten after every segment and read with --resume")
+    .SetParameterName("fileName", false)
+    .SetDefaultValue("readout_checkpoint.txt")
+    .SetToBeBroadcasted(false);
+
+    fMessenger->DeclareProperty("segment", fSegmentEvents)
+    .SetGuidance("Events per segment: a checkpoint is written after each one")
+    .SetGuidance("A resumed job must use the same number of events and segment size")
+    .SetParameterName("nEvents", false)
+    .SetRange("nEvents>0")
+    .SetDefaultValue("100000")
+    .SetToBeBroadcasted(false);
+
+    fMessenger->DeclareMethod("run", &ReadoutSimCheckpoint::RunSegments)
+    .SetGuidance("Run the given number of events in segments, with a checkpoint after each one")
+    .SetGuidance("With --resume on the command line, the segments of the checkpoint file are skipped")
+    .SetParameterName("nEvents", false)
+    .SetRange("nEvents>0")
+    .SetToBeBroadcasted(false);
+}
@@ -1,14 +1,26 @@
 #include "ReadoutSimDetectorConstruction.hh"
-// #include "ReadoutSimDetectorMessenger.hh"
+#include "ReadoutSimVolumeRegistry.hh"
+#include "ReadoutSimOpticalTables.hh"
+#include "ReadoutSimBaselineLayout.hh"
+#include "ReadoutSimDetectorMessenger.hh"
+#include "ReadoutSimMemory.hh"
 
 #include "G4Element.hh"
 #include "G4Box.hh"
 #include "G4ThreeVector.hh"
 #include "G4PVPlacement.hh"
+#include "G4PVReplica.hh"
+#include "G4PhysicalVolumeStore.hh"
 #include "G4Colour.hh"
 #include "G4VisAttributes.hh"
 #include "G4NistManager.hh"
 #include "G4OpticalSurface.hh"
+#include "G4Region.hh"
+#include "G4RunManager.hh"
+#include "G4Exception.hh"
+
+#include <algorithm>
+#include <functional>
 
 ReadoutSimDetectorConstruction::ReadoutSimDetectorConstruction()
 {
@@ -18,19 +30,43 @@ ReadoutSimDetectorConstruction::ReadoutSimDetectorConstruction()
     innerCladdingMPT = new G4MaterialPropertiesTable();
     outerCladdingMPT = new G4MaterialPropertiesTable();
 
+    space = 0.*cm;
+    layerThickness = 0.;
+    // PEN layer thickness, it changes the position of the small light guide
+    fFoilThickness = 0.005*cm; //100 micron
+
     DefineCommands();
+    fDetectorMessenger = new DetectorMessenger(this);
 }
 
 ReadoutSimDetectorConstruction::~ReadoutSimDetectorConstruction()
 {
+    delete fDetectorMessenger;
 }
 
 G4VPhysicalVolume *ReadoutSimDetectorConstruction::Construct() 
 {
-    DefineMaterials();
-    SetOpticalProperties();
+    // materials and their tables are kept when the geometry is rebuilt
+    if (!fMaterialsBuilt)
+    {
+        DefineMaterials();
+        SetOpticalProperties();
+        fMaterialsBuilt = true;
+    }
+
+    // the setup methods register the volumes they place
+    ReadoutSimVolumeRegistry::Instance()->Clear();
+
+    G4double memoryBefore = ReadoutSimMemory::GetResident();
+    G4bool module = fNumberOfBars > 1 || fNumberOfPanels > 1;
+    G4VPhysicalVolume* world = module ? SetupModuleDesign() : SetupBaselineDesign();
+
+    // box around everything placed in the LAr, see ReadoutSimStackingAction
+    ReadoutSimVolumeRegistry::Instance()->ComputeEnvelope(world->GetLogicalVolume());
+
+    if (module) PrintGeometrySummary(world, memoryBefore);
 
-    return SetupBaselineDesign();
+    return world;
 }
 
 void ReadoutSimDetectorConstruction::DefineMaterials()
@@ -75,34 +111,34 @@ void ReadoutSimDetectorConstruction::SetOpticalProperties()
     // G4double energy[] = {2.88*eV};    // 430nm, peak emission of PEN
     G4double energy[2] = {2*eV, 12*eV};    // 430nm, peak emission of PEN
 
+    using namespace ReadoutSimOpticalTables;
+
     // PMMA
-    G4double pmmaRIndex[] = {1.50, 1.50};   // for PMMA @ 430nm
-    G4double pmmaAbsorption[] = {2.*m, 2.*m};     // for PMMA @ 430nm, try 1.5/2/2.5/3 m
-    pmmaMPT->AddProperty("RINDEX", energy, pmmaRIndex, nEntries)->SetSpline(true);
-    pmmaMPT->AddProperty("ABSLENGTH", energy, pmmaAbsorption, nEntries)->SetSpline(true);
+    G4double pmmaRIndexes[] = {pmmaRIndex, pmmaRIndex};
+    G4double pmmaAbsorptions[] = {pmmaAbsorption, pmmaAbsorption};
+    pmmaMPT->AddProperty("RINDEX", energy, pmmaRIndexes, nEntries)->SetSpline(true);
+    pmmaMPT->AddProperty("ABSLENGTH", energy, pmmaAbsorptions, nEntries)->SetSpline(true);
     PMMA->SetMaterialPropertiesTable(pmmaMPT);
 
     // PEN
-    G4int absorption_entries = 136;
-    G4double absorption_energy[136] = {12.*eV, 3.25814*eV,3.23948*eV,3.22315*eV,3.20819*eV,3.19096*eV,3.17511*eV,3.15942*eV,3.14388*eV,3.12612*eV,3.10698*eV,3.09271*eV,3.07916*eV,3.06507*eV,3.05309*eV,3.04186*eV,3.02973*eV,3.02013*eV,3.00802*eV,2.99648*eV,2.98503*eV,2.97493*eV,2.96239*eV,2.95244*eV,2.94243*eV,2.93218*eV,2.92149*eV,2.90902*eV,2.90005*eV,2.89053*eV,2.88579*eV,2.87611*eV,2.86416*eV,2.85268*eV,2.84109*eV,2.82832*eV,2.82095*eV,2.80855*eV,2.79673*eV,2.78961*eV,2.78390*eV,2.77279*eV,2.76498*eV,2.75155*eV,2.74112*eV,2.72878*eV,2.71710*eV,2.70530*eV,2.69350*eV,2.66995*eV,2.65884*eV,2.64937*eV,2.61333*eV,2.60607*eV,2.58887*eV,2.57971*eV,2.56882*eV,2.55787*eV,2.53466*eV,2.51224*eV,2.50293*eV,2.49215*eV,2.48426*eV,2.47415*eV,2.46551*eV,2.45629*eV,2.43998*eV,2.42426*eV,2.38991*eV,2.36889*eV,2.35666*eV,2.34899*eV,2.34214*eV,2.32433*eV,2.30188*eV,2.29362*eV,2.28542*eV,2.27912*eV,2.25971*eV,2.23884*eV,2.23103*eV,2.22327*eV,2.21801*eV,2.20065*eV,2.18052*eV,2.17310*eV,2.16574*eV,2.16041*eV,2.14329*eV,2.12515*eV,2.11811*eV,2.11111*eV,2.10574*eV,2.08947*eV,2.07314*eV,2.06644*eV,2.05972*eV,2.05466*eV,2.03887*eV,2.02186*eV,2.01549*eV,2.00915*eV,2.00486*eV,1.99038*eV,1.97695*eV,1.97085*eV,1.96480*eV,1.96123*eV,1.94927*eV,1.93665*eV,1.93004*eV,1.92578*eV,1.91555*eV,1.90491*eV,1.90002*eV,1.89541*eV,1.88600*eV,1.87689*eV,1.87244*eV,1.87020*eV,1.86030*eV,1.85376*eV,1.84856*eV,1.84033*eV,1.83314*eV,1.82837*eV,1.82401*eV,1.81985*eV,1.81248*eV,1.80920*eV,1.80189*eV,1.79320*eV,1.78871*eV,1.77977*eV,1.77483*eV, 1.77147*eV};
-    G4double absorption_values[136] = {0.3758, 0.3758,0.4457,0.5604,0.2549,0.2937,0.4058,0.7564,1.172,1.7744,2.4753,3.9466,5.0731,6.8639,8.2917,10.1109,12.2749,14.3209,16.8414,19.0424,21.3319,23.6221,25.7956,28.0331,30.1711,32.3501,34.6198,37.2724,39.1275,41.383,43.0375,44.6318,46.6015,48.5223,50.7679,53.0692,55.1642,57.0244,58.3387,58.7343,60.8373,61.3766,63.1698,63.6815,64.6267,65.4004,66.1446,67.7824,68.2573,69.166,69.421,69.0529,69.7186,69.5965,70.9755,71.1224,71.3394,71.5693,71.2311,71.1341,70.3446,69.7107,69.2227,67.7364,67.5254,67.4859,67.6422,67.7565,67.0881,67.1796,67.4574,67.6737,68.077,69.1077,69.8746,70.3309,70.3277,70.4992,70.2329,69.1941,68.8777,68.3743,68.0007,66.5712,65.4022,65.2242,64.7695,64.5717,64.538,65.1323,65.8164,66.3866,66.4781,67.5016,68.6281,68.8893,69.1024,69.3924,70.5099,71.3434,72.3067,72.736,72.948,74.0237,76.4575,76.9708,78.4357,78.9934,80.8292,84.1252,86.2386,87.2857,90.7117,94.4017,96.5345,98.0538,101.6405,104.496,106.4628,108.5769,111.8888,115.6327,116.6733,116.8666,120.3332,122.1505,122.0227,120.9319,125.004,127.1816,128.182,130.8079,132.2029,134.2453,132.8147,133.6449};
-    G4int emission_entries = 200;
-    G4double emission_energy[200] = {4.121*eV, 4.076*eV,4.034*eV,3.995*eV,3.956*eV,3.918*eV,3.882*eV,3.845*eV,3.806*eV,3.773*eV,3.738*eV,3.704*eV,3.671*eV,3.639*eV,3.606*eV,3.574*eV,3.543*eV,3.513*eV,3.483*eV,3.453*eV,3.424*eV,3.411*eV,3.387*eV,3.373*eV,3.364*eV,3.355*eV,3.350*eV,3.346*eV,3.338*eV,3.334*eV,3.331*eV,3.322*eV,3.319*eV,3.317*eV,3.310*eV,3.301*eV,3.295*eV,3.294*eV,3.288*eV,3.282*eV,3.280*eV,3.278*eV,3.271*eV,3.266*eV,3.265*eV,3.258*eV,3.252*eV,3.246*eV,3.246*eV,3.242*eV,3.234*eV,3.232*eV,3.228*eV,3.220*eV,3.217*eV,3.213*eV,3.205*eV,3.197*eV,3.192*eV,3.184*eV,3.177*eV,3.177*eV,3.169*eV,3.165*eV,3.163*eV,3.156*eV,3.151*eV,3.145*eV,3.145*eV,3.137*eV,3.132*eV,3.130*eV,3.122*eV,3.118*eV,3.118*eV,3.110*eV,3.105*eV,3.104*eV,3.094*eV,3.085*eV,3.081*eV,3.073*eV,3.066*eV,3.051*eV,3.035*eV,3.013*eV,2.991*eV,2.969*eV,2.948*eV,2.929*eV,2.918*eV,2.905*eV,2.897*eV,2.890*eV,2.881*eV,2.874*eV,2.869*eV,2.861*eV,2.859*eV,2.850*eV,2.846*eV,2.839*eV,2.837*eV,2.830*eV,2.821*eV,2.814*eV,2.813*eV,2.806*eV,2.799*eV,2.795*eV,2.789*eV,2.781*eV,2.775*eV,2.771*eV,2.761*eV,2.761*eV,2.755*eV,2.744*eV,2.736*eV,2.729*eV,2.725*eV,2.723*eV,2.717*eV,2.708*eV,2.700*eV,2.691*eV,2.681*eV,2.676*eV,2.667*eV,2.664*eV,2.653*eV,2.649*eV,2.640*eV,2.631*eV,2.627*eV,2.619*eV,2.610*eV,2.601*eV,2.589*eV,2.586*eV,2.577*eV,2.566*eV,2.554*eV,2.545*eV,2.535*eV,2.525*eV,2.516*eV,2.501*eV,2.484*eV,2.471*eV,2.459*eV,2.450*eV,2.440*eV,2.425*eV,2.414*eV,2.400*eV,2.387*eV,2.373*eV,2.362*eV,2.349*eV,2.336*eV,2.323*eV,2.310*eV,2.296*eV,2.284*eV,2.271*eV,2.258*eV,2.245*eV,2.233*eV,2.222*eV,2.210*eV,2.197*eV,2.185*eV,2.174*eV,2.163*eV,2.152*eV,2.140*eV,2.129*eV,2.118*eV,2.107*eV,2.096*eV,2.085*eV,2.075*eV,2.064*eV,2.054*eV,2.043*eV,2.033*eV,2.023*eV,2.013*eV,2.003*eV,1.994*eV,1.985*eV,1.974*eV,1.965*eV,1.956*eV,1.946*eV,1.936*eV,1.928*eV,1.918*eV,1.911*eV};
-    G4double emission_values[200] = {7.0293,16.9415,10.7047,45.726,50.7554,55.2072,77.4307,61.2781,45.8031,16.3452,55.7023,14.6248,-13.1988,6.555,2.6498,-11.4939,-4.7904,25.487,49.7759,96.5219,209.3136,339.5284,512.1626,725.255,927.58,1143.9247,1351.3291,1644.9531,1925.6427,2196.7536,2442.0504,2618.048,2776.4256,2996.688,3263.9944,3500.9443,3742.1178,3983.4344,4230.3848,4398.3571,4600.1356,4827.7794,5078.4118,5300.7009,5571.4976,5856.4642,6061.7348,6266.8834,6405.6897,6594.1269,6841.5772,6978.9624,7170.03,7420.6595,7568.734,7797.5579,8031.0384,8247.0488,8535.363,8787.8291,8922.142,9141.1737,9406.8964,9567.665,9782.9677,10063.6821,10283.1786,10456.5366,10688.7506,10967.5929,11178.9257,11444.6893,11714.6674,11897.2054,12072.3493,12339.7591,12495.3968,12730.9516,13001.2756,13216.637,13448.1597,13627.8594,13827.8985,14053.2262,14269.0933,14441.0115,14501.9804,14524.0235,14458.484,14325.3404,14134.0736,13963.8366,13768.8243,13593.031,13393.594,13145.8641,12952.8068,12782.246,12560.672,12346.54,12124.4686,11936.6808,11725.3635,11529.9927,11302.2122,11015.0504,10797.0964,10562.8642,10434.8026,10173.7304,10030.1194,9757.0008,9550.5153,9328.0247,9179.752,8931.5451,8733.5726,8491.1374,8272.8068,7956.0463,7868.4239,7649.2608,7485.9592,7262.1554,7048.2165,6675.112,6386.5461,6167.6057,5951.6386,5694.8763,5468.461,5314.9438,5024.5664,4838.6677,4640.787,4426.4052,4231.3355,4044.6662,3855.5094,3652.9909,3430.2043,3196.1524,3011.6655,2784.6268,2605.7246,2452.9249,2302.4445,2118.9833,1899.8405,1748.9089,1623.6297,1489.8054,1371.2659,1239.6131,1171.9962,1046.581,938.7413,868.631,772.7616,701.2099,625.1904,579.8622,545.0141,494.4586,503.6137,472.2251,452.3345,494.5934,508.9393,542.4361,608.6249,707.8472,777.5688,870.1675,877.0437,869.6932,812.2685,734.182,622.9797,513.2745,419.066,359.4056,291.2013,278.2788,237.0143,213.6086,207.9547,159.0263,171.1955,158.1363,175.3452,142.3859,135.165,137.5661,119.57,134.6123,105.92,93.3617,89.2049,47.6809}; 
-    G4double penRIndex[] = {1.7};     // for PEN @ 430nm
-
-    penMPT->AddProperty("RINDEX", energy, penRIndex, nEntries);
-    penMPT->AddProperty("WLSABSLENGTH", absorption_energy, absorption_values, absorption_entries); 
-    penMPT->AddProperty("WLSCOMPONENT", emission_energy, emission_values, emission_entries);
-    penMPT->AddConstProperty("WLSTIMECONSTANT", 25.3*ns); // from L. Manzanillas et al. “Optical properties of low background PEN structural components for the LEGEND-200 experiment”. In: JINST 17 P09007 (2022), https://doi.org/10.1088/1748-0221/17/09/P09007
-    penMPT->AddConstProperty("WLSMEANNUMBERPHOTONS", 0.69); // from [Araujo2022] at LAr temperature
+    std::vector<G4double> penAbsorptionEnergy, penAbsorptionValues;
+    std::vector<G4double> penEmissionEnergy, penEmissionValues;
+    Ascending(absorption_energy, absorption_values, absorption_entries, penAbsorptionEnergy, penAbsorptionValues);
+    Ascending(emission_energy, emission_values, emission_entries, penEmissionEnergy, penEmissionValues);
+    G4double penRIndexes[] = {penRIndex};
+
+    penMPT->AddProperty("RINDEX", energy, penRIndexes, nEntries);
+    penMPT->AddProperty("WLSABSLENGTH", penAbsorptionEnergy.data(), penAbsorptionValues.data(), absorption_entries); 
+    penMPT->AddProperty("WLSCOMPONENT", penEmissionEnergy.data(), penEmissionValues.data(), emission_entries);
+    penMPT->AddConstProperty("WLSTIMECONSTANT", wlsTimeConstant);
+    penMPT->AddConstProperty("WLSMEANNUMBERPHOTONS", wlsMeanNumberPhotons);
     PEN->SetMaterialPropertiesTable(penMPT);
 
     // LAr
-    G4double larAbsorption[] = {0.1*m, 0.1*m};     // for lAr @ 430nm, random value to just kill photons when they enter in lAr volume
-    G4double larRIndex[] = {1.23, 1.23};    // for lAr @ 430nm, from Sellmeier formula
-    larMPT->AddProperty("RINDEX", energy, larRIndex, nEntries)->SetSpline(true);
-    larMPT->AddProperty("ABSLENGTH", energy, larAbsorption, nEntries)->SetSpline(true);
+    G4double larAbsorptions[] = {larAbsorption, larAbsorption};
+    G4double larRIndexes[] = {larRIndex, larRIndex};
+    larMPT->AddProperty("RINDEX", energy, larRIndexes, nEntries)->SetSpline(true);
+    larMPT->AddProperty("ABSLENGTH", energy, larAbsorptions, nEntries)->SetSpline(true);
     worldMaterial->SetMaterialPropertiesTable(larMPT);
 
     // Inner Cladding
@@ -121,10 +157,74 @@ void ReadoutSimDetectorConstruction::SetOpticalProperties()
 
 }
 
+void ReadoutSimDetectorConstruction::ConstructSDandField()
+{
+    // fast simulation models are thread-local, the region is shared
+    static G4ThreadLocal ReadoutSimGuideTIRModel* guideModel = nullptr;
+    if (!guideModel) guideModel = new ReadoutSimGuideTIRModel("GuideTIRModel", fGuideRegion, &fGuideSurroundings);
+}
+
+void ReadoutSimDetectorConstruction::SetGuideTIR(G4bool val)
+{
+    // without the fast-simulation process the model is never asked
+    if (val && !ReadoutSimGuideTIRModel::IsPhysicsRegistered())
+    {
+        G4ExceptionDescription msg;
+        msg << "The guide TIR model needs the fast-simulation physics, start ReadoutSim with -g; keeping full tracking";
+        G4Exception("ReadoutSimDetectorConstruction::SetGuideTIR()", "RS0010", JustWarning, msg);
+        return;
+    }
+    ReadoutSimGuideTIRModel::SetEnabled(val);
+}
+
+void ReadoutSimDetectorConstruction::SetNumberOfBars(G4int val)
+{
+    // the PEN box of every bar must fit in its slot
+    ReadoutSimBaselineLayout layout = ComputeLayout();
+    if (2. * layout.panel.halfLength[2] / val < 2. * layout.pen.halfLength[2])
+    {
+        G4ExceptionDescription msg;
+        msg << val << " bars do not fit along the panel, keeping " << fNumberOfBars;
+        G4Exception("ReadoutSimDetectorConstruction::SetNumberOfBars()", "RS0004", JustWarning, msg);
+        return;
+    }
+    fNumberOfBars = val;
+    RebuildGeometry();
+}
+
+void ReadoutSimDetectorConstruction::SetNumberOfPanels(G4int val)
+{
+    fNumberOfPanels = val;
+    RebuildGeometry();
+}
+
+void ReadoutSimDetectorConstruction::SetPanelGap(G4double val)
+{
+    fPanelGap = val;
+    RebuildGeometry();
+}
+
+void ReadoutSimDetectorConstruction::SetPlacement(G4String val)
+{
+    fReplicateSlots = (val == "replica");
+    RebuildGeometry();
+}
+
+void ReadoutSimDetectorConstruction::SetSmartless(G4double val)
+{
+    fSmartless = val;
+    RebuildGeometry();
+}
+
 void ReadoutSimDetectorConstruction::SetSpace(G4int val)
 {
-    if(val == 1) space = 2.*cm; 
-    else space = 0.*cm;
+    SetSpaceLength(val == 1 ? 2.*cm : 0.*cm);
+}
+
+void ReadoutSimDetectorConstruction::SetSpaceLength(G4double val)
+{
+    space = val;
+    UpdateGeometry();
 }
 
 void ReadoutSimDetectorConstruction::SetWLSBack(G4int val)
@@ -133,14 +233,120 @@ void ReadoutSimDetectorConstruction::SetWLSBack(G4int val)
         WLS_y = 2;
         centerGuide = 0;
     }
+    else{
+        WLS_y = 1;
+        centerGuide = 1;
+    }
+    UpdateGeometry();
 }
 
 void ReadoutSimDetectorConstruction::setWLSWrap(G4int val)
 {
-    if(val == 0){
-        WLS_material = PMMA;
-        layerThickness = 0.*cm;
+    // without wrapping the PEN box becomes a PMMA box of the guide size
+    fWLSWrap = (val != 0);
+    UpdateGeometry();
+}
+
+void ReadoutSimDetectorConstruction::SetFoilThickness(G4double val)
+{
+    fFoilThickness = val;
+    UpdateGeometry();
+}
+
+void ReadoutSimDetectorConstruction::SetGeometry(G4String name)
+{
+    if (name != "baseline")
+    {
+        G4ExceptionDescription msg;
+        msg << "No geometry " << name << ", only baseline is available";
+        G4Exception("ReadoutSimDetectorConstruction::SetGeometry()", "RS0002", JustWarning, msg);
+        return;
+    }
+    if (name == fGeometryName) return;
+    fGeometryName = name;
+
+    // another design: drop all the volumes and construct again at the next run
+    RebuildGeometry();
+}
+
+void ReadoutSimDetectorConstruction::RebuildGeometry()
+{
+    // before the first Construct() the settings are simply used there
+    if (!fWorldPhysical) return;
+
+    if (fGuideRegion && fGuideLogical) fGuideRegion->RemoveRootLogicalVolume(fGuideLogical);
+    fWorldPhysical = nullptr;
+    G4RunManager::GetRunManager()->ReinitializeGeometry(true);
+}
+
+ReadoutSimBaselineLayout ReadoutSimDetectorConstruction::ComputeLayout()
+{
+    layerThickness = fWLSWrap ? fFoilThickness : 0.*cm;
+    WLS_material = fWLSWrap ? PEN : PMMA;
+    return ReadoutSimBaselineLayout::Compute(space, layerThickness, WLS_y, centerGuide);
+}
+
+ReadoutSimModuleLayout ReadoutSimDetectorConstruction::ComputeModuleLayout(const ReadoutSimBaselineLayout& layout) const
+{
+    ReadoutSimModuleLayout module;
+    module.nBars = fNumberOfBars;
+    module.nPanels = fNumberOfPanels;
+    // bars share the panel length, panels sit side by side with their end detectors
+    module.barPitch = 2. * layout.panel.halfLength[2] / fNumberOfBars;
+    module.panelPitch = 2. * (layout.rightDetector.center[0] + layout.rightDetector.halfLength[0]) + fPanelGap;
+    return module;
+}
+
+void ReadoutSimDetectorConstruction::SetGuideSurroundings(const ReadoutSimBaselineLayout& layout)
+{
+    // foil thickness on each side of the guide, and what lies beyond the PEN box
+    using Model = ReadoutSimGuideTIRModel;
+    const G4double* pen_h = layout.pen.halfLength;
+    const G4double* guide_h = layout.guide.halfLength;
+    fGuideSurroundings.foilThickness[Model::kMinusY] = layerThickness * (WLS_y - centerGuide);
+    fGuideSurroundings.foilThickness[Model::kPlusY]  = layerThickness * (WLS_y + centerGuide);
+    fGuideSurroundings.foilThickness[Model::kMinusZ] = pen_h[2] - guide_h[2];
+    fGuideSurroundings.foilThickness[Model::kPlusZ]  = pen_h[2] - guide_h[2];
+    for (G4int face = 0; face < Model::kNumberOfFaces; face++)
+    {
+        fGuideSurroundings.foilMaterial[face] = fGuideSurroundings.foilThickness[face] > 0. ? WLS_material : nullptr;
+        fGuideSurroundings.outerMaterial[face] = worldMaterial;
     }
+    // the back of the PEN box rests on the panel unless there is a gap
+    if (space == 0.) fGuideSurroundings.outerMaterial[Model::kMinusY] = PMMA;
+}
+
+void ReadoutSimDetectorConstruction::UpdateGeometry()
+{
+    // before the first Construct() the settings are simply used there
+    if (!fWorldPhysical) return;
+
+    // the slots of the module are sized on the cell: build it again
+    if (fNumberOfBars > 1 || fNumberOfPanels > 1)
+    {
+        RebuildGeometry();
+        return;
+    }
+
+    // only boxes sizes, positions and the foil material depend on the settings
+    ReadoutSimBaselineLayout layout = ComputeLayout();
+    const G4double* pen_h = layout.pen.halfLength;
+    fPENSolid->SetXHalfLength(pen_h[0]);
+    fPENSolid->SetYHalfLength(pen_h[1]);
+    fPENSolid->SetZHalfLength(pen_h[2]);
+    fPENLogical->SetMaterial(WLS_material);
+    fPENPhysical->SetTranslation(G4ThreeVector(layout.pen.center[0], layout.pen.center[1], layout.pen.center[2]));
+    fGuidePhysical->SetTranslation(G4ThreeVector(0., layout.guideOffset, 0.));
+    const G4double* right_c = layout.rightDetector.center;
+    const G4double* left_c = layout.leftDetector.center;
+    fRightDetPhysical->SetTranslation(G4ThreeVector(right_c[0], right_c[1], right_c[2]));
+    fLeftDetPhysical->SetTranslation(G4ThreeVector(left_c[0], left_c[1], left_c[2]));
+
+    SetGuideSurroundings(layout);
+    ReadoutSimVolumeRegistry::Instance()->ComputeEnvelope(fWorldPhysical->GetLogicalVolume());
+
+    // voxels and material-cuts couples are rebuilt at the next run
+    G4RunManager::GetRunManager()->GeometryHasBeenModified();
 }
 
 
@@ -311,61 +517,67 @@ void ReadoutSimDetectorConstruction::setWLSWrap(G4int val)
 
 auto ReadoutSimDetectorConstruction::SetupBaselineDesign() -> G4VPhysicalVolume*
 {
+    // box sizes and positions, shared with the standalone ray tracer
+    ReadoutSimBaselineLayout layout = ComputeLayout();
+
     //
     // World
     //
-    G4double world_hx = 2.5*m;
-    G4double world_hy = 2.5*m;  
-    G4double world_hz = 2.5*m;
-    G4Box* worldSolid = new G4Box("World", world_hx, world_hy, world_hz);
+    const G4double* world_h = layout.world.halfLength;
+    G4Box* worldSolid = new G4Box("World", world_h[0], world_h[1], world_h[2]);
     auto* fWorldLogical  = new G4LogicalVolume(worldSolid, worldMaterial, "World_log");
-    auto* fWorldPhysical = new G4PVPlacement(nullptr, G4ThreeVector(), fWorldLogical, "World_phys", nullptr, false, 0);
+    fWorldPhysical = new G4PVPlacement(nullptr, G4ThreeVector(), fWorldLogical, "World_phys", nullptr, false, 0);
 
     //
     // PMMA panel volume
     //
-    G4double panel_x = 0.5*m;  // 1m
-    G4double panel_y = 0.05*m; // 10cm
-    G4double panel_z = 1.5*m;  // 3m
-    G4Box* panelSolid = new G4Box("Panel", panel_x, panel_y, panel_z);
+    const G4double* panel_h = layout.panel.halfLength;  // 1m x 10cm x 3m
+    G4Box* panelSolid = new G4Box("Panel", panel_h[0], panel_h[1], panel_h[2]);
     auto fPanelLogical = new G4LogicalVolume(panelSolid, PMMA, "Panel_log");
     auto* fPanelPhysical = new G4PVPlacement(nullptr, G4ThreeVector(), fPanelLogical, "Panel_phys", fWorldLogical, false, 0);
 
-
-    // PEN layer thickness, defined here because it changes the position of the small light guide
-    layerThickness = 0.005*cm; //100 micron
-
     //
     // PEN layers around light guide
     //
-    G4double pen_x = panel_x; // 1m 
-    G4double pen_y = 0.005*m + layerThickness * WLS_y;  // 1cm (guide) + PEN foil thickness (WLS_y is 1 for only front, 2 for front and back of guide covered with WLS)
-    G4double pen_z = 0.05*m + layerThickness * 2; // 10cm (guide) + PEN foil thickness on top and bottom of the guide
-    G4Box* penSolid = new G4Box("PENFoil", pen_x, pen_y, pen_z);
-    auto* fPENLogical = new G4LogicalVolume(penSolid, PEN, "PEN_log");
-    auto* fPENPhysical = new G4PVPlacement(nullptr, G4ThreeVector(0., panel_y + pen_y + space, 0.), fPENLogical, "PEN_phys", fWorldLogical, false, 0);
+    const G4double* pen_h = layout.pen.halfLength;  // guide + PEN foil thickness (WLS_y is 1 for only front, 2 for front and back of guide covered with WLS)
+    const G4double* pen_c = layout.pen.center;
+    fPENSolid = new G4Box("PENFoil", pen_h[0], pen_h[1], pen_h[2]);
+    fPENLogical = new G4LogicalVolume(fPENSolid, WLS_material, "PEN_log");
+    fPENPhysical = new G4PVPlacement(nullptr, G4ThreeVector(pen_c[0], pen_c[1], pen_c[2]), fPENLogical, "PEN_phys", fWorldLogical, false, 0);
     
     //
     // PMMA light guide
     // 
-    G4double guide_x = panel_x;  // 1m 
-    G4double guide_y = 0.005*m;  // 1cm
-    G4double guide_z = 0.05*m;   // 10cm
-    G4Box* guideSolid = new G4Box("Guide", guide_x, guide_y, guide_z);
-    auto* fGuideLogical = new G4LogicalVolume(guideSolid, PMMA, "Guide_log");
-    auto* fGuidePhysical = new G4PVPlacement(nullptr, G4ThreeVector(0., -layerThickness * centerGuide, 0.), fGuideLogical, "Guide_phys", fPENLogical, false, 0);
+    const G4double* guide_h = layout.guide.halfLength;  // 1m x 1cm x 10cm
+    G4Box* guideSolid = new G4Box("Guide", guide_h[0], guide_h[1], guide_h[2]);
+    fGuideLogical = new G4LogicalVolume(guideSolid, PMMA, "Guide_log");
+    fGuidePhysical = new G4PVPlacement(nullptr, G4ThreeVector(0., layout.guideOffset, 0.), fGuideLogical, "Guide_phys", fPENLogical, false, 0);
+
+    // region for the fast TIR transport (ReadoutSimGuideTIRModel)
+    if (!fGuideRegion) fGuideRegion = new G4Region("GuideRegion");
+    fGuideRegion->AddRootLogicalVolume(fGuideLogical);
+
+    SetGuideSurroundings(layout);
 
     //
     // PMMA "detector"
     // this is just a volume to be placed at the end of the guide to counts photons
     // 
-    G4double detector_x = .5*cm;  // 1cm 
-    G4double detector_y = .5*cm;  // 1cm
-    G4double detector_z = 0.05*m;   // 10cm
-    G4Box* detectorSolid    = new G4Box("Detector", detector_x, detector_y, detector_z);
+    const G4double* detector_h = layout.rightDetector.halfLength;  // 1cm x 1cm x 10cm
+    const G4double* right_c = layout.rightDetector.center;
+    const G4double* left_c = layout.leftDetector.center;
+    G4Box* detectorSolid    = new G4Box("Detector", detector_h[0], detector_h[1], detector_h[2]);
     auto* fDetectorLogical  = new G4LogicalVolume(detectorSolid, PMMA, "Detector_log");
-    auto* fRightDetPhysical = new G4PVPlacement(nullptr, G4ThreeVector(panel_x + detector_x, panel_y + pen_y + space, 0.), fDetectorLogical, "RightDetector_phys", fWorldLogical, false, 0);
-    auto* fLeftDetPhysical  = new G4PVPlacement(nullptr, G4ThreeVector(- panel_x - detector_x, panel_y + pen_y + space, 0.), fDetectorLogical, "LeftDetector_phys", fWorldLogical, false, 0);
+    fRightDetPhysical = new G4PVPlacement(nullptr, G4ThreeVector(right_c[0], right_c[1], right_c[2]), fDetectorLogical, "RightDetector_phys", fWorldLogical, false, 0);
+    fLeftDetPhysical  = new G4PVPlacement(nullptr, G4ThreeVector(left_c[0], left_c[1], left_c[2]), fDetectorLogical, "LeftDetector_phys", fWorldLogical, false, 0);
+
+    ReadoutSimVolumeRegistry* registry = ReadoutSimVolumeRegistry::Instance();
+    registry->Register(fWorldPhysical, ReadoutSimVolumeRegistry::kWorld);
+    registry->Register(fPanelPhysical, ReadoutSimVolumeRegistry::kPanel);
+    registry->Register(fPENPhysical, ReadoutSimVolumeRegistry::kPENFoil);
+    registry->Register(fGuidePhysical, ReadoutSimVolumeRegistry::kGuide);
+    registry->Register(fRightDetPhysical, ReadoutSimVolumeRegistry::kRightDetector);
+    registry->Register(fLeftDetPhysical, ReadoutSimVolumeRegistry::kLeftDetector);
 
     auto* yellowVisAtt = new G4VisAttributes(G4Colour::Yellow());
     yellowVisAtt->SetVisibility(true);
@@ -386,6 +598,171 @@ auto ReadoutSimDetectorConstruction::SetupBaselineDesign() -> G4VPhysicalVolume*
     return fWorldPhysical;
 }
 
+auto ReadoutSimDetectorConstruction::SetupModuleDesign() -> G4VPhysicalVolume*
+{
+    // the baseline cell is copied fNumberOfBars times along the panel and the
+    // panel fNumberOfPanels times along x. Copies are G4PVReplica slices (or
+    // one placement per copy, for comparison): the volumes below the slots
+    // exist once, whatever the number of copies.
+    //
+    // World > Array > PanelSlot (x copies) > Panel
+    //                                      > Module > BarSlot (z copies) > PEN > Guide
+    //                                                                   > Right/LeftDetector
+    ReadoutSimBaselineLayout layout = ComputeLayout();
+    ReadoutSimModuleLayout module = ComputeModuleLayout(layout);
+
+    const G4double* panel_h = layout.panel.halfLength;
+    const G4double* pen_h = layout.pen.halfLength;
+    const G4double* detector_h = layout.rightDetector.halfLength;
+    G4double guide_y = layout.pen.center[1];
+
+    // the bar slot holds one cell, centred on the PEN box
+    G4double cell_hx = layout.rightDetector.center[0] + detector_h[0];
+    G4double cell_hy = std::max(pen_h[1], detector_h[1]);
+    // the panel slot holds the panel and the module in front of it
+    G4double slot_low = -panel_h[1];
+    G4double slot_high = guide_y + cell_hy;
+    G4double slot_y = 0.5 * (slot_low + slot_high);
+    G4double slot_hy = 0.5 * (slot_high - slot_low);
+    G4double array_hx = 0.5 * module.nPanels * module.panelPitch;
+
+    //
+    // World, large enough for the array
+    //
+    const G4double* world_h = layout.world.halfLength;
+    G4Box* worldSolid = new G4Box("World", std::max(world_h[0], array_hx + 0.5*m), world_h[1], world_h[2]);
+    auto* fWorldLogical  = new G4LogicalVolume(worldSolid, worldMaterial, "World_log");
+    fWorldPhysical = new G4PVPlacement(nullptr, G4ThreeVector(), fWorldLogical, "World_phys", nullptr, false, 0);
+
+    //
+    // LAr containers of the copies
+    //
+    G4Box* arraySolid = new G4Box("Array", array_hx, slot_hy, panel_h[2]);
+    auto* arrayLogical = new G4LogicalVolume(arraySolid, worldMaterial, "Array_log");
+    auto* arrayPhysical = new G4PVPlacement(nullptr, G4ThreeVector(0., slot_y, 0.), arrayLogical, "Array_phys", fWorldLogical, false, 0);
+
+    G4Box* panelSlotSolid = new G4Box("PanelSlot", 0.5 * module.panelPitch, slot_hy, panel_h[2]);
+    auto* panelSlotLogical = new G4LogicalVolume(panelSlotSolid, worldMaterial, "PanelSlot_log");
+    G4VPhysicalVolume* panelSlotPhysical = nullptr;
+    if (fReplicateSlots)
+        panelSlotPhysical = new G4PVReplica("PanelSlot_phys", panelSlotLogical, arrayLogical, kXAxis, module.nPanels, module.panelPitch);
+    else
+        for (G4int panel = 0; panel < module.nPanels; panel++)
+        {
+            auto* placement = new G4PVPlacement(nullptr, G4ThreeVector(module.PanelOffset(panel), 0., 0.), panelSlotLogical, "PanelSlot_phys", arrayLogical, false, panel);
+            if (!panelSlotPhysical) panelSlotPhysical = placement;
+        }
+
+    G4Box* moduleSolid = new G4Box("Module", cell_hx, cell_hy, panel_h[2]);
+    auto* moduleLogical = new G4LogicalVolume(moduleSolid, worldMaterial, "Module_log");
+    auto* modulePhysical = new G4PVPlacement(nullptr, G4ThreeVector(0., guide_y - slot_y, 0.), moduleLogical, "Module_phys", panelSlotLogical, false, 0);
+
+    G4Box* barSlotSolid = new G4Box("BarSlot", cell_hx, cell_hy, 0.5 * module.barPitch);
+    auto* barSlotLogical = new G4LogicalVolume(barSlotSolid, worldMaterial, "BarSlot_log");
+    G4VPhysicalVolume* barSlotPhysical = nullptr;
+    if (fReplicateSlots)
+        barSlotPhysical = new G4PVReplica("BarSlot_phys", barSlotLogical, moduleLogical, kZAxis, module.nBars, module.barPitch);
+    else
+        for (G4int bar = 0; bar < module.nBars; bar++)
+        {
+            auto* placement = new G4PVPlacement(nullptr, G4ThreeVector(0., 0., module.BarOffset(bar)), barSlotLogical, "BarSlot_phys", moduleLogical, false, bar);
+            if (!barSlotPhysical) barSlotPhysical = placement;
+        }
+
+    //
+    // PMMA panel
+    //
+    G4Box* panelSolid = new G4Box("Panel", panel_h[0], panel_h[1], panel_h[2]);
+    auto* fPanelLogical = new G4LogicalVolume(panelSolid, PMMA, "Panel_log");
+    auto* fPanelPhysical = new G4PVPlacement(nullptr, G4ThreeVector(0., -slot_y, 0.), fPanelLogical, "Panel_phys", panelSlotLogical, false, 0);
+
+    //
+    // one cell: PEN box with the guide, detectors at the guide ends
+    //
+    fPENSolid = new G4Box("PENFoil", pen_h[0], pen_h[1], pen_h[2]);
+    fPENLogical = new G4LogicalVolume(fPENSolid, WLS_material, "PEN_log");
+    fPENPhysical = new G4PVPlacement(nullptr, G4ThreeVector(), fPENLogical, "PEN_phys", barSlotLogical, false, 0);
+
+    const G4double* guide_h = layout.guide.halfLength;
+    G4Box* guideSolid = new G4Box("Guide", guide_h[0], guide_h[1], guide_h[2]);
+    fGuideLogical = new G4LogicalVolume(guideSolid, PMMA, "Guide_log");
+    fGuidePhysical = new G4PVPlacement(nullptr, G4ThreeVector(0., layout.guideOffset, 0.), fGuideLogical, "Guide_phys", fPENLogical, false, 0);
+
+    if (!fGuideRegion) fGuideRegion = new G4Region("GuideRegion");
+    fGuideRegion->AddRootLogicalVolume(fGuideLogical);
+    SetGuideSurroundings(layout);
+
+    G4double detector_x = layout.rightDetector.center[0];
+    G4double detector_y = layout.rightDetector.center[1] - guide_y;
+    G4Box* detectorSolid    = new G4Box("Detector", detector_h[0], detector_h[1], detector_h[2]);
+    auto* fDetectorLogical  = new G4LogicalVolume(detectorSolid, PMMA, "Detector_log");
+    fRightDetPhysical = new G4PVPlacement(nullptr, G4ThreeVector(detector_x, detector_y, 0.), fDetectorLogical, "RightDetector_phys", barSlotLogical, false, 0);
+    fLeftDetPhysical  = new G4PVPlacement(nullptr, G4ThreeVector(-detector_x, detector_y, 0.), fDetectorLogical, "LeftDetector_phys", barSlotLogical, false, 0);
+
+    // few daughters per mother: the voxel limit decides how finely they are sliced
+    for (G4LogicalVolume* logical : {fWorldLogical, arrayLogical, panelSlotLogical, moduleLogical, barSlotLogical})
+        logical->SetSmartless(fSmartless);
+
+    // the most frequent volumes first; the LAr containers all count as
+    // world, further placements of a slot are found by their logical volume
+    ReadoutSimVolumeRegistry* registry = ReadoutSimVolumeRegistry::Instance();
+    registry->Register(fGuidePhysical, ReadoutSimVolumeRegistry::kGuide);
+    registry->Register(fPENPhysical, ReadoutSimVolumeRegistry::kPENFoil);
+    registry->Register(fPanelPhysical, ReadoutSimVolumeRegistry::kPanel);
+    registry->Register(fRightDetPhysical, ReadoutSimVolumeRegistry::kRightDetector);
+    registry->Register(fLeftDetPhysical, ReadoutSimVolumeRegistry::kLeftDetector);
+    registry->Register(fWorldPhysical, ReadoutSimVolumeRegistry::kWorld);
+    registry->Register(barSlotPhysical, ReadoutSimVolumeRegistry::kWorld);
+    registry->Register(modulePhysical, ReadoutSimVolumeRegistry::kWorld);
+    registry->Register(panelSlotPhysical, ReadoutSimVolumeRegistry::kWorld);
+    registry->Register(arrayPhysical, ReadoutSimVolumeRegistry::kWorld);
+    registry->SetModuleLayout(module);
+
+    auto* yellowVisAtt = new G4VisAttributes(G4Colour::Yellow());
+    yellowVisAtt->SetVisibility(true);
+    auto* greyVisAtt = new G4VisAttributes(G4Colour::Grey());
+    greyVisAtt->SetVisibility(true);
+    auto* blueVisAtt = new G4VisAttributes(G4Colour::Blue());
+    blueVisAtt->SetVisibility(true);
+
+    fWorldLogical->SetVisAttributes(yellowVisAtt);
+    for (G4LogicalVolume* logical : {arrayLogical, panelSlotLogical, moduleLogical, barSlotLogical})
+        logical->SetVisAttributes(G4VisAttributes::GetInvisible());
+    fPanelLogical->SetVisAttributes(greyVisAtt);
+    fGuideLogical->SetVisAttributes(greyVisAtt);
+    fPENLogical->SetVisAttributes(blueVisAtt);
+
+    return fWorldPhysical;
+}
+
+void ReadoutSimDetectorConstruction::PrintGeometrySummary(const G4VPhysicalVolume* world, G4double memoryBefore) const
+{
+    // copies as the navigator sees them: every placement below a replica counts once per slice
+    std::function<G4long(const G4LogicalVolume*)> countCopies = [&](const G4LogicalVolume* logical)
+    {
+        G4long copies = 0;
+        for (std::size_t i = 0; i < logical->GetNoDaughters(); i++)
+        {
+            const G4VPhysicalVolume* daughter = logical->GetDaughter(i);
+            copies += daughter->GetMultiplicity() * (1 + countCopies(daughter->GetLogicalVolume()));
+        }
+        return copies;
+    };
+
+    const ReadoutSimModuleLayout& module = ReadoutSimVolumeRegistry::Instance()->GetModuleLayout();
+    G4cout << "\n   Geometry\n";
+    G4cout <<   "---------------------------------\n";
+    G4cout << "  Bars x panels:                   " << std::setw(8) << module.nBars << " x " << module.nPanels
+           << (fReplicateSlots ? " (replica)" : " (placement)") << G4endl;
+    G4cout << "  Readout channels:                " << std::setw(8) << 2 * module.GetNumberOfChannels() << G4endl;
+    G4cout << "  Physical volumes in memory:      " << std::setw(8) << G4PhysicalVolumeStore::GetInstance()->size() << G4endl;
+    G4cout << "  Volume copies:                   " << std::setw(8) << 1 + countCopies(world->GetLogicalVolume()) << G4endl;
+    G4cout << "  Smartless:                       " << std::setw(8) << fSmartless << G4endl;
+    if (memoryBefore > 0.)
+        G4cout << "  Memory of the construction:      " << std::setw(8) << ReadoutSimMemory::GetResident() - memoryBefore << " MB" << G4endl;
+    G4cout <<   "---------------------------------\n";
+}
+
 // auto ReadoutSimDetectorConstruction::SetupBaselineCladding() -> G4VPhysicalVolume*
 // {
 //     //
@@ -548,6 +925,18 @@ void ReadoutSimDetectorConstruction::DefineCommands()
     .SetCandidates("0 1")
     .SetDefaultValue("1");
 
+    fDetectorMessenger->DeclareMethodWithUnit("space", "cm", &ReadoutSimDetectorConstruction::SetSpaceLength)
+    .SetGuidance("Gap between the PMMA panel and the light guide box, setSpaceGuide 1 is 2 cm")
+    .SetParameterName("space", false)
+    .SetRange("space>=0.")
+    .SetDefaultValue("0.");
+
+    fDetectorMessenger->DeclareMethodWithUnit("setFoilThickness", "um", &ReadoutSimDetectorConstruction::SetFoilThickness)
+    .SetGuidance("Thickness of the PEN foil around the light guide")
+    .SetParameterName("thickness", false)
+    .SetRange("thickness>0.")
+    .SetDefaultValue("50.");
+
     fDetectorMessenger->DeclareMethod("setWLSBack", &ReadoutSimDetectorConstruction::SetWLSBack)
     .SetGuidance("Decide whether you want WLS also on the back of the light guide (i.e. between light guide and PMMA panel)")
     .SetGuidance("0 = without WLS on light guide's back")
@@ -555,4 +944,53 @@ void ReadoutSimDetectorConstruction::DefineCommands()
     .SetCandidates("0 1")
     .SetDefaultValue("0");
 
+    auto fModuleMessenger = new G4GenericMessenger(this, "/RS/module/", "Commands for the bar module and the panel array");
+
+    fModuleMessenger->DeclareMethod("bars", &ReadoutSimDetectorConstruction::SetNumberOfBars)
+    .SetGuidance("Number of light guide bars along each panel, 12 for the full module")
+    .SetGuidance("1 bar on 1 panel is the single-guide baseline design")
+    .SetParameterName("N", false)
+    .SetRange("N>=1")
+    .SetDefaultValue("1")
+    .SetToBeBroadcasted(false);
+
+    fModuleMessenger->DeclareMethod("panels", &ReadoutSimDetectorConstruction::SetNumberOfPanels)
+    .SetGuidance("Number of panels side by side along x, each with its module of bars")
+    .SetParameterName("N", false)
+    .SetRange("N>=1")
+    .SetDefaultValue("1")
+    .SetToBeBroadcasted(false);
+
+    fModuleMessenger->DeclareMethodWithUnit("panelGap", "cm", &ReadoutSimDetectorConstruction::SetPanelGap)
+    .SetGuidance("Gap between the end detectors of neighbouring panels")
+    .SetParameterName("gap", false)
+    .SetRange("gap>=0.")
+    .SetDefaultValue("0.")
+    .SetToBeBroadcasted(false);
+
+    fModuleMessenger->DeclareMethod("placement", &ReadoutSimDetectorConstruction::SetPlacement)
+    .SetGuidance("How the bar and panel copies are placed")
+    .SetGuidance("replica = one G4PVReplica per level, the same memory for any number of copies")
+    .SetGuidance("placement = one G4PVPlacement per copy, for comparison")
+    .SetCandidates("replica placement")
+    .SetDefaultValue("replica")
+    .SetToBeBroadcasted(false);
+
+    fModuleMessenger->DeclareMethod("smartless", &ReadoutSimDetectorConstruction::SetSmartless)
+    .SetGuidance("Voxel limit (G4LogicalVolume::SetSmartless) of the world and of the module containers")
+    .SetParameterName("smartless", false)
+    .SetRange("smartless>0.")
+    .SetDefaultValue("2.")
+    .SetToBeBroadcasted(false);
+
+    auto fFastSimMessenger = new G4GenericMessenger(this, "/RS/fastsim/", "Commands for controlling fast simulation models");
+
+    fFastSimMessenger->DeclareMethod("guideTIR", &ReadoutSimDetectorConstruction::SetGuideTIR)
+    .SetGuidance("Transport photons trapped by total internal reflection in the light guide in one step")
+    .SetGuidance("0 = full Geant4 tracking (reference)")
+    .SetGuidance("1 = closed-form transport to the guide ends, the default with ReadoutSim -g")
+    .SetGuidance("Needs the fast-simulation physics of ReadoutSim -g")
+    .SetParameterName("enable", false)
+    .SetDefaultValue("0")
+    .SetToBeBroadcasted(false);
 }
\ No newline at end of file
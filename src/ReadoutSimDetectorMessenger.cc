@@ -6,12 +6,16 @@
 #include "G4UIcommand.hh"
 
 DetectorMessenger::DetectorMessenger(ReadoutSimDetectorConstruction* Det)
+    : fDetector(Det)
 {
     fReadoutSimDir = new G4UIdirectory("/readoutsim/");
     fReadoutSimDir->SetGuidance("Parameters for optical simulation.");
 
     fGeometryTypeCmd = new G4UIcmdWithAString("/readoutsim/geometryType", this);
     fGeometryTypeCmd->SetGuidance("Geometry type.");
+    fGeometryTypeCmd->SetGuidance("baseline = PMMA panel read out by a PEN-wrapped light guide");
+    fGeometryTypeCmd->SetParameterName("type", false);
+    fGeometryTypeCmd->SetCandidates("baseline");
     fGeometryTypeCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
     fGeometryTypeCmd->SetToBeBroadcasted(false);
 }
@@ -19,13 +23,10 @@ DetectorMessenger::DetectorMessenger(ReadoutSimDetectorConstruction* Det)
 DetectorMessenger::~DetectorMessenger()
 {
     delete fGeometryTypeCmd;
+    delete fReadoutSimDir;
 }
 
 void DetectorMessenger::SetNewValue(G4UIcommand* command,G4String newValue)
 {
-    if(command == fGeometryTypeCmd)
-    {
-        if (newValue != "baseline" && newValue != "baselineCladding") G4cerr << "No geometry with that name.";
-        else fDetector->SetGeometry(newValue);
-    }
+    if(command == fGeometryTypeCmd) fDetector->SetGeometry(newValue);
 }
\ No newline at end of file
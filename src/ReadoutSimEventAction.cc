@@ -0,0 +1,68 @@
+#include "ReadoutSimEventAction.hh"
+#include "ReadoutSimLightMap.hh"
+#include "ReadoutSimVolumeRegistry.hh"
+
+#include "G4Event.hh"
+#include "G4PrimaryVertex.hh"
+#include "G4PrimaryParticle.hh"
+#include "G4RunManager.hh"
+
+#include "Run.hh"
+
+ReadoutSimEventAction::ReadoutSimEventAction()
+: G4UserEventAction()
+{
+    fLightMap = nullptr;
+}
+
+ReadoutSimEventAction::~ReadoutSimEventAction()
+{}
+
+void ReadoutSimEventAction::BeginOfEventAction(const G4Event* event)
+{
+    fPrimaries.clear();
+
+    Run* run = static_cast<Run*>(G4RunManager::GetRunManager()->GetNonConstCurrentRun());
+
+    // from the vertices, photons killed before tracking count as well
+    for (G4int i = 0; i < event->GetNumberOfPrimaryVertex(); i++)
+    {
+        const G4PrimaryVertex* vertex = event->GetPrimaryVertex(i);
+        run->FillSource(vertex->GetX0(), vertex->GetZ0(), vertex->GetWeight());
+    }
+
+    fLightMap = run->IsFillingLightMap() ? run->GetLightMap() : nullptr;
+    if (!fLightMap) return;
+
+    // the primaries are already generated, and get track IDs 1, 2, ... in
+    // the order of the vertices, one photon per vertex
+    const ReadoutSimModuleLayout& module = ReadoutSimVolumeRegistry::Instance()->GetModuleLayout();
+    for (G4int i = 0; i < event->GetNumberOfPrimaryVertex(); i++)
+    {
+        const G4PrimaryVertex* vertex = event->GetPrimaryVertex(i);
+        const G4PrimaryParticle* photon = vertex->GetPrimary();
+        // the map is of one cell: back to the frame of its bar
+        G4ThreeVector position = vertex->GetPosition();
+        position.setX(position.x() - module.PanelOffset(module.FindPanel(position.x())));
+        position.setZ(position.z() - module.BarOffset(module.FindBar(position.z())));
+        Primary primary;
+        primary.bin = fLightMap->GetBin(position, photon->GetMomentumDirection());
+        primary.weight = vertex->GetWeight();
+        primary.right = false;
+        primary.left = false;
+        fPrimaries.push_back(primary);
+    }
+}
+
+void ReadoutSimEventAction::EndOfEventAction(const G4Event*)
+{
+    if (!fLightMap) return;
+    for (const Primary& primary : fPrimaries) fLightMap->Fill(primary.bin, primary.right, primary.left, primary.weight);
+}
+
+void ReadoutSimEventAction::AddDetection(G4int primaryID, G4bool right)
+{
+    if (primaryID < 1 || primaryID > G4int(fPrimaries.size())) return;
+    if (right) fPrimaries[primaryID - 1].right = true;
+    else fPrimaries[primaryID - 1].left = true;
+}
@@ -0,0 +1,275 @@
+#include "ReadoutSimGuideTIRModel.hh"
+
+#include "G4FastTrack.hh"
+#include "G4FastStep.hh"
+#include "G4Box.hh"
+#include "G4Material.hh"
+#include "G4MaterialPropertiesTable.hh"
+#include "G4OpticalPhoton.hh"
+#include "G4PhysicalConstants.hh"
+#include "G4SystemOfUnits.hh"
+#include "Randomize.hh"
+
+#include <cfloat>
+
+G4bool ReadoutSimGuideTIRModel::fEnabled = false;
+G4bool ReadoutSimGuideTIRModel::fPhysicsRegistered = false;
+
+namespace
+{
+    // photons are handed back this far before a face, so that the next
+    // Geant4 step is long enough for the boundary process to act
+    const G4double kHandBackDistance = 1.*um;
+
+    G4double GetPropertyValue(const G4Material* material, const char* key, G4double energy)
+    {
+        if (!material) return 0.;
+        G4MaterialPropertiesTable* mpt = material->GetMaterialPropertiesTable();
+        if (!mpt) return 0.;
+        G4MaterialPropertyVector* property = mpt->GetProperty(key);
+        return property ? property->Value(energy) : 0.;
+    }
+
+    // Position and direction along one axis after a path of the given length
+    // between two mirrors at -h and +h. Returns the number of reflections.
+    G4int Fold(G4double position, G4double direction, G4double h, G4double length,
+               G4double& finalPosition, G4double& finalDirection)
+    {
+        G4double width = 2. * h;
+        G4double unfolded = position + h + direction * length;
+        G4double n = std::floor(unfolded / width);
+        G4double r = unfolded - n * width;
+        G4int reflections = G4int(n);
+
+        if (reflections % 2 == 0)
+        {
+            finalPosition = r - h;
+            finalDirection = direction;
+        }
+        else
+        {
+            finalPosition = h - r;
+            finalDirection = -direction;
+        }
+        return std::abs(reflections);
+    }
+
+    // reflectance of unpolarized light going from index n1 to n2, with the
+    // cosines of the angles of incidence and refraction
+    G4double FresnelReflectance(G4double n1, G4double n2, G4double cos1, G4double cos2)
+    {
+        G4double rs = (n1 * cos1 - n2 * cos2) / (n1 * cos1 + n2 * cos2);
+        G4double rp = (n2 * cos1 - n1 * cos2) / (n2 * cos1 + n1 * cos2);
+        return 0.5 * (rs * rs + rp * rp);
+    }
+}
+
+ReadoutSimGuideTIRModel::ReadoutSimGuideTIRModel(const G4String& name, G4Region* region, const Surroundings* surroundings)
+: G4VFastSimulationModel(name, region)
+{
+    fSurroundings = surroundings;
+}
+
+ReadoutSimGuideTIRModel::~ReadoutSimGuideTIRModel()
+{}
+
+G4bool ReadoutSimGuideTIRModel::IsApplicable(const G4ParticleDefinition& particle)
+{
+    return &particle == G4OpticalPhoton::OpticalPhotonDefinition();
+}
+
+G4double ReadoutSimGuideTIRModel::FaceHit(const Path& path, G4int face) const
+{
+    G4int axis = 1 + face / 2;
+    G4bool plusFace = (face % 2 == 1);
+    G4double u = path.direction[axis];
+    if (u == 0.) return DBL_MAX;
+
+    // the photon hits the face it moves towards first, the other one a period later
+    G4bool towardFace = (u > 0.) == plusFace;
+    return towardFace ? path.firstHit[axis] : path.firstHit[axis] + path.period[axis];
+}
+
+G4bool ReadoutSimGuideTIRModel::ComputePath(const G4FastTrack& fastTrack, Path& path) const
+{
+    const G4Track* track = fastTrack.GetPrimaryTrack();
+    const G4Box* box = dynamic_cast<const G4Box*>(fastTrack.GetEnvelopeSolid());
+    if (!box || !fSurroundings) return false;
+
+    G4double energy = track->GetKineticEnergy();
+    path.refractiveIndex = GetPropertyValue(track->GetMaterial(), "RINDEX", energy);
+    path.absorptionLength = GetPropertyValue(track->GetMaterial(), "ABSLENGTH", energy);
+    if (path.refractiveIndex <= 0.) return false;
+
+    path.position = fastTrack.GetPrimaryTrackLocalPosition();
+    path.direction = fastTrack.GetPrimaryTrackLocalDirection();
+    path.halfLength[0] = box->GetXHalfLength();
+    path.halfLength[1] = box->GetYHalfLength();
+    path.halfLength[2] = box->GetZHalfLength();
+
+    for (G4int axis = 0; axis < 3; axis++)
+    {
+        G4double u = path.direction[axis];
+        G4double h = path.halfLength[axis];
+        G4double p = path.position[axis];
+        if (u == 0.)
+        {
+            path.firstHit[axis] = DBL_MAX;
+            path.period[axis] = DBL_MAX;
+            continue;
+        }
+        path.firstHit[axis] = std::max(0., u > 0. ? h - p : p + h) / std::fabs(u);
+        path.period[axis] = 2. * h / std::fabs(u);
+    }
+    path.endLength = path.firstHit[0];
+
+    // reflection at each side face: n sin(theta) is the same in the guide,
+    // in the foil and outside, so the outermost interface decides on TIR
+    G4double n = path.refractiveIndex;
+    path.escapeLength = DBL_MAX;
+    for (G4int face = 0; face < kNumberOfFaces; face++)
+    {
+        G4int axis = 1 + face / 2;
+        G4double cosTheta = std::fabs(path.direction[axis]);
+        G4double nSin2 = n * n * (1. - cosTheta * cosTheta);
+
+        const G4Material* foil = fSurroundings->foilMaterial[face];
+        G4double foilIndex = GetPropertyValue(foil, "RINDEX", energy);
+        G4double outerIndex = GetPropertyValue(fSurroundings->outerMaterial[face], "RINDEX", energy);
+
+        path.trapped[face] = false;
+        path.foilAbsorption[face] = 0.;
+
+        if (foil && foilIndex <= 0.)
+        {
+            // Geant4 absorbs at a boundary without RINDEX: leave it to full tracking
+        }
+        else if (foil && nSin2 > foilIndex * foilIndex)
+        {
+            // reflected at the guide surface, the photon never enters the foil
+            path.trapped[face] = true;
+        }
+        else if (outerIndex > 0. && nSin2 > outerIndex * outerIndex)
+        {
+            path.trapped[face] = true;
+            if (foil)
+            {
+                G4double foilCos = std::sqrt(1. - nSin2 / (foilIndex * foilIndex));
+                G4double foilPath = 2. * fSurroundings->foilThickness[face] / foilCos;
+                G4double invLength = 0.;
+                G4double absLength = GetPropertyValue(foil, "ABSLENGTH", energy);
+                G4double wlsLength = GetPropertyValue(foil, "WLSABSLENGTH", energy);
+                if (absLength > 0.) invLength += 1. / absLength;
+                if (wlsLength > 0.) invLength += 1. / wlsLength;
+                G4double survival = std::exp(-foilPath * invLength);
+
+                // Fresnel reflection at the guide surface, unpolarized: the
+                // photon enters the foil with T and goes back and forth in it,
+                // leaving through the guide surface with T after every pass
+                G4double reflectance = FresnelReflectance(n, foilIndex, cosTheta, foilCos);
+                G4double transmittance = 1. - reflectance;
+                path.foilAbsorption[face] = transmittance * (1. - survival) / (1. - reflectance * survival);
+            }
+        }
+
+        if (!path.trapped[face]) path.escapeLength = std::min(path.escapeLength, FaceHit(path, face));
+    }
+
+    return true;
+}
+
+G4bool ReadoutSimGuideTIRModel::ModelTrigger(const G4FastTrack& fastTrack)
+{
+    if (!fEnabled) return false;
+
+    Path path;
+    if (!ComputePath(fastTrack, path)) return false;
+
+    // a photon handed back before a foil leaves the crossing to Geant4
+    for (G4int face = 0; face < kNumberOfFaces; face++)
+        if (path.foilAbsorption[face] > 0. && FaceHit(path, face) <= 2. * kHandBackDistance) return false;
+
+    // the fast step must skip at least one reflection to be worth it,
+    // this also leaves photons handed back before a face to Geant4
+    G4double firstWall = std::min(path.firstHit[1], path.firstHit[2]);
+    G4double length = std::min(path.endLength, path.escapeLength);
+    if (length == DBL_MAX)
+    {
+        // bouncing forever between side faces: only absorption or a foil ends it
+        G4bool absorbing = path.absorptionLength > 0.;
+        for (G4int face = 0; face < kNumberOfFaces; face++)
+            if (path.foilAbsorption[face] > 0. && FaceHit(path, face) < DBL_MAX) absorbing = true;
+        return absorbing;
+    }
+    return length > firstWall + kHandBackDistance;
+}
+
+void ReadoutSimGuideTIRModel::DoIt(const G4FastTrack& fastTrack, G4FastStep& fastStep)
+{
+    Path path;
+    ComputePath(fastTrack, path);
+
+    // first of: end face, escape face, bulk absorption, foil absorption;
+    // absorption and re-emission in the foil are left to Geant4, only the
+    // bounce where the photon is likely absorbed there is sampled here
+    G4double length = std::min(path.endLength, path.escapeLength);
+    G4bool absorbed = false;
+
+    if (path.absorptionLength > 0.)
+    {
+        G4double bulkLength = -path.absorptionLength * std::log(1. - G4UniformRand());
+        if (bulkLength < length)
+        {
+            length = bulkLength;
+            absorbed = true;
+        }
+    }
+
+    for (G4int face = 0; face < kNumberOfFaces; face++)
+    {
+        G4double p = path.foilAbsorption[face];
+        if (!path.trapped[face] || p <= 0.) continue;
+        G4double firstHit = FaceHit(path, face);
+        if (firstHit == DBL_MAX) continue;
+
+        // index of the first reflection on this face that is absorbed
+        G4double reflections = p < 1. ? std::floor(std::log(1. - G4UniformRand()) / std::log(1. - p)) : 0.;
+        G4double foilLength = firstHit + reflections * 2. * path.period[1 + face / 2];
+        if (foilLength < length)
+        {
+            length = foilLength;
+            absorbed = false;
+        }
+    }
+
+    // hand back slightly before the face, so that Geant4 handles the crossing
+    if (!absorbed) length = std::max(0., length - kHandBackDistance);
+
+    G4ThreeVector position, direction;
+    G4ThreeVector polarization = fastTrack.GetPrimaryTrackLocalPolarization();
+    for (G4int axis = 0; axis < 3; axis++)
+    {
+        G4double finalPosition, finalDirection;
+        G4int reflections = Fold(path.position[axis], path.direction[axis], path.halfLength[axis],
+                                 length, finalPosition, finalDirection);
+        position[axis] = finalPosition;
+        direction[axis] = finalDirection;
+
+        // a mirror keeps the normal component of the polarization and flips the others
+        if (reflections % 2 == 1)
+        {
+            G4double normal = polarization[axis];
+            polarization = -polarization;
+            polarization[axis] = normal;
+        }
+    }
+
+    const G4Track* track = fastTrack.GetPrimaryTrack();
+    fastStep.ProposePrimaryTrackFinalPosition(position);
+    fastStep.ProposePrimaryTrackFinalMomentumDirection(direction);
+    fastStep.ProposePrimaryTrackFinalPolarization(polarization);
+    fastStep.ProposePrimaryTrackFinalTime(track->GetGlobalTime() + length * path.refractiveIndex / c_light);
+    fastStep.ProposePrimaryTrackPathLength(length);
+
+    if (absorbed) fastStep.ProposeTrackStatus(fStopAndKill);
+}
@@ -0,0 +1,94 @@
+#include "ReadoutSimHistogram.hh"
+
+#include "TH1D.h"
+#include "TH2D.h"
+
+#include <cmath>
+#include <iostream>
+
+ReadoutSimHistogram::ReadoutSimHistogram(const G4String& name, const G4String& title,
+                                         G4int nx, G4double xmin, G4double xmax)
+: fName(name), fTitle(title)
+{
+    fX = {nx, nx + 2, xmin, xmax};
+    fY = {0, 1, 0., 0.};
+    fCounts.assign(fX.cells, 0.);
+    fSquares.assign(fX.cells, 0.);
+    fEntries = 0.;
+}
+
+ReadoutSimHistogram::ReadoutSimHistogram(const G4String& name, const G4String& title,
+                                         G4int nx, G4double xmin, G4double xmax,
+                                         G4int ny, G4double ymin, G4double ymax)
+: fName(name), fTitle(title)
+{
+    fX = {nx, nx + 2, xmin, xmax};
+    fY = {ny, ny + 2, ymin, ymax};
+    fCounts.assign(fX.cells * fY.cells, 0.);
+    fSquares.assign(fX.cells * fY.cells, 0.);
+    fEntries = 0.;
+}
+
+void ReadoutSimHistogram::Add(const ReadoutSimHistogram& other)
+{
+    if (other.fCounts.size() != fCounts.size()) return;
+    for (std::size_t i = 0; i < fCounts.size(); i++)
+    {
+        fCounts[i] += other.fCounts[i];
+        fSquares[i] += other.fSquares[i];
+    }
+    fEntries += other.fEntries;
+}
+
+void ReadoutSimHistogram::Write() const
+{
+    // the cells are laid out like the ROOT bins, under/overflow included;
+    // with weights other than 1 the errors are not the square roots of the contents
+    G4bool weighted = fSquares != fCounts;
+    if (fY.bins == 0)
+    {
+        TH1D histogram(fName, fTitle, fX.bins, fX.min, fX.max);
+        if (weighted) histogram.Sumw2();
+        for (G4int i = 0; i < fX.cells; i++)
+        {
+            histogram.SetBinContent(i, fCounts[i]);
+            if (weighted) histogram.SetBinError(i, std::sqrt(fSquares[i]));
+        }
+        histogram.SetEntries(fEntries);
+        histogram.Write();
+    }
+    else
+    {
+        TH2D histogram(fName, fTitle, fX.bins, fX.min, fX.max, fY.bins, fY.min, fY.max);
+        if (weighted) histogram.Sumw2();
+        for (G4int i = 0; i < fX.cells; i++)
+            for (G4int j = 0; j < fY.cells; j++)
+            {
+                histogram.SetBinContent(i, j, fCounts[i * fY.cells + j]);
+                if (weighted) histogram.SetBinError(i, j, std::sqrt(fSquares[i * fY.cells + j]));
+            }
+        histogram.SetEntries(fEntries);
+        histogram.Write();
+    }
+}
+
+void ReadoutSimHistogram::Save(std::ostream& out) const
+{
+    out << fName << " " << fX.bins << " " << fY.bins << " " << fEntries << "\n";
+    for (std::size_t i = 0; i < fCounts.size(); i++) out << fCounts[i] << (i + 1 < fCounts.size() ? " " : "\n");
+    for (std::size_t i = 0; i < fSquares.size(); i++) out << fSquares[i] << (i + 1 < fSquares.size() ? " " : "\n");
+}
+
+G4bool ReadoutSimHistogram::Load(std::istream& in)
+{
+    std::string name;
+    G4int nx, ny;
+    G4double entries;
+    in >> name >> nx >> ny >> entries;
+    if (!in || name != fName || nx != fX.bins || ny != fY.bins) return false;
+    for (G4double& count : fCounts) in >> count;
+    for (G4double& square : fSquares) in >> square;
+    if (!in) return false;
+    fEntries = entries;
+    return true;
+}
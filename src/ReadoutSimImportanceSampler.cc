@@ -0,0 +1,63 @@
+#include "ReadoutSimImportanceSampler.hh"
+
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <cmath>
+
+ReadoutSimImportanceSampler::ReadoutSimImportanceSampler(const ReadoutSimLightMap& map, G4double uniformFraction)
+{
+    for (G4int axis = 0; axis < ReadoutSimLightMap::kNumberOfAxes; axis++)
+        fBins[axis] = map.GetNumberOfBins(ReadoutSimLightMap::Axis(axis));
+
+    G4int n = map.GetNumberOfBins();
+    G4double entries = 0., detected = 0.;
+    for (G4int bin = 0; bin < n; bin++)
+    {
+        entries += map.GetEntries(bin);
+        detected += map.GetDetected(bin);
+    }
+    G4double mean = entries > 0. ? detected / entries : 0.;
+
+    // one pseudo-photon at the mean probability per bin: bins the pilot
+    // barely saw stay close to the average instead of at 0 or 1
+    std::vector<G4double> amplitudes(n);
+    G4double sum = 0.;
+    for (G4int bin = 0; bin < n; bin++)
+    {
+        amplitudes[bin] = std::sqrt((map.GetDetected(bin) + mean) / (map.GetEntries(bin) + 1.));
+        sum += amplitudes[bin];
+    }
+    // nothing detected in the pilot: nothing to learn from
+    if (!(sum > 0.)) uniformFraction = 1.;
+
+    std::vector<G4double> probabilities(n);
+    fWeights.resize(n);
+    fMinWeight = 0.;
+    fMaxWeight = 0.;
+    for (G4int bin = 0; bin < n; bin++)
+    {
+        probabilities[bin] = uniformFraction / n + (uniformFraction < 1. ? (1. - uniformFraction) * amplitudes[bin] / sum : 0.);
+        fWeights[bin] = 1. / (n * probabilities[bin]);
+        fMinWeight = bin == 0 ? fWeights[bin] : std::min(fMinWeight, fWeights[bin]);
+        fMaxWeight = std::max(fMaxWeight, fWeights[bin]);
+    }
+    fAlias.Build(probabilities);
+}
+
+G4double ReadoutSimImportanceSampler::Sample(G4double rnd[4]) const
+{
+    G4double fraction;
+    G4int bin = fAlias.Sample(G4UniformRand(), fraction);
+
+    // bin numbers as in ReadoutSimLightMap::GetBin(), the last axis fastest;
+    // the axes are those of the random numbers of ReadoutSimSource::Sample()
+    G4int index = bin;
+    for (G4int axis = ReadoutSimLightMap::kNumberOfAxes - 1; axis >= 0; axis--)
+    {
+        G4int i = index % fBins[axis];
+        index /= fBins[axis];
+        rnd[axis] = (i + (axis == 0 ? fraction : G4UniformRand())) / fBins[axis];
+    }
+    return fWeights[bin];
+}
@@ -0,0 +1,133 @@
+#include "ReadoutSimLightMap.hh"
+#include "ReadoutSimSource.hh"
+
+#include "G4PhysicalConstants.hh"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+    const char* kAxisNames[ReadoutSimLightMap::kNumberOfAxes] = {"x", "z", "u", "v"};
+}
+
+ReadoutSimLightMap::ReadoutSimLightMap(G4int nx, G4int nz, G4int nu, G4int nv)
+{
+    fBins[kX] = nx;
+    fBins[kZ] = nz;
+    fBins[kU] = nu;
+    fBins[kV] = nv;
+
+    fMin[kX] = -ReadoutSimSource::xHalfWidth;
+    fMax[kX] = ReadoutSimSource::xHalfWidth;
+    fMin[kZ] = -ReadoutSimSource::zHalfWidth;
+    fMax[kZ] = ReadoutSimSource::zHalfWidth;
+    fMin[kU] = -1.;
+    fMax[kU] = 1.;
+    fMin[kV] = -halfpi;
+    fMax[kV] = halfpi;
+
+    fCounts.assign(nx * nz * nu * nv * kEntriesPerBin, 0.);
+}
+
+G4int ReadoutSimLightMap::GetBin(const G4ThreeVector& position, const G4ThreeVector& direction) const
+{
+    G4double xyz[3] = {direction.x(), direction.y(), direction.z()};
+    G4double value[kNumberOfAxes];
+    value[kX] = position.x();
+    value[kZ] = position.z();
+    ReadoutSimSource::Angles(xyz, value[kU], value[kV]);
+
+    // points outside the source go to the edge bins
+    G4int bin = 0;
+    for (G4int axis = 0; axis < kNumberOfAxes; axis++)
+    {
+        G4int i = G4int((value[axis] - fMin[axis]) / (fMax[axis] - fMin[axis]) * fBins[axis]);
+        i = std::min(std::max(i, 0), fBins[axis] - 1);
+        bin = bin * fBins[axis] + i;
+    }
+    return bin;
+}
+
+void ReadoutSimLightMap::Fill(G4int bin, G4bool right, G4bool left, G4double weight)
+{
+    G4double* counts = &fCounts[bin * kEntriesPerBin];
+    counts[0] += weight;
+    if (right && left) counts[kBoth] += weight;
+    else if (right) counts[kRight] += weight;
+    else if (left) counts[kLeft] += weight;
+}
+
+void ReadoutSimLightMap::Add(const ReadoutSimLightMap& other)
+{
+    if (other.fCounts.size() != fCounts.size()) return;
+    for (std::size_t i = 0; i < fCounts.size(); i++) fCounts[i] += other.fCounts[i];
+}
+
+G4double ReadoutSimLightMap::GetEntries() const
+{
+    G4double entries = 0.;
+    for (G4int bin = 0; bin < GetNumberOfBins(); bin++) entries += GetEntries(bin);
+    return entries;
+}
+
+G4int ReadoutSimLightMap::GetNumberOfEmptyBins() const
+{
+    G4int empty = 0;
+    for (G4int bin = 0; bin < GetNumberOfBins(); bin++) if (GetEntries(bin) == 0.) empty++;
+    return empty;
+}
+
+G4bool ReadoutSimLightMap::Write(const G4String& fileName) const
+{
+    std::ofstream file(fileName);
+    if (!file) return false;
+
+    file.precision(12);
+    file << "# ReadoutSim light map, lengths in mm\n";
+    file << "# axis nBins min max\n";
+    for (G4int axis = 0; axis < kNumberOfAxes; axis++)
+        file << kAxisNames[axis] << " " << fBins[axis] << " " << fMin[axis] << " " << fMax[axis] << "\n";
+    file << "# bin entries right left both\n";
+    for (G4int bin = 0; bin < GetNumberOfBins(); bin++)
+    {
+        const G4double* counts = &fCounts[bin * kEntriesPerBin];
+        file << bin << " " << counts[0] << " " << counts[kRight] << " " << counts[kLeft] << " " << counts[kBoth] << "\n";
+    }
+    return file.good();
+}
+
+G4bool ReadoutSimLightMap::Read(const G4String& fileName)
+{
+    std::ifstream file(fileName);
+    if (!file) return false;
+
+    G4int axis = 0;
+    G4int nRead = 0;
+    std::string line;
+    while (std::getline(file, line))
+    {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream words(line);
+
+        if (axis < kNumberOfAxes)
+        {
+            std::string name;
+            words >> name >> fBins[axis] >> fMin[axis] >> fMax[axis];
+            if (!words || name != kAxisNames[axis] || fBins[axis] < 1) return false;
+            if (++axis == kNumberOfAxes)
+                fCounts.assign(fBins[kX] * fBins[kZ] * fBins[kU] * fBins[kV] * kEntriesPerBin, 0.);
+            continue;
+        }
+
+        G4int bin;
+        words >> bin;
+        if (!words || bin < 0 || bin >= GetNumberOfBins()) return false;
+        G4double* counts = &fCounts[bin * kEntriesPerBin];
+        words >> counts[0] >> counts[kRight] >> counts[kLeft] >> counts[kBoth];
+        if (!words) return false;
+        nRead++;
+    }
+    return axis == kNumberOfAxes && nRead == GetNumberOfBins();
+}
@@ -0,0 +1,183 @@
+#include "ReadoutSimOpWLS.hh"
+
+#include "G4Track.hh"
+#include "G4Step.hh"
+#include "G4StepPoint.hh"
+#include "G4DynamicParticle.hh"
+#include "G4Material.hh"
+#include "G4MaterialPropertiesTable.hh"
+#include "G4OpticalPhoton.hh"
+#include "G4OpProcessSubType.hh"
+#include "G4PhysicalConstants.hh"
+#include "G4Poisson.hh"
+#include "Randomize.hh"
+
+#include <cfloat>
+
+namespace
+{
+    void GetNodes(const G4MaterialPropertyVector* property, std::vector<G4double>& energy, std::vector<G4double>& value)
+    {
+        energy.clear();
+        value.clear();
+        for (std::size_t i = 0; i < property->GetVectorLength(); i++)
+        {
+            energy.push_back(property->Energy(i));
+            value.push_back((*property)[i]);
+        }
+    }
+}
+
+ReadoutSimOpWLS::ReadoutSimOpWLS(const G4String& processName, G4ProcessType type)
+: G4VDiscreteProcess(processName, type)
+{
+    SetProcessSubType(fOpWLS);
+    fExponentialTime = false;
+    fEmission = "poisson";
+
+    fMessenger = new G4GenericMessenger(this, "/RS/wls/", "Commands for the WLS re-emission");
+    fMessenger->DeclareProperty("emission", fEmission)
+    .SetGuidance("poisson  = a Poisson number of photons with the WLSMEANNUMBERPHOTONS mean")
+    .SetGuidance("weighted = exactly one photon, with the mean number times the weight of the absorbed one")
+    .SetParameterName("mode", false)
+    .SetCandidates("poisson weighted")
+    .SetDefaultValue("poisson");
+
+    fMessenger->DeclareMethod("timeProfile", &ReadoutSimOpWLS::UseTimeProfile)
+    .SetGuidance("delta       = photons emitted at the time of the absorption")
+    .SetGuidance("exponential = delayed by an exponential with the WLSTIMECONSTANT of the material")
+    .SetParameterName("profile", false)
+    .SetCandidates("delta exponential")
+    .SetDefaultValue("delta");
+}
+
+ReadoutSimOpWLS::~ReadoutSimOpWLS()
+{
+    delete fMessenger;
+}
+
+G4bool ReadoutSimOpWLS::IsApplicable(const G4ParticleDefinition& particle)
+{
+    return &particle == G4OpticalPhoton::OpticalPhotonDefinition();
+}
+
+void ReadoutSimOpWLS::UseTimeProfile(G4String name)
+{
+    if (name == "delta") fExponentialTime = false;
+    else if (name == "exponential") fExponentialTime = true;
+    else
+    {
+        G4ExceptionDescription msg;
+        msg << "Unknown WLS time profile " << name << ", keeping "
+            << (fExponentialTime ? "exponential" : "delta");
+        G4Exception("ReadoutSimOpWLS::UseTimeProfile()", "RS0003", JustWarning, msg);
+    }
+}
+
+void ReadoutSimOpWLS::BuildPhysicsTable(const G4ParticleDefinition&)
+{
+    const std::vector<G4Material*>* materials = G4Material::GetMaterialTable();
+    fTables.assign(materials->size(), MaterialTables());
+
+    std::vector<G4double> energy, value;
+    for (const G4Material* material : *materials)
+    {
+        G4MaterialPropertiesTable* mpt = material->GetMaterialPropertiesTable();
+        if (!mpt) continue;
+        MaterialTables& tables = fTables[material->GetIndex()];
+
+        G4MaterialPropertyVector* absorption = mpt->GetProperty("WLSABSLENGTH");
+        if (!absorption) continue;
+        GetNodes(absorption, energy, value);
+        tables.absorptionLength.Build(energy, value);
+
+        G4MaterialPropertyVector* component = mpt->GetProperty("WLSCOMPONENT");
+        if (component)
+        {
+            GetNodes(component, energy, value);
+            tables.emission.Build(energy, value);
+        }
+        if (mpt->ConstPropertyExists("WLSTIMECONSTANT"))
+            tables.timeConstant = mpt->GetConstProperty("WLSTIMECONSTANT");
+        if (mpt->ConstPropertyExists("WLSMEANNUMBERPHOTONS"))
+            tables.meanNumberPhotons = mpt->GetConstProperty("WLSMEANNUMBERPHOTONS");
+    }
+}
+
+G4double ReadoutSimOpWLS::GetMeanFreePath(const G4Track& track, G4double, G4ForceCondition*)
+{
+    std::size_t index = track.GetMaterial()->GetIndex();
+    if (index >= fTables.size() || fTables[index].absorptionLength.IsEmpty()) return DBL_MAX;
+    return fTables[index].absorptionLength.Value(track.GetDynamicParticle()->GetTotalMomentum());
+}
+
+G4VParticleChange* ReadoutSimOpWLS::PostStepDoIt(const G4Track& track, const G4Step& step)
+{
+    aParticleChange.Initialize(track);
+    aParticleChange.ProposeTrackStatus(fStopAndKill);
+
+    std::size_t index = track.GetMaterial()->GetIndex();
+    if (index >= fTables.size() || fTables[index].emission.IsEmpty())
+        return G4VDiscreteProcess::PostStepDoIt(track, step);
+    const MaterialTables& tables = fTables[index];
+
+    // the secondaries get the weight of the track unless it is set here
+    G4bool weighted = IsWeightedEmission() && tables.meanNumberPhotons >= 0.;
+    aParticleChange.SetSecondaryWeightByProcess(weighted);
+
+    G4int nPhotons = 1;
+    if (tables.meanNumberPhotons >= 0. && !weighted)
+    {
+        nPhotons = G4int(G4Poisson(tables.meanNumberPhotons));
+        if (nPhotons <= 0)
+        {
+            aParticleChange.SetNumberOfSecondaries(0);
+            return G4VDiscreteProcess::PostStepDoIt(track, step);
+        }
+    }
+    aParticleChange.SetNumberOfSecondaries(nPhotons);
+
+    const G4StepPoint* postStepPoint = step.GetPostStepPoint();
+    G4double primaryEnergy = track.GetDynamicParticle()->GetKineticEnergy();
+
+    for (G4int i = 0; i < nPhotons; i++)
+    {
+        // the secondary must not have more energy than the primary,
+        // with the same 100 retries as G4OpWLS
+        G4double energy = tables.emission.Sample(G4UniformRand());
+        for (G4int j = 1; j <= 100 && energy > primaryEnergy; j++)
+            energy = tables.emission.Sample(G4UniformRand());
+        if (energy > primaryEnergy)
+        {
+            aParticleChange.SetNumberOfSecondaries(--nPhotons);
+            i--;
+            if (nPhotons == 0) break;
+            continue;
+        }
+
+        // isotropic direction, random polarization perpendicular to it
+        G4double cost = 1. - 2. * G4UniformRand();
+        G4double sint = std::sqrt((1. - cost) * (1. + cost));
+        G4double phi = twopi * G4UniformRand();
+        G4double sinp = std::sin(phi);
+        G4double cosp = std::cos(phi);
+        G4ThreeVector direction(sint * cosp, sint * sinp, cost);
+        G4ThreeVector polarization(cost * cosp, cost * sinp, -sint);
+        G4ThreeVector perp = direction.cross(polarization);
+        phi = twopi * G4UniformRand();
+        polarization = (std::cos(phi) * polarization + std::sin(phi) * perp).unit();
+
+        G4DynamicParticle* photon = new G4DynamicParticle(G4OpticalPhoton::OpticalPhoton(), direction);
+        photon->SetPolarization(polarization.x(), polarization.y(), polarization.z());
+        photon->SetKineticEnergy(energy);
+
+        G4double delay = fExponentialTime ? -tables.timeConstant * std::log(G4UniformRand()) : tables.timeConstant;
+        G4Track* secondary = new G4Track(photon, postStepPoint->GetGlobalTime() + delay, postStepPoint->GetPosition());
+        secondary->SetTouchableHandle(track.GetTouchableHandle());
+        secondary->SetParentID(track.GetTrackID());
+        if (weighted) secondary->SetWeight(track.GetWeight() * tables.meanNumberPhotons);
+        aParticleChange.AddSecondary(secondary);
+    }
+
+    return G4VDiscreteProcess::PostStepDoIt(track, step);
+}
@@ -0,0 +1,35 @@
+#include "ReadoutSimOpticalPhysicsList.hh"
+
+#include "G4OpticalPhysics.hh"
+#include "G4Gamma.hh"
+#include "G4Electron.hh"
+#include "G4Positron.hh"
+#include "G4Proton.hh"
+#include "G4Geantino.hh"
+#include "G4ChargedGeantino.hh"
+
+ReadoutSimOpticalPhysicsList::ReadoutSimOpticalPhysicsList(G4int verbose)
+: G4VModularPhysicsList()
+{
+    SetVerboseLevel(verbose);
+
+    fOpticalPhysics = new G4OpticalPhysics(verbose);
+    RegisterPhysics(fOpticalPhysics);
+}
+
+ReadoutSimOpticalPhysicsList::~ReadoutSimOpticalPhysicsList()
+{}
+
+void ReadoutSimOpticalPhysicsList::ConstructParticle()
+{
+    G4VModularPhysicsList::ConstructParticle();
+
+    // the production cuts table converts ranges for these, and the
+    // kernel expects the geantinos: definitions only, no processes
+    G4Gamma::GammaDefinition();
+    G4Electron::ElectronDefinition();
+    G4Positron::PositronDefinition();
+    G4Proton::ProtonDefinition();
+    G4Geantino::GeantinoDefinition();
+    G4ChargedGeantino::ChargedGeantinoDefinition();
+}
@@ -0,0 +1,164 @@
+#include "ReadoutSimOutputWriter.hh"
+
+#include "TFile.h"
+#include "TTree.h"
+#include "TROOT.h"
+
+#include <chrono>
+
+namespace
+{
+    // records per worker buffer, about 3 MB each
+    const std::size_t kBufferSize = 1 << 16;
+    // records moved from one buffer per pass of the writer
+    const std::size_t kBatchSize = 4096;
+}
+
+ReadoutSimOutputWriter* ReadoutSimOutputWriter::Instance()
+{
+    static ReadoutSimOutputWriter instance;
+    return &instance;
+}
+
+ReadoutSimOutputWriter::ReadoutSimOutputWriter()
+: fStop(false), fRunning(false), fStalls(0)
+{
+    fFile = nullptr;
+    fTree = nullptr;
+    fWritten = 0;
+    fPreviousMaxTreeSize = 0;
+}
+
+ReadoutSimOutputWriter::~ReadoutSimOutputWriter()
+{
+    Close();
+}
+
+G4bool ReadoutSimOutputWriter::Open(const G4String& fileName, G4bool withDirection, G4double maxFileSize)
+{
+    Close();
+
+    // only the writer thread touches ROOT objects after this point
+    ROOT::EnableThreadSafety();
+
+    fFile = TFile::Open(fileName, "RECREATE");
+    if (!fFile || fFile->IsZombie())
+    {
+        G4cerr << "Cannot open " << fileName << ", photon records are not written" << G4endl;
+        delete fFile;
+        fFile = nullptr;
+        return false;
+    }
+
+    fTree = new TTree("Score", "Score");
+    fTree->Branch("initialVolume", &fRow.initialVolume, "initialVolume/I");
+    fTree->Branch("finalVolume", &fRow.finalVolume, "finalVolume/I");
+    fTree->Branch("fate", &fRow.fate, "fate/I");
+    fTree->Branch("xPhotonVertex", &fRow.vertex[0], "xPhotonVertex/F");
+    fTree->Branch("yPhotonVertex", &fRow.vertex[1], "yPhotonVertex/F");
+    fTree->Branch("zPhotonVertex", &fRow.vertex[2], "zPhotonVertex/F");
+    fTree->Branch("xPhotonFinal", &fRow.position[0], "xPhotonFinal/F");
+    fTree->Branch("yPhotonFinal", &fRow.position[1], "yPhotonFinal/F");
+    fTree->Branch("zPhotonFinal", &fRow.position[2], "zPhotonFinal/F");
+    fTree->Branch("energyFinal", &fRow.energy, "energyFinal/F");
+    fTree->Branch("weight", &fRow.weight, "weight/F");
+    if (withDirection) fTree->Branch("photonDirection", &fRow.direction, "photonDirection/I");
+
+    // maxFileSize in bytes, ROOT switches to a new file when the tree gets
+    // there; the limit is global to ROOT, so only for this run
+    fPreviousMaxTreeSize = TTree::GetMaxTreeSize();
+    if (maxFileSize > 0.) TTree::SetMaxTreeSize(Long64_t(maxFileSize));
+
+    fWritten = 0;
+    fStalls = 0;
+    fStop = false;
+    fThread = std::thread(&ReadoutSimOutputWriter::Loop, this);
+    fRunning = true;
+    return true;
+}
+
+void ReadoutSimOutputWriter::Close()
+{
+    if (!fThread.joinable()) return;
+
+    // the workers are done: drain what is left and stop
+    fRunning = false;
+    fStop = true;
+    fThread.join();
+
+    // after a rotation the tree lives in the last file
+    TFile* file = fTree->GetCurrentFile();
+    file->Write();
+    G4cout << "Photon records written: " << fWritten << " to " << file->GetName();
+    if (fStalls > 0) G4cout << " (" << fStalls << " pushes waited for a full buffer)";
+    G4cout << G4endl;
+    file->Close();
+    delete file;
+    fFile = nullptr;
+    fTree = nullptr;
+    TTree::SetMaxTreeSize(fPreviousMaxTreeSize);
+}
+
+void ReadoutSimOutputWriter::Push(const ReadoutSimPhotonRecord& record)
+{
+    // no file: nothing would ever drain the buffer
+    if (!fRunning) return;
+
+    ReadoutSimRecordBuffer* buffer = GetBuffer();
+    if (buffer->Push(record)) return;
+
+    // the writer is behind, wait for it rather than lose the record
+    fStalls++;
+    while (!buffer->Push(record)) std::this_thread::yield();
+}
+
+ReadoutSimRecordBuffer* ReadoutSimOutputWriter::GetBuffer()
+{
+    static G4ThreadLocal ReadoutSimRecordBuffer* buffer = nullptr;
+    if (!buffer)
+    {
+        std::lock_guard<std::mutex> lock(fBuffersMutex);
+        fBuffers.emplace_back(new ReadoutSimRecordBuffer(kBufferSize));
+        buffer = fBuffers.back().get();
+    }
+    return buffer;
+}
+
+void ReadoutSimOutputWriter::Loop()
+{
+    for (;;)
+    {
+        // read the flag first: records pushed before it was set are drained below
+        G4bool stopping = fStop;
+        std::size_t n = Drain();
+        if (n == 0)
+        {
+            if (stopping) break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+}
+
+std::size_t ReadoutSimOutputWriter::Drain()
+{
+    std::vector<ReadoutSimRecordBuffer*> buffers;
+    {
+        std::lock_guard<std::mutex> lock(fBuffersMutex);
+        for (const auto& buffer : fBuffers) buffers.push_back(buffer.get());
+    }
+
+    static ReadoutSimPhotonRecord records[kBatchSize];
+    std::size_t total = 0;
+    for (ReadoutSimRecordBuffer* buffer : buffers)
+    {
+        std::size_t n = buffer->Pop(records, kBatchSize);
+        for (std::size_t i = 0; i < n; i++)
+        {
+            fRow = records[i];
+            fTree->Fill();
+        }
+        total += n;
+    }
+    fWritten += total;
+    return total;
+}
@@ -0,0 +1,138 @@
+#include "ReadoutSimPhotonBiasing.hh"
+#include "ReadoutSimTrackInformation.hh"
+#include "Run.hh"
+
+#include "G4Step.hh"
+#include "G4DynamicParticle.hh"
+#include "Randomize.hh"
+
+#include <cmath>
+#include <sstream>
+
+ReadoutSimPhotonBiasing::ReadoutSimPhotonBiasing()
+{
+    fRouletteLength = 0.;
+    for (G4int i = 0; i < ReadoutSimVolumeRegistry::kNumberOfVolumes; i++) fRouletteIn[i] = false;
+    fSurvival = 0.5;
+    fGuideSplit = 1;
+    fMinCosine = 0.;
+
+    DefineCommands();
+}
+
+ReadoutSimPhotonBiasing::~ReadoutSimPhotonBiasing()
+{
+    delete fRouletteMessenger;
+    delete fSplitMessenger;
+}
+
+void ReadoutSimPhotonBiasing::Apply(G4Track* track, const G4Step* step, ReadoutSimVolumeRegistry::VolumeID startVolume,
+                                    ReadoutSimVolumeRegistry::VolumeID endVolume, G4TrackVector* secondaries, Run* run) const
+{
+    if (run->IsFillingLightMap()) return;
+
+    G4bool entering = startVolume != endVolume;
+    G4bool roulette = entering && fRouletteIn[endVolume];
+    if (!roulette && fRouletteLength > 0.)
+    {
+        G4double length = track->GetTrackLength();
+        roulette = std::floor(length / fRouletteLength) > std::floor((length - step->GetStepLength()) / fRouletteLength);
+    }
+    if (roulette && !PlayRoulette(track, run)) return;
+
+    if (fGuideSplit > 1 && entering && endVolume == ReadoutSimVolumeRegistry::kGuide
+        && std::abs(track->GetMomentumDirection().x()) >= fMinCosine)
+        Split(track, step, secondaries, run);
+}
+
+G4bool ReadoutSimPhotonBiasing::PlayRoulette(G4Track* track, Run* run) const
+{
+    if (G4UniformRand() < fSurvival)
+    {
+        track->SetWeight(track->GetWeight() / fSurvival);
+        run->AddRoulette(false);
+        return true;
+    }
+    // no weight left for the fate counters
+    track->SetWeight(0.);
+    track->SetTrackStatus(fStopAndKill);
+    run->AddRoulette(true);
+    return false;
+}
+
+void ReadoutSimPhotonBiasing::Split(G4Track* track, const G4Step* step, G4TrackVector* secondaries, Run* run) const
+{
+    ReadoutSimTrackInformation* info = static_cast<ReadoutSimTrackInformation*>(track->GetUserInformation());
+    if (!info || info->IsSplit()) return;
+    info->SetSplit();
+
+    G4double weight = track->GetWeight() / fGuideSplit;
+    track->SetWeight(weight);
+
+    // copies of the photon at the end of the step, with its ancestry, so
+    // that the tracking action does not take them for re-emitted photons
+    const G4StepPoint* point = step->GetPostStepPoint();
+    for (G4int i = 1; i < fGuideSplit; i++)
+    {
+        G4Track* copy = new G4Track(new G4DynamicParticle(*track->GetDynamicParticle()), point->GetGlobalTime(), point->GetPosition());
+        copy->SetTouchableHandle(point->GetTouchableHandle());
+        copy->SetParentID(track->GetTrackID());
+        copy->SetWeight(weight);
+        copy->SetUserInformation(new ReadoutSimTrackInformation(*info));
+        secondaries->push_back(copy);
+    }
+    run->AddSplitCopies(fGuideSplit - 1);
+}
+
+void ReadoutSimPhotonBiasing::SetRouletteVolumes(G4String list)
+{
+    for (G4int i = 0; i < ReadoutSimVolumeRegistry::kNumberOfVolumes; i++) fRouletteIn[i] = false;
+
+    std::istringstream stream(list);
+    std::string word;
+    while (stream >> word)
+    {
+        if (word == "world") fRouletteIn[ReadoutSimVolumeRegistry::kWorld] = true;
+        else if (word == "panel") fRouletteIn[ReadoutSimVolumeRegistry::kPanel] = true;
+        else if (word == "pen") fRouletteIn[ReadoutSimVolumeRegistry::kPENFoil] = true;
+        else if (word == "guide") fRouletteIn[ReadoutSimVolumeRegistry::kGuide] = true;
+        else if (word != "none") G4cerr << "Unknown roulette volume " << word << ", use world, panel, pen or guide" << G4endl;
+    }
+}
+
+void ReadoutSimPhotonBiasing::DefineCommands()
+{
+    fRouletteMessenger = new G4GenericMessenger(this, "/RS/roulette/", "Commands for the Russian roulette of photons");
+
+    fRouletteMessenger->DeclarePropertyWithUnit("length", "cm", fRouletteLength)
+    .SetGuidance("Play roulette every time the track length of a photon crosses a multiple of this, 0 for never")
+    .SetParameterName("length", false)
+    .SetRange("length>=0.")
+    .SetDefaultValue("0.");
+
+    fRouletteMessenger->DeclareMethod("volumes", &ReadoutSimPhotonBiasing::SetRouletteVolumes)
+    .SetGuidance("Play roulette when a photon goes into one of these volumes: world, panel, pen, guide")
+    .SetGuidance("none for no volume")
+    .SetParameterName("volumes", false)
+    .SetDefaultValue("none");
+
+    fRouletteMessenger->DeclareProperty("survival", fSurvival)
+    .SetGuidance("Probability to survive the roulette; the weight of a survivor is divided by it")
+    .SetParameterName("probability", false)
+    .SetRange("probability>0. && probability<=1.")
+    .SetDefaultValue("0.5");
+
+    fSplitMessenger = new G4GenericMessenger(this, "/RS/split/", "Commands for the splitting of photons");
+
+    fSplitMessenger->DeclareProperty("guide", fGuideSplit)
+    .SetGuidance("Split a photon going into the guide in this many photons, 1 for no splitting")
+    .SetParameterName("n", false)
+    .SetRange("n>=1")
+    .SetDefaultValue("1");
+
+    fSplitMessenger->DeclareProperty("minCosine", fMinCosine)
+    .SetGuidance("Split only photons whose direction has at least this |cos| to the guide axis (towards the detectors)")
+    .SetParameterName("cosine", false)
+    .SetRange("cosine>=0. && cosine<=1.")
+    .SetDefaultValue("0.");
+}
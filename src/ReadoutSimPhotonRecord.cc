@@ -0,0 +1,42 @@
+#include "ReadoutSimPhotonRecord.hh"
+
+#include "g4root.hh"
+
+void ReadoutSimPhotonRecord::Book(bool withDirection)
+{
+    G4AnalysisManager* man = G4AnalysisManager::Instance();
+
+    man->CreateNtuple("Score", "Score");
+    man->CreateNtupleIColumn("initialVolume");
+    man->CreateNtupleIColumn("finalVolume");
+    man->CreateNtupleIColumn("fate");
+    man->CreateNtupleFColumn("xPhotonVertex");
+    man->CreateNtupleFColumn("yPhotonVertex");
+    man->CreateNtupleFColumn("zPhotonVertex");
+    man->CreateNtupleFColumn("xPhotonFinal");
+    man->CreateNtupleFColumn("yPhotonFinal");
+    man->CreateNtupleFColumn("zPhotonFinal");
+    man->CreateNtupleFColumn("energyFinal");
+    man->CreateNtupleFColumn("weight");
+    if (withDirection) man->CreateNtupleIColumn("photonDirection");
+    man->FinishNtuple(0);
+}
+
+void ReadoutSimPhotonRecord::AddRow(bool withDirection) const
+{
+    G4AnalysisManager* man = G4AnalysisManager::Instance();
+
+    man->FillNtupleIColumn(0, initialVolume);
+    man->FillNtupleIColumn(1, finalVolume);
+    man->FillNtupleIColumn(2, fate);
+    man->FillNtupleFColumn(3, vertex[0]);
+    man->FillNtupleFColumn(4, vertex[1]);
+    man->FillNtupleFColumn(5, vertex[2]);
+    man->FillNtupleFColumn(6, position[0]);
+    man->FillNtupleFColumn(7, position[1]);
+    man->FillNtupleFColumn(8, position[2]);
+    man->FillNtupleFColumn(9, energy);
+    man->FillNtupleFColumn(10, weight);
+    if (withDirection) man->FillNtupleIColumn(11, direction);
+    man->AddNtupleRow(0);
+}
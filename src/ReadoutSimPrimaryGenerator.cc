@@ -8,30 +8,123 @@
 #include "G4SystemOfUnits.hh"
 #include "Randomize.hh"
 #include "G4RunManager.hh"
+#include "G4PrimaryVertex.hh"
+#include "G4PhysicalConstants.hh"
+#include "G4Exception.hh"
 
 #include "Run.hh"
+#include "ReadoutSimSource.hh"
+#include "ReadoutSimVolumeRegistry.hh"
+#include "ReadoutSimVertexLibrary.hh"
+
+#include <algorithm>
 
 ReadoutSimPrimaryGenerator::ReadoutSimPrimaryGenerator()
 {
     fParticleGun = new G4ParticleGun(1);
+    fPhotonsPerEvent = 1;
+    fNextVertex = 0;
+    fEndVertex = 0;
+    fVertexGeneration = 0;
+
+    // set opticalphoton as primary particle
+    G4ParticleTable *particleTable = G4ParticleTable::GetParticleTable();
+    G4ParticleDefinition *particle = particleTable->FindParticle("opticalphoton"); 
+    fParticleGun->SetParticleDefinition(particle);
+
+    DefineCommands();
 }
 
 ReadoutSimPrimaryGenerator::~ReadoutSimPrimaryGenerator()
 {
     delete fParticleGun;
+    delete fMessenger;
 }
 
 void ReadoutSimPrimaryGenerator::GeneratePrimaries(G4Event* anEvent)
 {
-    // set opticalphoton as primary particle
-    G4ParticleTable *particleTable = G4ParticleTable::GetParticleTable();
-    G4ParticleDefinition *particle = particleTable->FindParticle("opticalphoton"); 
-    fParticleGun->SetParticleDefinition(particle);
+    // light map lookup: the event stays empty, nothing is tracked
+    Run* run = static_cast<Run*>(G4RunManager::GetRunManager()->GetNonConstCurrentRun());
+    if (run && run->IsLookingUpLightMap())
+    {
+        LookUpPhotons(run);
+        return;
+    }
+
+    // vertices from the library instead of the source, all of weight 1
+    if (ReadoutSimVertexLibrary::Instance()->IsOpen())
+    {
+        for (G4int i = 0; i < fPhotonsPerEvent; i++)
+        {
+            if (ReadPhoton(anEvent)) continue;
+            G4ExceptionDescription msg;
+            msg << "Vertex library " << ReadoutSimVertexLibrary::Instance()->GetFileName()
+                << " used up, the run ends here; /RS/source/libraryLoop 1 starts it again instead";
+            G4Exception("ReadoutSimPrimaryGenerator::GeneratePrimaries()", "RS0008", JustWarning, msg);
+            G4RunManager::GetRunManager()->AbortRun(true);
+            break;
+        }
+        return;
+    }
+
+    // one vertex per photon, each sampled independently
+    G4double sourceZHalfWidth = run ? run->GetSourceZHalfWidth() : ReadoutSimSource::zHalfWidth;
+    const ReadoutSimImportanceSampler* sampler = run ? run->GetImportanceSampler() : nullptr;
+    fWeights.clear();
+    for (G4int i = 0; i < fPhotonsPerEvent; i++) fWeights.push_back(GeneratePhoton(anEvent, sourceZHalfWidth, sampler));
+    if (!sampler) return;
+
+    // the gun has no weight: set it on the vertices, whose weight Geant4
+    // gives to the primary tracks and those to their secondaries
+    G4PrimaryVertex* vertex = anEvent->GetPrimaryVertex();
+    for (G4double weight : fWeights)
+    {
+        vertex->SetWeight(weight);
+        vertex = vertex->GetNext();
+    }
+}
+
+void ReadoutSimPrimaryGenerator::LookUpPhotons(Run* run)
+{
+    const ReadoutSimLightMap* map = run->GetLightMap();
+    for (G4int i = 0; i < fPhotonsPerEvent; i++)
+    {
+        // same source sampling as GeneratePhoton(), then a draw of the outcome
+        G4double rnd[4];
+        for (G4int j = 0; j < 4; j++) rnd[j] = G4UniformRand();
 
-    // return integers uniformly distributed in [0, n]
-    G4double pi = 3.14159265359;
-    G4double u = 0.;
-    G4double v = 0.;
+        G4double xyzPos[3], xyzMom[3];
+        ReadoutSimSource::Sample(rnd, xyzPos, xyzMom, run->GetSourceZHalfWidth());
+
+        G4int bin = map->GetBin(G4ThreeVector(xyzPos[0], xyzPos[1], xyzPos[2]), G4ThreeVector(xyzMom[0], xyzMom[1], xyzMom[2]));
+        run->AddLookup(map->Sample(bin, G4UniformRand()), map->GetEntries(bin) == 0.);
+    }
+}
+
+G4bool ReadoutSimPrimaryGenerator::ReadPhoton(G4Event* anEvent)
+{
+    // a new chunk when this one is used up, or void after a rewind
+    ReadoutSimVertexLibrary* library = ReadoutSimVertexLibrary::Instance();
+    if (fNextVertex >= fEndVertex || fVertexGeneration != library->GetGeneration())
+    {
+        if (!library->Claim(fNextVertex, fEndVertex, fVertexGeneration)) return false;
+    }
+    const ReadoutSimVertexRecord& vertex = library->Get(fNextVertex++);
+
+    G4ThreeVector direction(vertex.direction[0], vertex.direction[1], vertex.direction[2]);
+    fParticleGun->SetParticlePosition(G4ThreeVector(vertex.position[0], vertex.position[1], vertex.position[2]) * cm);
+    fParticleGun->SetParticleMomentumDirection(direction.unit());
+    fParticleGun->SetParticleEnergy(vertex.wavelength > 0. ? h_Planck * c_light / (vertex.wavelength * nm) : ReadoutSimSource::energy);
+    fParticleGun->SetParticleTime(vertex.time * ns);
+
+    SetOptPhotonPolar();
+    fParticleGun->GeneratePrimaryVertex(anEvent);
+    return true;
+}
+
+G4double ReadoutSimPrimaryGenerator::GeneratePhoton(G4Event* anEvent, G4double sourceZHalfWidth,
+                                                   const ReadoutSimImportanceSampler* sampler)
+{
 
     // Panel Design
     // position coordinates
@@ -39,19 +132,24 @@ void ReadoutSimPrimaryGenerator::GeneratePrimaries(G4Event* anEvent)
     // G4double yPos = yPosGenerator->Uniform(-0.5, 0.5);
     // G4double zPos = zPosGenerator->Uniform(-1.5, 1.5);
 
-    G4double xPos, yPos, zPos;
-    G4double xMom, yMom, zMom;
-
-    xPos = xPosGenerator->Uniform(-50., 50.);
-    yPos = 7.1;
-    zPos = zPosGenerator->Uniform(-5., 5.);
+    // all sampling goes through the thread-local Geant4 engine, which the
+    // MT run manager reseeds for every event from the master seeds
+    G4double rnd[4];
+    G4double weight = 1.;
+    if (sampler) weight = sampler->Sample(rnd);
+    else for (G4int i = 0; i < 4; i++) rnd[i] = G4UniformRand();
 
-    u = thetaGenerator->Uniform(-1,1);
-    v = phiGenerator->Uniform(-pi/2, pi/2);
+    // module: the source in front of a random bar of a random panel
+    const ReadoutSimModuleLayout& module = ReadoutSimVolumeRegistry::Instance()->GetModuleLayout();
+    G4double xyzPos[3], xyzMom[3];
+    ReadoutSimSource::Sample(rnd, xyzPos, xyzMom, module.IsBaseline() ? sourceZHalfWidth : ReadoutSimSource::zHalfWidth);
 
-    xMom = sqrt(1-u*u) * sin(v);
-    yMom = -sqrt(1-u*u) * cos(v);
-    zMom = u;
+    if (!module.IsBaseline())
+    {
+        G4int cell = std::min(G4int(G4UniformRand() * module.GetNumberOfChannels()), module.GetNumberOfChannels() - 1);
+        xyzPos[0] += module.PanelOffset(cell / module.nBars);
+        xyzPos[2] += module.BarOffset(cell % module.nBars);
+    }
 
     // // Baseline Design
     // if (surface < 0.143)
@@ -119,20 +217,20 @@ void ReadoutSimPrimaryGenerator::GeneratePrimaries(G4Event* anEvent)
     //     xMom = -xMom;
     // } 
 
-    G4ThreeVector position(xPos*cm, yPos*cm, zPos*cm);
-    G4ThreeVector momentum(xMom, yMom, zMom);
-    
-    // G4double energy = 2.88 * eV; // optical photon @ 430nm
-    G4double energy = 9.69 * eV; // VUV photon @ 128nm
+    G4ThreeVector position(xyzPos[0], xyzPos[1], xyzPos[2]);
+    G4ThreeVector momentum(xyzMom[0], xyzMom[1], xyzMom[2]);
+    G4double energy = ReadoutSimSource::energy;
 
     fParticleGun->SetParticlePosition(position);
     fParticleGun->SetParticleMomentumDirection(momentum);
     fParticleGun->SetParticleEnergy(energy);
+    fParticleGun->SetParticleTime(0.);
     
     // set optical photons random polarization
     SetOptPhotonPolar();
     
     fParticleGun->GeneratePrimaryVertex(anEvent);
+    return weight;
 }
 
 void ReadoutSimPrimaryGenerator::SetOptPhotonPolar()
@@ -161,4 +259,16 @@ void ReadoutSimPrimaryGenerator::SetOptPhotonPolar(G4double angle)
     
     G4ThreeVector polar = std::cos(angle)*e_paralle + std::sin(angle)*e_perpend;
     fParticleGun->SetParticlePolarization(polar);
-}
\ No newline at end of file
+}
+
+void ReadoutSimPrimaryGenerator::DefineCommands()
+{
+    fMessenger = new G4GenericMessenger(this, "/RS/gun/", "Commands for controlling the primary photons");
+
+    fMessenger->DeclareProperty("photonsPerEvent", fPhotonsPerEvent)
+    .SetGuidance("Number of optical photons generated in each event")
+    .SetGuidance("Every photon gets its own vertex, position and direction")
+    .SetParameterName("N", false)
+    .SetRange("N>=1")
+    .SetDefaultValue("1");
+}
@@ -0,0 +1,240 @@
+#include "ReadoutSimProcessPool.hh"
+#include "ReadoutSimMemory.hh"
+#include "ReadoutSimVertexLibrary.hh"
+#include "ReadoutSimRunAction.hh"
+#include "Run.hh"
+
+#include "G4RunManager.hh"
+#include "G4UImanager.hh"
+#include "G4UIcommand.hh"
+#include "Randomize.hh"
+
+#include "TFileMerger.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <sys/wait.h>
+#include <unistd.h>
+
+ReadoutSimProcessPool::ReadoutSimProcessPool(G4int nProcesses)
+{
+    fNumberOfProcesses = nProcesses;
+
+    DefineCommands();
+}
+
+ReadoutSimProcessPool::~ReadoutSimProcessPool()
+{
+    delete fMessenger;
+}
+
+void ReadoutSimProcessPool::Run(G4int nEvents)
+{
+    G4UImanager* UImanager = G4UImanager::GetUIpointer();
+    // geometry and physics tables, shared by the children copy-on-write
+    if (UImanager->ApplyCommand("/run/beamOn 0") != 0) return;
+
+    G4bool writeRecords = G4UIcommand::ConvertToBool(UImanager->GetCurrentValues("/RS/output/records"));
+    G4bool asyncRecords = UImanager->GetCurrentValues("/RS/output/backend") == "async"
+                       && G4UIcommand::ConvertToDouble(UImanager->GetCurrentValues("/RS/output/maxFileSize")) == 0.;
+    G4String fileName = UImanager->GetCurrentValues("/RS/output/fileName");
+    G4bool writeHistograms = G4UIcommand::ConvertToBool(UImanager->GetCurrentValues("/RS/output/histograms"));
+    G4String histogramFileName = UImanager->GetCurrentValues("/RS/output/histogramFileName");
+    UImanager->ApplyCommand("/RS/output/histograms 0");
+
+    // seeds of all the children first: they only depend on the parent seeds
+    G4int nProcesses = std::min(fNumberOfProcesses, nEvents);
+    std::vector<long> seeds(3 * nProcesses, 0);
+    for (G4int i = 0; i < nProcesses; i++)
+    {
+        seeds[3 * i] = long(100000000L * G4UniformRand());
+        seeds[3 * i + 1] = long(100000000L * G4UniformRand());
+    }
+
+    G4cout << "\n===== Forking " << nProcesses << " processes for " << nEvents << " events =====" << G4endl;
+    std::cout.flush();
+    std::fflush(nullptr);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<pid_t> children;
+    std::vector<int> pipes;
+    for (G4int i = 0; i < nProcesses; i++)
+    {
+        int fd[2];
+        if (pipe(fd) != 0) break;
+        pid_t pid = fork();
+        if (pid < 0)
+        {
+            close(fd[0]);
+            close(fd[1]);
+            break;
+        }
+        if (pid == 0)
+        {
+            close(fd[0]);
+            for (int other : pipes) close(other);
+            RunChild(i, nEvents / nProcesses + (i < nEvents % nProcesses ? 1 : 0), &seeds[3 * i], fd[1]);
+        }
+        close(fd[1]);
+        children.push_back(pid);
+        pipes.push_back(fd[0]);
+    }
+    if (G4int(children.size()) < nProcesses)
+        G4cerr << "Only " << children.size() << " of " << nProcesses << " processes could be started" << G4endl;
+
+    // the children block on a full pipe until their turn comes
+    ::Run* total = nullptr;
+    G4int nFailed = 0;
+    G4double resident = 0.;
+    G4double proportional = 0.;
+    std::vector<G4String> parts;
+    for (std::size_t i = 0; i < children.size(); i++)
+    {
+        std::istringstream result(ReadAll(pipes[i]));
+        close(pipes[i]);
+        int status = 0;
+        waitpid(children[i], &status, 0);
+
+        std::string memory, source;
+        G4double childResident = 0., childProportional = 0., sourceZHalfWidth = 0.;
+        result >> memory >> childResident >> childProportional >> source >> sourceZHalfWidth;
+        ::Run* part = result ? new ::Run(sourceZHalfWidth) : nullptr;
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0 || !part || !part->Load(result))
+        {
+            G4cerr << "Process f" << i << " failed, its events are missing from the sum" << G4endl;
+            delete part;
+            nFailed++;
+            continue;
+        }
+        resident += childResident;
+        proportional += childProportional;
+        parts.push_back(ReadoutSimRunAction::TagFileName(fileName, "f" + G4UIcommand::ConvertToString(G4int(i))));
+        if (!total) total = part;
+        else
+        {
+            total->Add(*part);
+            delete part;
+        }
+    }
+    std::chrono::duration<G4double> wallTime = std::chrono::steady_clock::now() - start;
+
+    UImanager->ApplyCommand("/RS/run/tag");
+    UImanager->ApplyCommand(G4String("/RS/output/histograms ") + (writeHistograms ? "1" : "0"));
+    if (!total) return;
+
+    total->EndOfRun("all processes");
+    G4cout << "\n   Processes\n";
+    G4cout <<   "---------------------------------\n";
+    G4cout << "  Processes:                       " << std::setw(8) << G4int(children.size()) - nFailed << G4endl;
+    G4cout << "  Wall time:                       " << std::setw(8) << wallTime.count() << " s" << G4endl;
+    G4cout << "  Photons/s:                       " << std::setw(8) << total->GetNumberOfPhotons() / wallTime.count() << G4endl;
+    if (resident > 0.)
+        G4cout << "  Resident memory, sum:            " << std::setw(8) << resident << " MB" << G4endl;
+    if (proportional > 0.)
+        G4cout << "  Proportional memory, sum:        " << std::setw(8) << proportional << " MB" << G4endl;
+    G4cout <<   "---------------------------------\n";
+
+    if (writeHistograms)
+    {
+        if (total->WriteHistograms(histogramFileName))
+            G4cout << "Histograms of all processes written to " << histogramFileName << G4endl;
+        else
+            G4cerr << "Cannot write the histograms to " << histogramFileName << G4endl;
+    }
+    if (writeRecords && asyncRecords && nFailed == 0)
+    {
+        if (MergeRecords(fileName, parts))
+            G4cout << "Photon records of all processes merged into " << fileName << G4endl;
+        else
+            G4cerr << "Cannot merge the photon records into " << fileName << ", the files of the processes are kept" << G4endl;
+    }
+    delete total;
+}
+
+void ReadoutSimProcessPool::RunChild(G4int index, G4int nEvents, const long* seeds, int fd)
+{
+    G4Random::setTheSeeds(seeds);
+    ReadoutSimVertexLibrary::Instance()->ForgetChunks();
+
+    G4UImanager* UImanager = G4UImanager::GetUIpointer();
+    UImanager->ApplyCommand("/RS/run/tag f" + G4UIcommand::ConvertToString(index));
+    G4int status = UImanager->ApplyCommand("/run/beamOn " + G4UIcommand::ConvertToString(nEvents));
+
+    const ::Run* run = static_cast<const ::Run*>(G4RunManager::GetRunManager()->GetCurrentRun());
+    G4bool written = false;
+    if (status == 0 && run)
+    {
+        std::ostringstream result;
+        result.precision(17);
+        result << "memory " << ReadoutSimMemory::GetResident() << " " << ReadoutSimMemory::GetProportional() << "\n";
+        result << "source " << run->GetSourceZHalfWidth() << "\n";
+        run->Save(result);
+        written = WriteAll(fd, result.str());
+    }
+    close(fd);
+
+    // the parent owns the job: no destructors, no atexit handlers
+    std::cout.flush();
+    std::fflush(nullptr);
+    _exit(written ? 0 : 1);
+}
+
+G4String ReadoutSimProcessPool::ReadAll(int fd)
+{
+    std::string data;
+    char buffer[65536];
+    ssize_t n;
+    while ((n = read(fd, buffer, sizeof(buffer))) != 0)
+    {
+        if (n > 0) data.append(buffer, n);
+        else if (errno != EINTR) break;
+    }
+    return data;
+}
+
+G4bool ReadoutSimProcessPool::WriteAll(int fd, const std::string& data)
+{
+    std::size_t done = 0;
+    while (done < data.size())
+    {
+        ssize_t n = write(fd, data.data() + done, data.size() - done);
+        if (n > 0) done += n;
+        else if (n < 0 && errno != EINTR) return false;
+    }
+    return true;
+}
+
+G4bool ReadoutSimProcessPool::MergeRecords(const G4String& fileName, const std::vector<G4String>& parts)
+{
+    TFileMerger merger(false);
+    if (!merger.OutputFile(fileName, "RECREATE")) return false;
+    for (const G4String& part : parts)
+        if (!merger.AddFile(part, false)) return false;
+    if (!merger.Merge()) return false;
+    for (const G4String& part : parts) std::remove(part.c_str());
+    return true;
+}
+
+void ReadoutSimProcessPool::DefineCommands()
+{
+    fMessenger = new G4GenericMessenger(this, "/RS/fork/", "Commands for runs in forked processes");
+
+    fMessenger->DeclareProperty("processes", fNumberOfProcesses)
+    .SetGuidance("Number of processes forked by /RS/fork/run")
+    .SetGuidance("Each one is a single-threaded process")
+    .SetParameterName("n", false)
+    .SetRange("n>0")
+    .SetDefaultValue("2")
+    .SetToBeBroadcasted(false);
+
+    fMessenger->DeclareMethod("run", &ReadoutSimProcessPool::Run)
+    .SetGuidance("Initialize once, then run the given number of events split over the forked processes")
+    .SetGuidance("The summary, histograms and photon records are those of all the processes together")
+    .SetParameterName("nEvents", false)
+    .SetRange("nEvents>0")
+    .SetToBeBroadcasted(false);
+}
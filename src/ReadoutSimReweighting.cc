@@ -0,0 +1,98 @@
+#include "ReadoutSimReweighting.hh"
+#include "ReadoutSimTrackInformation.hh"
+#include "ReadoutSimOpticalTables.hh"
+
+#include "G4Material.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    std::size_t GetMaterialIndex(const char* name)
+    {
+        // not built: no path is ever recorded under this index
+        G4Material* material = G4Material::GetMaterial(name, false);
+        return material ? material->GetIndex() : std::size_t(ReadoutSimTrackInformation::kMaxMaterials);
+    }
+}
+
+ReadoutSimReweighting::ReadoutSimReweighting(const std::vector<Point>& points)
+: fPoints(points)
+{
+    fPMMAIndex = GetMaterialIndex("PMMA");
+    fLArIndex = GetMaterialIndex("G4_lAr");
+
+    fSumWeights.assign(fPoints.size(), 0.);
+    fSumSquaredWeights.assign(fPoints.size(), 0.);
+    fMaxWeight.assign(fPoints.size(), 0.);
+    fDetected = 0;
+}
+
+void ReadoutSimReweighting::Fill(const ReadoutSimTrackInformation& info, G4double sampleWeight)
+{
+    using namespace ReadoutSimOpticalTables;
+
+    G4double pmmaLength = info.GetLength(fPMMAIndex);
+    G4double larLength = info.GetLength(fLArIndex);
+    G4int conversions = info.GetConversions();
+    G4int convertedPhotons = info.GetConvertedPhotons();
+
+    for (std::size_t i = 0; i < fPoints.size(); i++)
+    {
+        const Point& point = fPoints[i];
+        G4double logWeight = - pmmaLength * (1. / point.pmmaAbsorption - 1. / pmmaAbsorption)
+                             - larLength * (1. / point.larAbsorption - 1. / larAbsorption);
+        G4double weight = 0.;
+        if (point.wlsYield > 0. || convertedPhotons == 0)
+        {
+            // a weighted emission scales with the yield, without the Poisson term
+            if (convertedPhotons > 0)
+                logWeight += convertedPhotons * std::log(point.wlsYield / wlsMeanNumberPhotons)
+                             - conversions * (point.wlsYield - wlsMeanNumberPhotons);
+            weight = sampleWeight * std::exp(logWeight);
+        }
+
+        fSumWeights[i] += weight;
+        fSumSquaredWeights[i] += weight * weight;
+        fMaxWeight[i] = std::max(fMaxWeight[i], weight);
+    }
+    fDetected += 1;
+}
+
+void ReadoutSimReweighting::Add(const ReadoutSimReweighting& other)
+{
+    if (other.fPoints.size() != fPoints.size()) return;
+    for (std::size_t i = 0; i < fPoints.size(); i++)
+    {
+        fSumWeights[i] += other.fSumWeights[i];
+        fSumSquaredWeights[i] += other.fSumSquaredWeights[i];
+        fMaxWeight[i] = std::max(fMaxWeight[i], other.fMaxWeight[i]);
+    }
+    fDetected += other.fDetected;
+}
+
+void ReadoutSimReweighting::Print(G4long nPrimaries) const
+{
+    if (nPrimaries == 0) return;
+
+    G4cout << "\n   Reweighted detection (" << fDetected << " detected photons)\n";
+    G4cout <<   "---------------------------------\n";
+    G4cout << "  PMMA abs [m]  LAr abs [m]  WLS yield   Detected [%]   rel. error   eff. photons   max weight\n";
+    for (std::size_t i = 0; i < fPoints.size(); i++)
+    {
+        const Point& point = fPoints[i];
+        G4double sum = fSumWeights[i];
+        G4double error = sum > 0. ? std::sqrt(fSumSquaredWeights[i]) / sum : 0.;
+        G4double effective = fSumSquaredWeights[i] > 0. ? sum * sum / fSumSquaredWeights[i] : 0.;
+        G4cout << "  " << std::setw(12) << point.pmmaAbsorption / m
+               << " " << std::setw(12) << point.larAbsorption / m
+               << " " << std::setw(10) << point.wlsYield
+               << " " << std::setw(14) << sum / nPrimaries * 100
+               << " " << std::setw(12) << error
+               << " " << std::setw(14) << effective
+               << " " << std::setw(12) << fMaxWeight[i] << G4endl;
+    }
+    G4cout <<   "---------------------------------\n";
+}
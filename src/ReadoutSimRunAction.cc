@@ -1,18 +1,80 @@
 #include "g4root.hh"
 #include "ReadoutSimRunAction.hh"
+#include "ReadoutSimLightMap.hh"
+#include "ReadoutSimImportanceSampler.hh"
+#include "ReadoutSimPhotonRecord.hh"
+#include "ReadoutSimOutputWriter.hh"
+#include "ReadoutSimStreamSender.hh"
+#include "ReadoutSimReweighting.hh"
+#include "ReadoutSimOpticalTables.hh"
+#include "ReadoutSimSweep.hh"
+#include "ReadoutSimStartup.hh"
+#include "ReadoutSimMemory.hh"
+#include "ReadoutSimVolumeRegistry.hh"
+#include "ReadoutSimVertexLibrary.hh"
+
+#include "G4Exception.hh"
+#include "G4UImanager.hh"
+#include "G4UIcommand.hh"
 
 
 ReadoutSimRunAction::ReadoutSimRunAction()
 {
     fRun = nullptr;
+    fReferenceRate = 0.;
+    fTag = "";
+
+    fFileName = "readout.root";
+    fWriteRecords = true;
+    fHistogramFileName = "readout_histograms.root";
+    fWriteHistograms = true;
+    fPrescale = 1;
+    fWriteDirection = true;
+    fNtupleBooked = false;
+    fBackend = "async";
+    fMaxFileSize = 0.;
+
+    fMapMode = "off";
+    fMapFile = "lightmap.txt";
+    fMapXBins = 20;
+    fMapZBins = 4;
+    fMapUBins = 10;
+    fMapVBins = 10;
+
+    fReweightPMMA = "";
+    fReweightLAr = "";
+    fReweightYield = "";
+
+    fBiasMode = "off";
+    fBiasFile = "bias_lightmap.txt";
+    fBiasUniformFraction = 0.1;
+
+    fSourceArea = "guide";
+
+    fProfileSteps = false;
+    fProfileSampleEvery = 100;
+    fProfileRows = 25;
+
+    fStreamPath = "";
+
+    DefineCommands();
 }
 
 ReadoutSimRunAction::~ReadoutSimRunAction()
-{}
+{
+    delete fMessenger;
+    delete fMapMessenger;
+    delete fOutputMessenger;
+    delete fReweightMessenger;
+    delete fBiasMessenger;
+    delete fSourceMessenger;
+    delete fProfileMessenger;
+    delete fStreamMessenger;
+}
 
 G4Run* ReadoutSimRunAction::GenerateRun()
 {
-  fRun = new Run();
+  fRun = new Run(fSourceArea == "panel" ? ReadoutSimSource::panelZHalfWidth : ReadoutSimSource::zHalfWidth);
   return fRun;
 }
 
@@ -20,47 +82,456 @@ void ReadoutSimRunAction::BeginOfRunAction(const G4Run *aRun)
 {
     // G4cout << "### Run " << aRun->GetRunID() << " start." << G4endl;
 
+    if (isMaster && aRun->GetRunID() == 0)
+    {
+        // geometry, physics list and the master physics tables are built by now
+        G4cout << "\n   Startup\n";
+        G4cout <<   "---------------------------------\n";
+        G4cout << "  Job start to the first run:      " << std::setw(8) << ReadoutSimStartup::GetElapsed() << " s" << G4endl;
+        G4double memory = ReadoutSimMemory::GetResident();
+        if (memory > 0.)
+            G4cout << "  Resident memory:                 " << std::setw(8) << memory << " MB" << G4endl;
+        G4cout <<   "---------------------------------\n";
+    }
+
+    if (isMaster) fTimer.Start();
+
+    // the map bins the source in front of the guide, see ReadoutSimLightMap
+    if (fMapMode != "off" && fSourceArea == "panel" && ReadoutSimVolumeRegistry::Instance()->GetModuleLayout().IsBaseline())
+    {
+        G4ExceptionDescription msg;
+        msg << "The light map covers the source in front of the guide only, not /RS/source/area panel";
+        G4Exception("ReadoutSimRunAction::BeginOfRunAction()", "RS0009", FatalException, msg);
+        return;
+    }
+
+    // every thread fills or reads its own map, worker maps are merged into the master one
+    if (fMapMode == "fill")
+    {
+        fRun->SetLightMap(new ReadoutSimLightMap(fMapXBins, fMapZBins, fMapUBins, fMapVBins), false);
+    }
+    else if (fMapMode == "lookup")
+    {
+        if (ReadoutSimVertexLibrary::Instance()->IsOpen())
+        {
+            G4ExceptionDescription msg;
+            msg << "The light map lookup draws its own source points, it does not apply to /RS/source/library";
+            G4Exception("ReadoutSimRunAction::BeginOfRunAction()", "RS0007", FatalException, msg);
+            return;
+        }
+        ReadoutSimLightMap* map = new ReadoutSimLightMap();
+        if (!map->Read(fMapFile))
+        {
+            delete map;
+            G4ExceptionDescription msg;
+            msg << "Cannot read the light map " << fMapFile << ", fill one first with /RS/map/mode fill";
+            G4Exception("ReadoutSimRunAction::BeginOfRunAction()", "RS0001", FatalException, msg);
+            return;
+        }
+        fRun->SetLightMap(map, true);
+    }
+
+    // every thread reads the pilot map, as for the lookup
+    if (fBiasMode == "importance")
+    {
+        ReadoutSimLightMap map;
+        G4ExceptionDescription msg;
+        if (fSourceArea == "panel" && ReadoutSimVolumeRegistry::Instance()->GetModuleLayout().IsBaseline())
+            msg << "Importance sampling covers the source in front of the guide only, not /RS/source/area panel";
+        else if (ReadoutSimVertexLibrary::Instance()->IsOpen())
+            msg << "Importance sampling draws its own source points, it does not apply to /RS/source/library";
+        else if (!map.Read(fBiasFile))
+            msg << "Cannot read the light map " << fBiasFile << ", run /RS/bias/pilot first";
+        if (!msg.str().empty())
+        {
+            G4Exception("ReadoutSimRunAction::BeginOfRunAction()", "RS0006", FatalException, msg);
+            return;
+        }
+        fRun->SetImportanceSampler(new ReadoutSimImportanceSampler(map, fBiasUniformFraction));
+    }
+
+    // every point of the grid of the listed values, the others at their nominal value
+    if (!fReweightPMMA.empty() || !fReweightLAr.empty() || !fReweightYield.empty())
+    {
+        std::vector<G4double> pmma = ReadoutSimSweep::ParseValues(fReweightPMMA, "m");
+        std::vector<G4double> lar = ReadoutSimSweep::ParseValues(fReweightLAr, "m");
+        std::vector<G4double> yield = ReadoutSimSweep::ParseValues(fReweightYield, nullptr);
+        if (pmma.empty()) pmma.push_back(ReadoutSimOpticalTables::pmmaAbsorption);
+        if (lar.empty()) lar.push_back(ReadoutSimOpticalTables::larAbsorption);
+        if (yield.empty()) yield.push_back(ReadoutSimOpticalTables::wlsMeanNumberPhotons);
+
+        std::vector<ReadoutSimReweighting::Point> points;
+        for (G4double p : pmma)
+            for (G4double l : lar)
+                for (G4double y : yield) points.push_back({p, l, y});
+        fRun->SetReweighting(new ReadoutSimReweighting(points));
+    }
+
+    if (fProfileSteps) fRun->SetStepProfiler(new ReadoutSimStepProfiler(fProfileSampleEvery));
+
+    // one sender thread for all the threads of the run, started here and
+    // stopped at the end of the run, when the stream gets its end-of-run record
+    if (isMaster && IsStreaming()) ReadoutSimStreamSender::Instance()->Open(fStreamPath, aRun->GetRunID());
+
+    if (!fWriteRecords) return;
+
+    // one writer thread for all the threads of the run, opened by the master before the workers start
+    if (UseAsyncOutput())
+    {
+        if (isMaster) ReadoutSimOutputWriter::Instance()->Open(Tagged(fFileName), fWriteDirection, fMaxFileSize * 1024. * 1024.);
+        return;
+    }
+
     G4AnalysisManager *man = G4AnalysisManager::Instance();
 
-    man->OpenFile("readout.root"); 
-    
-    man->CreateNtuple("Score", "Score");
-    // man->CreateNtupleDColumn("left-right");
-    // man->CreateNtupleDColumn("bot");
-    // man->CreateNtupleDColumn("top");
-    // man->CreateNtupleDColumn("left");
-    // man->CreateNtupleDColumn("right");
-    // man->CreateNtupleDColumn("xHit");
-    // man->CreateNtupleDColumn("yHit");
-    // man->CreateNtupleDColumn("zHit");
-    man->CreateNtupleDColumn("xPhotonVertex");
-    man->CreateNtupleDColumn("yPhotonVertex");
-    man->CreateNtupleDColumn("zPhotonVertex");
-    man->CreateNtupleDColumn("xPhotonDirection");
-    man->CreateNtupleDColumn("yPhotonDirection");
-    man->CreateNtupleDColumn("zPhotonDirection");
-    man->CreateNtupleSColumn("initialVolume");
-    man->CreateNtupleSColumn("finalVolume");
-    man->CreateNtupleDColumn("xPhotonFinal");
-    man->CreateNtupleDColumn("yPhotonFinal");
-    man->CreateNtupleDColumn("zPhotonFinal");
-    man->CreateNtupleDColumn("energyFinal");   
-    man->CreateNtupleIColumn("rightDetector");
-    man->CreateNtupleIColumn("leftDetector");    
-    // man->CreateNtupleDColumn("stepLength");
-    // man->CreateNtupleDColumn("G4TrackLength");
-
-    man->FinishNtuple(0);
+    // the schema is fixed by the /RS/output/ settings at the first run
+    if (!fNtupleBooked)
+    {
+        ReadoutSimPhotonRecord::Book(fWriteDirection);
+        fNtupleBooked = true;
+    }
+
+    man->OpenFile(Tagged(fFileName)); 
 
     // G4cout << "Ho creato la Ntupla" << G4endl;
 }
 
 void ReadoutSimRunAction::EndOfRunAction(const G4Run *aRun)
 {
-    // if (isMaster) fRun->EndOfRun();
+    if (isMaster)
+    {
+        fTimer.Stop();
+        fRun->EndOfRun(fTag);
+        fRun->PrintThroughput(fTimer.GetRealElapsed(), fReferenceRate);
+        if (fRun->GetStepProfiler()) fRun->GetStepProfiler()->Print(fProfileRows);
+
+        // the worker histograms are merged into the master run by now
+        if (fWriteHistograms && !fRun->IsLookingUpLightMap())
+        {
+            G4String histogramFileName = Tagged(fHistogramFileName);
+            if (fRun->WriteHistograms(histogramFileName))
+                G4cout << "Histograms written to " << histogramFileName << G4endl;
+            else
+                G4cerr << "Cannot write the histograms to " << histogramFileName << G4endl;
+        }
+
+        if (fRun->IsLookingUpLightMap())
+        {
+            fRun->PrintLookup(fTimer.GetRealElapsed());
+            if (fRun->GetEmptyBinLookups() > 0)
+            {
+                G4ExceptionDescription msg;
+                msg << fRun->GetEmptyBinLookups() << " photons fell into bins of " << fMapFile
+                    << " without entries and count as not detected; fill the map with more events or fewer bins";
+                G4Exception("ReadoutSimRunAction::EndOfRunAction()", "RS0011", JustWarning, msg);
+            }
+        }
+        if (fRun->IsFillingLightMap())
+        {
+            ReadoutSimLightMap* map = fRun->GetLightMap();
+            if (map->Write(fMapFile))
+                G4cout << "Light map with " << map->GetEntries() << " photons written to " << fMapFile
+                       << " (" << map->GetNumberOfEmptyBins() << " of " << map->GetNumberOfBins() << " bins empty)" << G4endl;
+            else
+                G4cerr << "Cannot write the light map to " << fMapFile << G4endl;
+        }
+
+        if (IsStreaming()) ReadoutSimStreamSender::Instance()->Close();
+    }
+
+    if (!fWriteRecords) return;
+
+    // the master ends the run after all the workers, nothing is pushed any more
+    if (UseAsyncOutput())
+    {
+        if (isMaster) ReadoutSimOutputWriter::Instance()->Close();
+        return;
+    }
 
     G4AnalysisManager *man = G4AnalysisManager::Instance();
 
     man->Write();
-    man->CloseFile("readout.root"); 
-}
\ No newline at end of file
+    man->CloseFile(); 
+}
+
+void ReadoutSimRunAction::RunPilot(G4int nEvents)
+{
+    // the pilot itself is not biased: its map starts from the plain source
+    G4UImanager* UImanager = G4UImanager::GetUIpointer();
+    G4String mapMode = fMapMode;
+    G4String mapFile = fMapFile;
+    G4String tag = fTag;
+    UImanager->ApplyCommand("/RS/bias/mode off");
+    UImanager->ApplyCommand("/RS/map/mode fill");
+    UImanager->ApplyCommand("/RS/map/file " + fBiasFile);
+    UImanager->ApplyCommand("/RS/run/tag " + (tag.empty() ? G4String("pilot") : tag + "_pilot"));
+    G4int status = UImanager->ApplyCommand("/run/beamOn " + G4UIcommand::ConvertToString(nEvents));
+
+    UImanager->ApplyCommand("/RS/run/tag " + tag);
+    UImanager->ApplyCommand("/RS/map/file " + mapFile);
+    UImanager->ApplyCommand("/RS/map/mode " + mapMode);
+    if (status == 0) UImanager->ApplyCommand("/RS/bias/mode importance");
+}
+
+void ReadoutSimRunAction::SetVertexLibrary(G4String fileName)
+{
+    ReadoutSimVertexLibrary* library = ReadoutSimVertexLibrary::Instance();
+    if (fileName.empty())
+    {
+        library->Close();
+        return;
+    }
+    if (!library->Open(fileName))
+    {
+        G4ExceptionDescription msg;
+        msg << "Cannot read the vertex library " << fileName << ", see include/ReadoutSimVertexRecord.hh for the format";
+        G4Exception("ReadoutSimRunAction::SetVertexLibrary()", "RS0007", FatalException, msg);
+    }
+}
+
+void ReadoutSimRunAction::SetVertexChunk(G4int nVertices)
+{
+    ReadoutSimVertexLibrary::Instance()->SetChunkSize(nVertices);
+}
+
+void ReadoutSimRunAction::SetVertexLoop(G4bool loop)
+{
+    ReadoutSimVertexLibrary::Instance()->SetLoop(loop);
+}
+
+void ReadoutSimRunAction::RewindVertexLibrary()
+{
+    ReadoutSimVertexLibrary::Instance()->Rewind();
+}
+
+G4String ReadoutSimRunAction::Tagged(const G4String& fileName) const
+{
+    return TagFileName(fileName, fTag);
+}
+
+G4String ReadoutSimRunAction::TagFileName(const G4String& fileName, const G4String& tag)
+{
+    if (tag.empty()) return fileName;
+    std::size_t dot = fileName.rfind('.');
+    if (dot == std::string::npos) return fileName + "_" + tag;
+    return fileName.substr(0, dot) + "_" + tag + fileName.substr(dot);
+}
+
+void ReadoutSimRunAction::DefineCommands()
+{
+    fMessenger = new G4GenericMessenger(this, "/RS/run/", "Commands for controlling the run summary");
+
+    fMessenger->DeclareProperty("referenceRate", fReferenceRate)
+    .SetGuidance("Photons/s of a single-thread run of the same job")
+    .SetGuidance("When set, the scaling efficiency is computed against it")
+    .SetParameterName("rate", false)
+    .SetRange("rate>=0.")
+    .SetDefaultValue("0.");
+
+    fMessenger->DeclareProperty("tag", fTag)
+    .SetGuidance("Name of the configuration, printed with the summary and added to the output file names")
+    .SetGuidance("Without a parameter the tag is removed")
+    .SetParameterName("tag", true)
+    .SetDefaultValue("");
+
+    fOutputMessenger = new G4GenericMessenger(this, "/RS/output/", "Commands for the photon ntuple and the histograms");
+
+    fOutputMessenger->DeclareProperty("records", fWriteRecords)
+    .SetGuidance("Write one ntuple row per photon track")
+    .SetGuidance("Not needed for efficiencies: the fate counters and histograms are filled anyway")
+    .SetParameterName("write", false)
+    .SetDefaultValue("1");
+
+    fOutputMessenger->DeclareProperty("fileName", fFileName)
+    .SetGuidance("Output file of the photon ntuple")
+    .SetParameterName("fileName", false)
+    .SetDefaultValue("readout.root");
+
+    fOutputMessenger->DeclareProperty("histograms", fWriteHistograms)
+    .SetGuidance("Write the source and detection histograms of the run")
+    .SetParameterName("write", false)
+    .SetDefaultValue("1");
+
+    fOutputMessenger->DeclareProperty("histogramFileName", fHistogramFileName)
+    .SetGuidance("Output file of the histograms")
+    .SetParameterName("fileName", false)
+    .SetDefaultValue("readout_histograms.root");
+
+    fOutputMessenger->DeclareProperty("prescale", fPrescale)
+    .SetGuidance("Write every detected photon, but only 1 in N of the other ones")
+    .SetGuidance("The weight column of a written row is N for undetected photons")
+    .SetParameterName("N", false)
+    .SetRange("N>=1")
+    .SetDefaultValue("1");
+
+    fOutputMessenger->DeclareProperty("direction", fWriteDirection)
+    .SetGuidance("Write the quantized initial direction of every photon")
+    .SetGuidance("Fixed at the first run, when the ntuple is booked")
+    .SetParameterName("write", false)
+    .SetDefaultValue("1");
+
+    fOutputMessenger->DeclareProperty("backend", fBackend)
+    .SetGuidance("async  = workers hand the records to a writer thread, one merged file per run")
+    .SetGuidance("g4root = G4AnalysisManager ntuple, filled by every worker")
+    .SetParameterName("backend", false)
+    .SetCandidates("async g4root")
+    .SetDefaultValue("async");
+
+    fOutputMessenger->DeclareProperty("maxFileSize", fMaxFileSize)
+    .SetGuidance("With the async backend, continue in fileName_1.root, ... beyond this size in MB")
+    .SetGuidance("0 writes a single file")
+    .SetParameterName("size", false)
+    .SetRange("size>=0.")
+    .SetDefaultValue("0.");
+
+    fMapMessenger = new G4GenericMessenger(this, "/RS/map/", "Commands for the light-collection map");
+
+    fMapMessenger->DeclareProperty("mode", fMapMode)
+    .SetGuidance("off    = track photons as usual")
+    .SetGuidance("fill   = track photons and bin the detection probability of every primary")
+    .SetGuidance("         by source position and direction, written to the map file at the end of the run")
+    .SetGuidance("lookup = do not track: draw left/right detection of every source point from the map file")
+    .SetParameterName("mode", false)
+    .SetCandidates("off fill lookup")
+    .SetDefaultValue("off");
+
+    fMapMessenger->DeclareProperty("file", fMapFile)
+    .SetGuidance("File the light map is written to (fill) or read from (lookup)")
+    .SetParameterName("fileName", false)
+    .SetDefaultValue("lightmap.txt");
+
+    fMapMessenger->DeclareProperty("xBins", fMapXBins)
+    .SetGuidance("Number of bins along x on the source plane")
+    .SetParameterName("n", false)
+    .SetRange("n>=1")
+    .SetDefaultValue("20");
+
+    fMapMessenger->DeclareProperty("zBins", fMapZBins)
+    .SetGuidance("Number of bins along z on the source plane")
+    .SetParameterName("n", false)
+    .SetRange("n>=1")
+    .SetDefaultValue("4");
+
+    fMapMessenger->DeclareProperty("uBins", fMapUBins)
+    .SetGuidance("Number of bins in cos(theta) of the direction, along z")
+    .SetParameterName("n", false)
+    .SetRange("n>=1")
+    .SetDefaultValue("10");
+
+    fMapMessenger->DeclareProperty("vBins", fMapVBins)
+    .SetGuidance("Number of bins in the azimuth of the direction")
+    .SetParameterName("n", false)
+    .SetRange("n>=1")
+    .SetDefaultValue("10");
+
+    fReweightMessenger = new G4GenericMessenger(this, "/RS/reweight/", "Commands for the efficiency at other optical parameters");
+
+    fReweightMessenger->DeclareProperty("pmmaAbsorption", fReweightPMMA)
+    .SetGuidance("PMMA absorption lengths to reweight the detected photons to, unit at the end (default m)")
+    .SetGuidance("e.g. 1.5 2 2.5 3 m, without a parameter only the nominal value")
+    .SetParameterName("values", true)
+    .SetDefaultValue("");
+
+    fReweightMessenger->DeclareProperty("larAbsorption", fReweightLAr)
+    .SetGuidance("LAr absorption lengths to reweight the detected photons to, unit at the end (default m)")
+    .SetParameterName("values", true)
+    .SetDefaultValue("");
+
+    fReweightMessenger->DeclareProperty("wlsYield", fReweightYield)
+    .SetGuidance("Mean numbers of photons per WLS absorption to reweight the detected photons to")
+    .SetParameterName("values", true)
+    .SetDefaultValue("");
+
+    fBiasMessenger = new G4GenericMessenger(this, "/RS/bias/", "Commands for the importance sampling of the primaries");
+
+    fBiasMessenger->DeclareProperty("mode", fBiasMode)
+    .SetGuidance("off        = primaries uniform over the source, every photon has weight 1")
+    .SetGuidance("importance = primaries drawn more often where the pilot map detects them,")
+    .SetGuidance("             each with the weight that keeps the counters, histograms and records unbiased")
+    .SetParameterName("mode", false)
+    .SetCandidates("off importance")
+    .SetDefaultValue("off");
+
+    fBiasMessenger->DeclareProperty("file", fBiasFile)
+    .SetGuidance("Light map the importance sampling learns from, written by /RS/bias/pilot")
+    .SetParameterName("fileName", false)
+    .SetDefaultValue("bias_lightmap.txt");
+
+    fBiasMessenger->DeclareProperty("uniformFraction", fBiasUniformFraction)
+    .SetGuidance("Fraction of the primaries still drawn uniformly; the weights stay below 1/fraction")
+    .SetParameterName("fraction", false)
+    .SetRange("fraction>0. && fraction<=1.")
+    .SetDefaultValue("0.1");
+
+    fBiasMessenger->DeclareMethod("pilot", &ReadoutSimRunAction::RunPilot)
+    .SetGuidance("Run N unbiased events filling the map file with the /RS/map/ binning, tagged pilot,")
+    .SetGuidance("then switch the importance sampling on")
+    .SetParameterName("N", false)
+    .SetRange("N>0")
+    .SetToBeBroadcasted(false);
+
+    fSourceMessenger = new G4GenericMessenger(this, "/RS/source/", "Commands for the primary photon source");
+
+    fSourceMessenger->DeclareProperty("area", fSourceArea)
+    .SetGuidance("guide = source plane in front of the light guide (10 cm along z)")
+    .SetGuidance("panel = the same plane over the whole panel length (3 m)")
+    .SetGuidance("In the module every bar keeps the source in front of its guide")
+    .SetParameterName("area", false)
+    .SetCandidates("guide panel")
+    .SetDefaultValue("guide");
+
+    // the library is one for the whole job: only the master opens it
+    fSourceMessenger->DeclareMethod("library", &ReadoutSimRunAction::SetVertexLibrary)
+    .SetGuidance("Read the primary photons from this vertex file instead of sampling them,")
+    .SetGuidance("photonsPerEvent vertices per event; without a parameter back to the source")
+    .SetGuidance("Open it before /RS/fork/run for the forked processes to share it")
+    .SetParameterName("fileName", true)
+    .SetDefaultValue("")
+    .SetToBeBroadcasted(false);
+
+    fSourceMessenger->DeclareMethod("libraryChunk", &ReadoutSimRunAction::SetVertexChunk)
+    .SetGuidance("Vertices a thread claims from the library at once")
+    .SetParameterName("n", false)
+    .SetRange("n>0")
+    .SetDefaultValue("1024")
+    .SetToBeBroadcasted(false);
+
+    fSourceMessenger->DeclareMethod("libraryLoop", &ReadoutSimRunAction::SetVertexLoop)
+    .SetGuidance("Start the library again when it is used up, instead of ending the run")
+    .SetParameterName("loop", false)
+    .SetDefaultValue("0")
+    .SetToBeBroadcasted(false);
+
+    fSourceMessenger->DeclareMethod("rewind", &ReadoutSimRunAction::RewindVertexLibrary)
+    .SetGuidance("Read the library again from its first vertex; otherwise every run goes on where the last one stopped")
+    .SetToBeBroadcasted(false);
+
+    fProfileMessenger = new G4GenericMessenger(this, "/RS/profile/", "Commands for the step profiler");
+
+    fProfileMessenger->DeclareProperty("steps", fProfileSteps)
+    .SetGuidance("Count steps, tracked length and CPU time by volume, process and boundary status")
+    .SetGuidance("The table is printed at the end of the run")
+    .SetParameterName("profile", false)
+    .SetDefaultValue("0");
+
+    fProfileMessenger->DeclareProperty("sampleEvery", fProfileSampleEvery)
+    .SetGuidance("Time one step in N with the thread CPU clock, 0 for counts only")
+    .SetParameterName("N", false)
+    .SetRange("N>=0")
+    .SetDefaultValue("100");
+
+    fProfileMessenger->DeclareProperty("rows", fProfileRows)
+    .SetGuidance("Rows of the table, the rest is summed up; 0 for all")
+    .SetParameterName("rows", false)
+    .SetRange("rows>=0")
+    .SetDefaultValue("25");
+
+    fStreamMessenger = new G4GenericMessenger(this, "/RS/stream/", "Commands for the live record stream");
+
+    fStreamMessenger->DeclareProperty("path", fStreamPath)
+    .SetGuidance("Unix domain socket or named pipe a consumer reads one record per track from")
+    .SetGuidance("e.g. monitor/readoutsim_monitor.py; records are dropped, never waited for, when it falls behind")
+    .SetGuidance("Without a parameter the stream is off")
+    .SetParameterName("path", true)
+    .SetDefaultValue("");
+}
@@ -0,0 +1,101 @@
+#include "ReadoutSimStackingAction.hh"
+#include "ReadoutSimVolumeRegistry.hh"
+#include "Run.hh"
+
+#include "G4Track.hh"
+#include "G4StepPoint.hh"
+#include "G4OpticalPhoton.hh"
+#include "G4RunManager.hh"
+#include "G4PhysicalConstants.hh"
+#include "G4SystemOfUnits.hh"
+
+namespace
+{
+    Run* GetRun()
+    {
+        return static_cast<Run*>(G4RunManager::GetRunManager()->GetNonConstCurrentRun());
+    }
+}
+
+ReadoutSimStackingAction::ReadoutSimStackingAction()
+: G4UserStackingAction()
+{
+    fKillEnterWorld = false;
+    fMinEnergy = 0.;
+    fKillEscape = true;
+
+    DefineCommands();
+}
+
+ReadoutSimStackingAction::~ReadoutSimStackingAction()
+{
+    delete fMessenger;
+}
+
+G4ClassificationOfNewTrack ReadoutSimStackingAction::ClassifyNewTrack(const G4Track* track)
+{
+    if (track->GetDefinition() != G4OpticalPhoton::OpticalPhotonDefinition()) return fUrgent;
+
+    if (fMinEnergy > 0. && track->GetKineticEnergy() < fMinEnergy)
+    {
+        GetRun()->AddKill(Run::kKillBelowEnergy, track->GetWeight());
+        return fKill;
+    }
+
+    // primaries start in the LAr, WLS photons inside the envelope are always kept
+    if (fKillEscape && !ReadoutSimVolumeRegistry::Instance()->CanReachEnvelope(track->GetPosition(), track->GetMomentumDirection()))
+    {
+        GetRun()->AddKill(Run::kKillEscape, track->GetWeight());
+        return fKill;
+    }
+
+    return fUrgent;
+}
+
+G4bool ReadoutSimStackingAction::KillInWorld(const G4StepPoint* point) const
+{
+    if (fKillEnterWorld)
+    {
+        GetRun()->AddKill(Run::kKillEnterWorld, point->GetWeight());
+        return true;
+    }
+    if (fKillEscape && !ReadoutSimVolumeRegistry::Instance()->CanReachEnvelope(point->GetPosition(), point->GetMomentumDirection()))
+    {
+        GetRun()->AddKill(Run::kKillEscape, point->GetWeight());
+        return true;
+    }
+    return false;
+}
+
+void ReadoutSimStackingAction::SetMaxWavelength(G4double wavelength)
+{
+    fMinEnergy = wavelength > 0. ? h_Planck * c_light / wavelength : 0.;
+}
+
+void ReadoutSimStackingAction::DefineCommands()
+{
+    fMessenger = new G4GenericMessenger(this, "/RS/kill/", "Commands for the early termination of photons");
+
+    fMessenger->DeclareProperty("enterWorld", fKillEnterWorld)
+    .SetGuidance("Kill photons as soon as they go into the LAr")
+    .SetGuidance("Also kills photons crossing the LAr gap between the panel and the guide")
+    .SetParameterName("kill", false)
+    .SetDefaultValue("0");
+
+    fMessenger->DeclarePropertyWithUnit("minEnergy", "eV", fMinEnergy)
+    .SetGuidance("Kill new photons below this energy, 0 to keep all of them")
+    .SetParameterName("energy", false)
+    .SetRange("energy>=0.")
+    .SetDefaultValue("0.");
+
+    fMessenger->DeclareMethodWithUnit("maxWavelength", "nm", &ReadoutSimStackingAction::SetMaxWavelength)
+    .SetGuidance("Same as minEnergy, as a wavelength, 0 to keep all photons")
+    .SetParameterName("wavelength", false)
+    .SetRange("wavelength>=0.")
+    .SetDefaultValue("0.");
+
+    fMessenger->DeclareProperty("escape", fKillEscape)
+    .SetGuidance("Kill photons in the LAr that point away from every volume")
+    .SetParameterName("kill", false)
+    .SetDefaultValue("1");
+}
@@ -0,0 +1,157 @@
+#include "ReadoutSimStepProfiler.hh"
+
+#include "G4VProcess.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <algorithm>
+#include <ctime>
+
+namespace
+{
+    const G4int kNumberOfVolumes = ReadoutSimVolumeRegistry::kNumberOfVolumes;
+
+    // G4OpBoundaryProcessStatus, the ones common to all Geant4 10 versions
+    G4String GetStatusName(G4int status)
+    {
+        static const char* names[] = {
+            "Undefined", "Transmission", "FresnelRefraction", "FresnelReflection",
+            "TotalInternalReflection", "LambertianReflection", "LobeReflection",
+            "SpikeReflection", "BackScattering", "Absorption", "Detection",
+            "NotAtBoundary", "SameMaterial", "StepTooSmall", "NoRINDEX"
+        };
+        if (status >= 0 && status < G4int(sizeof(names) / sizeof(names[0]))) return names[status];
+        return "status " + std::to_string(status);
+    }
+}
+
+ReadoutSimStepProfiler::ReadoutSimStepProfiler(G4int sampleEvery)
+{
+    fSampleEvery = std::max(sampleEvery, 0);
+    fCountdown = fSampleEvery;
+    fStartTime = -1.;
+    fTimedTrack = 0;
+    fLastProcess = nullptr;
+    fLastProcessIndex = AddProcess(nullptr, "none");
+}
+
+G4double ReadoutSimStepProfiler::GetThreadTime()
+{
+    // CPU time of the calling thread: other threads and waits do not count
+    timespec time;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+    return time.tv_sec + 1e-9 * time.tv_nsec;
+}
+
+G4int ReadoutSimStepProfiler::AddProcess(const G4VProcess* process, const G4String& name)
+{
+    fProcesses.push_back(process);
+    fProcessNames.push_back(process ? process->GetProcessName() : name);
+    fCounters.resize(fProcesses.size() * kNumberOfVolumes * kMaxStatus);
+    return G4int(fProcesses.size()) - 1;
+}
+
+void ReadoutSimStepProfiler::Sample(std::size_t index, G4int trackID)
+{
+    G4double now = GetThreadTime();
+    if (fStartTime < 0.)
+    {
+        // the countdown is over: time the next step of this track
+        fStartTime = now;
+        fTimedTrack = trackID;
+        return;
+    }
+
+    // a step of another track, e.g. after a suspended one, would include
+    // the end of the timed track and the start of this one: drop it
+    if (trackID == fTimedTrack)
+    {
+        fCounters[index].time += now - fStartTime;
+        fCounters[index].timed += 1;
+    }
+    fStartTime = -1.;
+    fCountdown = fSampleEvery;
+}
+
+void ReadoutSimStepProfiler::Add(const ReadoutSimStepProfiler& other)
+{
+    // process pointers are per thread, the names are the same everywhere
+    for (std::size_t otherProcess = 0; otherProcess < other.fProcesses.size(); otherProcess++)
+    {
+        const G4String& name = other.fProcessNames[otherProcess];
+        std::size_t process = std::find(fProcessNames.begin(), fProcessNames.end(), name) - fProcessNames.begin();
+        if (process == fProcessNames.size()) process = AddProcess(nullptr, name);
+
+        std::size_t block = kNumberOfVolumes * kMaxStatus;
+        for (std::size_t i = 0; i < block; i++)
+        {
+            const Counters& from = other.fCounters[otherProcess * block + i];
+            Counters& to = fCounters[process * block + i];
+            to.steps += from.steps;
+            to.length += from.length;
+            to.time += from.time;
+            to.timed += from.timed;
+        }
+    }
+}
+
+void ReadoutSimStepProfiler::Print(G4int maxRows) const
+{
+    G4long steps = 0, timed = 0;
+    G4double time = 0.;
+    std::vector<std::size_t> rows;
+    for (std::size_t i = 0; i < fCounters.size(); i++)
+    {
+        if (fCounters[i].steps == 0) continue;
+        rows.push_back(i);
+        steps += fCounters[i].steps;
+        timed += fCounters[i].timed;
+        time += fCounters[i].time;
+    }
+    if (steps == 0) return;
+
+    // the timed steps are a sample of all the steps
+    G4double scale = timed > 0 ? G4double(steps) / G4double(timed) : 0.;
+    G4bool byTime = timed > 0;
+    std::sort(rows.begin(), rows.end(), [&](std::size_t a, std::size_t b)
+    {
+        if (byTime && fCounters[a].time != fCounters[b].time) return fCounters[a].time > fCounters[b].time;
+        return fCounters[a].steps > fCounters[b].steps;
+    });
+
+    G4cout << "\n   Step profile (" << steps << " steps";
+    if (byTime) G4cout << ", " << timed << " timed, " << time * scale << " s CPU estimated";
+    G4cout << ")\n";
+    G4cout << "  " << std::setw(20) << std::left << "volume" << std::setw(18) << "process" << std::setw(24) << "boundary" << std::right
+           << std::setw(12) << "steps" << std::setw(8) << "%" << std::setw(12) << "length [m]"
+           << std::setw(10) << "ns/step" << std::setw(8) << "% time" << G4endl;
+
+    Counters others;
+    for (std::size_t row = 0; row < rows.size(); row++)
+    {
+        const Counters& counters = fCounters[rows[row]];
+        if (maxRows > 0 && G4int(row) >= maxRows)
+        {
+            others.steps += counters.steps;
+            others.length += counters.length;
+            others.time += counters.time;
+            others.timed += counters.timed;
+            continue;
+        }
+        std::size_t status = rows[row] % kMaxStatus;
+        std::size_t volume = rows[row] / kMaxStatus % kNumberOfVolumes;
+        std::size_t process = rows[row] / kMaxStatus / kNumberOfVolumes;
+        G4cout << "  " << std::setw(20) << std::left << ReadoutSimVolumeRegistry::GetName(ReadoutSimVolumeRegistry::VolumeID(volume))
+               << std::setw(18) << fProcessNames[process] << std::setw(24) << GetStatusName(G4int(status)) << std::right
+               << std::setw(12) << counters.steps << std::setw(8) << std::setprecision(3) << 100. * counters.steps / steps
+               << std::setw(12) << counters.length / m;
+        if (counters.timed > 0) G4cout << std::setw(10) << counters.time / counters.timed * 1e9;
+        else G4cout << std::setw(10) << "-";
+        G4cout << std::setw(8) << (time > 0. ? 100. * counters.time / time : 0.) << std::setprecision(6) << G4endl;
+    }
+    if (others.steps > 0)
+        G4cout << "  " << std::setw(62) << std::left << "others" << std::right
+               << std::setw(12) << others.steps << std::setw(8) << std::setprecision(3) << 100. * others.steps / steps
+               << std::setw(12) << others.length / m << std::setw(10) << (others.timed > 0 ? others.time / others.timed * 1e9 : 0.)
+               << std::setw(8) << (time > 0. ? 100. * others.time / time : 0.) << std::setprecision(6) << G4endl;
+    G4cout << "---------------------------------\n";
+}
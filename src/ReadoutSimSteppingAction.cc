@@ -1,4 +1,10 @@
 #include "ReadoutSimSteppingAction.hh"
+#include "ReadoutSimVolumeRegistry.hh"
+#include "ReadoutSimEventAction.hh"
+#include "ReadoutSimStackingAction.hh"
+#include "ReadoutSimTrackInformation.hh"
+#include "ReadoutSimRunAction.hh"
+#include "ReadoutSimPhotonBiasing.hh"
 #include "Run.hh"
 
 #include "G4OpBoundaryProcess.hh"
@@ -11,25 +17,34 @@
 #include "G4SteppingManager.hh"
 #include "G4RunManager.hh"
 #include "G4ProcessManager.hh"
+#include "G4Material.hh"
 
 #include "G4SystemOfUnits.hh"
 
 #include "g4root.hh"
 
-ReadoutSimSteppingAction::ReadoutSimSteppingAction()
+ReadoutSimSteppingAction::ReadoutSimSteppingAction(ReadoutSimEventAction* eventAction, const ReadoutSimStackingAction* stackingAction,
+                                                   const ReadoutSimRunAction* runAction, const ReadoutSimPhotonBiasing* biasing)
 : G4UserSteppingAction()
 {
+    fEventAction = eventAction;
+    fStackingAction = stackingAction;
+    fRunAction = runAction;
+    fBiasing = biasing;
+    fBoundaryProcess = nullptr;
     trackLength = 0.;
 }
 
 ReadoutSimSteppingAction::~ReadoutSimSteppingAction()
-{}
+{
+    delete fBiasing;
+}
 
 void ReadoutSimSteppingAction::UserSteppingAction(const G4Step* step)
 {
     // static G4ParticleDefinition* opticalphoton = 
     //             G4OpticalPhoton::OpticalPhotonDefinition();
-    G4AnalysisManager* analysisMan = G4AnalysisManager::Instance();
+    // G4AnalysisManager* analysisMan = G4AnalysisManager::Instance();
 
     // Run* run = static_cast<Run*>(
     //            G4RunManager::GetRunManager()->GetNonConstCurrentRun());
@@ -38,24 +53,44 @@ void ReadoutSimSteppingAction::UserSteppingAction(const G4Step* step)
     G4StepPoint* endPoint   = step->GetPostStepPoint();
     G4StepPoint* startPoint = step->GetPreStepPoint();
 
-    G4String particleName = track->GetDynamicParticle()->GetParticleDefinition()->GetParticleName();
-
-    G4String startVolumeName = startPoint->GetTouchable()->GetVolume()->GetName();
-    G4String endVolumeName = endPoint->GetTouchable()->GetVolume()->GetName();
+    // volume IDs instead of name copies: this runs for every photon step
+    const ReadoutSimVolumeRegistry* registry = ReadoutSimVolumeRegistry::Instance();
+    ReadoutSimVolumeRegistry::VolumeID startVolume = registry->GetID(startPoint->GetPhysicalVolume());
+    ReadoutSimVolumeRegistry::VolumeID endVolume = registry->GetID(endPoint->GetPhysicalVolume());
 
     // G4cout << endPoint->GetProcessDefinedStep()->GetProcessName() << G4endl;
     // G4cout << endPoint->GetKineticEnergy() / eV << G4endl;
 
-    if(startVolumeName == "Guide_phys" && endVolumeName == "RightDetector_phys")
+    // optical path per material, see ReadoutSimReweighting
+    ReadoutSimTrackInformation* info = static_cast<ReadoutSimTrackInformation*>(track->GetUserInformation());
+    if (info) info->AddLength(startPoint->GetMaterial()->GetIndex(), step->GetStepLength());
+
+    // before the detectors kill the track, so that its last step counts too
+    ReadoutSimStepProfiler* profiler = fRunAction->GetRun()->GetStepProfiler();
+    if (profiler)
+        profiler->Fill(startVolume, endPoint->GetProcessDefinedStep(), GetBoundaryStatus(step), step->GetStepLength(), track->GetTrackID());
+
+    if(startVolume == ReadoutSimVolumeRegistry::kGuide && endVolume == ReadoutSimVolumeRegistry::kRightDetector)
     {
         track->SetTrackStatus(fStopAndKill);
-        analysisMan->FillNtupleIColumn(12, 1);
+        AddDetection(track, endPoint, true);
     }
-    else if(startVolumeName == "Guide_phys" && endVolumeName == "LeftDetector_phys")
+    else if(startVolume == ReadoutSimVolumeRegistry::kGuide && endVolume == ReadoutSimVolumeRegistry::kLeftDetector)
     {
         track->SetTrackStatus(fStopAndKill);
-        analysisMan->FillNtupleIColumn(13, 1);
+        AddDetection(track, endPoint, false);
     }
+    else if (endVolume == ReadoutSimVolumeRegistry::kWorld && startVolume != ReadoutSimVolumeRegistry::kWorld)
+    {
+        // where photons absorbed in LAr come from, see Run::CountTrack()
+        if (info) info->SetVolumeBeforeWorld(startVolume);
+
+        if (fStackingAction->KillInWorld(endPoint)) track->SetTrackStatus(fStopAndKill);
+    }
+
+    // not for photons detected, absorbed or killed in this step
+    if (track->GetTrackStatus() == fAlive)
+        fBiasing->Apply(track, step, startVolume, endVolume, fpSteppingManager->GetfSecondary(), fRunAction->GetRun());
 
     // trackLength = trackLength + track->GetStepLength() / m;
 
@@ -157,3 +192,27 @@ void ReadoutSimSteppingAction::UserSteppingAction(const G4Step* step)
     return;
 
 }
+
+G4int ReadoutSimSteppingAction::GetBoundaryStatus(const G4Step* step)
+{
+    // the status is only set by the boundary process on a geometry boundary;
+    // steps moved by the fast simulation never reach it
+    if (step->GetPostStepPoint()->GetStepStatus() != fGeomBoundary) return NotAtBoundary;
+    if (!fBoundaryProcess)
+    {
+        G4ProcessVector* processes = step->GetTrack()->GetDefinition()->GetProcessManager()->GetProcessList();
+        for (std::size_t i = 0; i < processes->size() && !fBoundaryProcess; i++)
+            fBoundaryProcess = dynamic_cast<G4OpBoundaryProcess*>((*processes)[i]);
+        if (!fBoundaryProcess) return Undefined;
+    }
+    return fBoundaryProcess->GetStatus();
+}
+
+void ReadoutSimSteppingAction::AddDetection(const G4Track* track, const G4StepPoint* detectorPoint, G4bool right)
+{
+    ReadoutSimTrackInformation* info = static_cast<ReadoutSimTrackInformation*>(track->GetUserInformation());
+    if (!info) return;
+    info->SetDetector(right ? ReadoutSimVolumeRegistry::kRightDetector : ReadoutSimVolumeRegistry::kLeftDetector);
+    info->SetChannel(ReadoutSimVolumeRegistry::Instance()->GetChannel(detectorPoint->GetTouchable()));
+    fEventAction->AddDetection(info->GetPrimaryID(), right);
+}
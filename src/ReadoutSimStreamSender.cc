@@ -0,0 +1,267 @@
+#include "ReadoutSimStreamSender.hh"
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace
+{
+    // records per thread ring, 1.25 MB each
+    const std::size_t kBufferSize = 1 << 16;
+    // records per message
+    const std::size_t kBatchSize = 4096;
+    // a consumer that takes nothing for this long loses the end of the run
+    const std::chrono::seconds kCloseTimeout(2);
+}
+
+ReadoutSimStreamSender::Buffer::Buffer()
+: ring(kBufferSize), dropped(0)
+{}
+
+ReadoutSimStreamSender* ReadoutSimStreamSender::Instance()
+{
+    static ReadoutSimStreamSender instance;
+    return &instance;
+}
+
+ReadoutSimStreamSender::ReadoutSimStreamSender()
+: fStop(false)
+{
+    fRunID = 0;
+    fDescriptor = -1;
+    fIsSocket = false;
+    fPendingOffset = 0;
+    fPendingRecords = 0;
+    fSent = 0;
+    fDiscarded = 0;
+}
+
+ReadoutSimStreamSender::~ReadoutSimStreamSender()
+{
+    Close();
+}
+
+void ReadoutSimStreamSender::Open(const G4String& path, G4int runID)
+{
+    Close();
+
+    // a consumer that goes away must not kill the job
+    std::signal(SIGPIPE, SIG_IGN);
+
+    fPath = path;
+    fRunID = runID;
+    fPending.clear();
+    fPendingOffset = 0;
+    fPendingRecords = 0;
+    fSent = 0;
+    fDiscarded = 0;
+    {
+        std::lock_guard<std::mutex> lock(fBuffersMutex);
+        for (const auto& buffer : fBuffers) buffer->dropped = 0;
+    }
+
+    fLastAttempt = std::chrono::steady_clock::now();
+    Connect();
+    if (fDescriptor < 0) G4cout << "No consumer on " << fPath << " yet, records are dropped until one connects" << G4endl;
+
+    fStop = false;
+    fThread = std::thread(&ReadoutSimStreamSender::Loop, this);
+}
+
+void ReadoutSimStreamSender::Close()
+{
+    if (!fThread.joinable()) return;
+
+    // the workers are done: send what is left and stop
+    fStop = true;
+    fThread.join();
+
+    // whatever the consumer did not take in time; half a message cannot be
+    // followed by anything else
+    G4bool truncated = fPendingOffset > 0;
+    fDiscarded += fPendingRecords;
+    fPending.clear();
+    fPendingOffset = 0;
+    fPendingRecords = 0;
+    fDiscarded += Drain(false);
+    if (!truncated)
+    {
+        Queue(ReadoutSimStreamHeader::kEndOfRun, nullptr, 0);
+        Flush();
+    }
+    Disconnect();
+
+    G4cout << "Stream records sent: " << fSent << " to " << fPath;
+    long dropped = GetDropped();
+    if (dropped > 0) G4cout << " (" << dropped << " dropped)";
+    G4cout << G4endl;
+}
+
+void ReadoutSimStreamSender::Push(const ReadoutSimStreamRecord& record)
+{
+    // the sender is behind or nobody listens: drop, never wait
+    Buffer* buffer = GetBuffer();
+    if (!buffer->ring.Push(record)) buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+ReadoutSimStreamSender::Buffer* ReadoutSimStreamSender::GetBuffer()
+{
+    static G4ThreadLocal Buffer* buffer = nullptr;
+    if (!buffer)
+    {
+        std::lock_guard<std::mutex> lock(fBuffersMutex);
+        fBuffers.emplace_back(new Buffer());
+        buffer = fBuffers.back().get();
+    }
+    return buffer;
+}
+
+long ReadoutSimStreamSender::GetDropped() const
+{
+    // a worker may add its buffer meanwhile, which can move the vector
+    std::lock_guard<std::mutex> lock(fBuffersMutex);
+    long dropped = fDiscarded;
+    for (const auto& buffer : fBuffers) dropped += buffer->dropped.load(std::memory_order_relaxed);
+    return dropped;
+}
+
+void ReadoutSimStreamSender::Loop()
+{
+    std::chrono::steady_clock::time_point deadline;
+    G4bool stopping = false;
+    for (;;)
+    {
+        // read the flag first: records pushed before it was set are sent below
+        if (!stopping && fStop)
+        {
+            stopping = true;
+            deadline = std::chrono::steady_clock::now() + kCloseTimeout;
+        }
+
+        if (fDescriptor < 0 && std::chrono::steady_clock::now() - fLastAttempt > std::chrono::seconds(1)) Connect();
+
+        // a stalled consumer: keep the batch, leave the records in the rings
+        std::size_t n = Flush() ? Drain(true) : 0;
+        if (n == 0)
+        {
+            if (stopping && (fPending.empty() || std::chrono::steady_clock::now() > deadline)) break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+}
+
+std::size_t ReadoutSimStreamSender::Drain(G4bool send)
+{
+    std::vector<Buffer*> buffers;
+    {
+        std::lock_guard<std::mutex> lock(fBuffersMutex);
+        for (const auto& buffer : fBuffers) buffers.push_back(buffer.get());
+    }
+
+    static ReadoutSimStreamRecord records[kBatchSize];
+    std::size_t total = 0;
+    for (Buffer* buffer : buffers)
+    {
+        std::size_t n = buffer->ring.Pop(records, kBatchSize);
+        if (n == 0) continue;
+        if (!send || fDescriptor < 0) fDiscarded += n;
+        else
+        {
+            Queue(ReadoutSimStreamHeader::kRecords, records, n);
+            Flush();
+        }
+        total += n;
+        // one batch in flight at a time
+        if (!fPending.empty()) break;
+    }
+    return total;
+}
+
+void ReadoutSimStreamSender::Queue(ReadoutSimStreamHeader::Type type, const ReadoutSimStreamRecord* records, std::size_t n)
+{
+    ReadoutSimStreamHeader header;
+    header.magic = ReadoutSimStreamHeader::kMagic;
+    header.type = type;
+    header.runID = std::uint32_t(fRunID);
+    header.count = std::uint32_t(n);
+    header.dropped = std::uint64_t(GetDropped());
+
+    std::size_t size = sizeof(header) + n * sizeof(ReadoutSimStreamRecord);
+    fPending.resize(size);
+    std::memcpy(fPending.data(), &header, sizeof(header));
+    if (n > 0) std::memcpy(fPending.data() + sizeof(header), records, n * sizeof(ReadoutSimStreamRecord));
+    fPendingOffset = 0;
+    fPendingRecords = long(n);
+}
+
+G4bool ReadoutSimStreamSender::Flush()
+{
+    while (fDescriptor >= 0 && fPendingOffset < fPending.size())
+    {
+        const char* data = fPending.data() + fPendingOffset;
+        std::size_t size = fPending.size() - fPendingOffset;
+        ssize_t n = fIsSocket ? send(fDescriptor, data, size, MSG_NOSIGNAL | MSG_DONTWAIT)
+                              : write(fDescriptor, data, size);
+        if (n > 0)
+        {
+            fPendingOffset += std::size_t(n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return false;
+
+        // the consumer is gone, its batch with it
+        fDiscarded += fPendingRecords;
+        Disconnect();
+    }
+
+    fSent += fPendingOffset == fPending.size() ? fPendingRecords : 0;
+    fPending.clear();
+    fPendingOffset = 0;
+    fPendingRecords = 0;
+    return true;
+}
+
+void ReadoutSimStreamSender::Connect()
+{
+    fLastAttempt = std::chrono::steady_clock::now();
+
+    struct stat status;
+    if (stat(fPath.c_str(), &status) != 0) return;
+
+    if (S_ISFIFO(status.st_mode))
+    {
+        // fails as long as no reader has the pipe open
+        fDescriptor = open(fPath.c_str(), O_WRONLY | O_NONBLOCK);
+        fIsSocket = false;
+        return;
+    }
+
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (fPath.size() >= sizeof(address.sun_path)) return;
+    std::strncpy(address.sun_path, fPath.c_str(), sizeof(address.sun_path) - 1);
+
+    int descriptor = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (descriptor < 0) return;
+    if (connect(descriptor, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+    {
+        close(descriptor);
+        return;
+    }
+    fcntl(descriptor, F_SETFL, fcntl(descriptor, F_GETFL) | O_NONBLOCK);
+    fDescriptor = descriptor;
+    fIsSocket = true;
+}
+
+void ReadoutSimStreamSender::Disconnect()
+{
+    if (fDescriptor >= 0) close(fDescriptor);
+    fDescriptor = -1;
+}
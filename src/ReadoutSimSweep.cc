@@ -0,0 +1,210 @@
+#include "ReadoutSimSweep.hh"
+
+#include "G4UImanager.hh"
+#include "G4UIcommand.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <cstdlib>
+#include <sstream>
+
+namespace
+{
+    // one value per parameter, or nothing when the parameter is not scanned
+    template <typename T>
+    std::vector<T> OrKeep(const std::vector<T>& values)
+    {
+        return values.empty() ? std::vector<T>(1) : values;
+    }
+
+    G4bool IsNumber(const G4String& word)
+    {
+        char* end = nullptr;
+        std::strtod(word.c_str(), &end);
+        return end != word.c_str() && *end == '\0';
+    }
+}
+
+ReadoutSimSweep::ReadoutSimSweep()
+{
+    fAdaptive = false;
+
+    DefineCommands();
+}
+
+ReadoutSimSweep::~ReadoutSimSweep()
+{
+    delete fMessenger;
+}
+
+std::vector<G4String> ReadoutSimSweep::ParseWords(const G4String& list)
+{
+    std::vector<G4String> words;
+    std::istringstream stream(list);
+    std::string word;
+    while (stream >> word) words.push_back(word);
+    return words;
+}
+
+std::vector<G4double> ReadoutSimSweep::ParseValues(const G4String& list, const char* defaultUnit)
+{
+    std::vector<G4String> words = ParseWords(list);
+
+    // a trailing word that is not a number is the unit
+    G4double unit = defaultUnit ? G4UIcommand::ValueOf(defaultUnit) : 1.;
+    if (!words.empty() && !IsNumber(words.back()))
+    {
+        unit = G4UIcommand::ValueOf(words.back());
+        words.pop_back();
+    }
+
+    std::vector<G4double> values;
+    for (const G4String& word : words) values.push_back(G4UIcommand::ConvertToDouble(word) * unit);
+    return values;
+}
+
+void ReadoutSimSweep::SetSpace(G4String list)
+{
+    fSpace = ParseValues(list, "cm");
+}
+
+void ReadoutSimSweep::SetWrap(G4String list)
+{
+    fWrap = ParseValues(list, nullptr);
+}
+
+void ReadoutSimSweep::SetBack(G4String list)
+{
+    fBack = ParseValues(list, nullptr);
+}
+
+void ReadoutSimSweep::SetFoilThickness(G4String list)
+{
+    fFoilThickness = ParseValues(list, "um");
+}
+
+void ReadoutSimSweep::SetGeometry(G4String list)
+{
+    fGeometry = ParseWords(list);
+}
+
+void ReadoutSimSweep::Clear()
+{
+    fSpace.clear();
+    fWrap.clear();
+    fBack.clear();
+    fFoilThickness.clear();
+    fGeometry.clear();
+}
+
+void ReadoutSimSweep::Run(G4int nEvents)
+{
+    G4UImanager* UImanager = G4UImanager::GetUIpointer();
+
+    std::vector<G4String> geometries = OrKeep(fGeometry);
+    std::vector<G4double> spaces = OrKeep(fSpace);
+    std::vector<G4double> wraps = OrKeep(fWrap);
+    std::vector<G4double> backs = OrKeep(fBack);
+    std::vector<G4double> thicknesses = OrKeep(fFoilThickness);
+    G4int nPoints = G4int(geometries.size() * spaces.size() * wraps.size() * backs.size() * thicknesses.size());
+
+    // the geometry type is the outer loop: changing it rebuilds everything
+    G4int point = 0;
+    for (const G4String& geometry : geometries)
+    for (G4double space : spaces)
+    for (G4double wrap : wraps)
+    for (G4double back : backs)
+    for (G4double thickness : thicknesses)
+    {
+        std::ostringstream tag;
+        tag << "p" << point;
+
+        std::vector<G4String> commands;
+        std::ostringstream settings;
+        if (!fGeometry.empty())
+        {
+            commands.push_back("/readoutsim/geometryType " + geometry);
+            settings << " geometry " << geometry;
+        }
+        if (!fSpace.empty())
+        {
+            commands.push_back("/RS/guide/space " + G4UIcommand::ConvertToString(space / mm) + " mm");
+            settings << " space " << space / mm << " mm";
+        }
+        if (!fWrap.empty())
+        {
+            commands.push_back("/RS/guide/setWLSWrap " + G4UIcommand::ConvertToString(G4int(wrap)));
+            settings << " wrap " << G4int(wrap);
+        }
+        if (!fBack.empty())
+        {
+            commands.push_back("/RS/guide/setWLSBack " + G4UIcommand::ConvertToString(G4int(back)));
+            settings << " back " << G4int(back);
+        }
+        if (!fFoilThickness.empty())
+        {
+            commands.push_back("/RS/guide/setFoilThickness " + G4UIcommand::ConvertToString(thickness / um) + " um");
+            settings << " foil " << thickness / um << " um";
+        }
+        commands.push_back("/RS/run/tag " + tag.str());
+        commands.push_back((fAdaptive ? "/RS/adaptive/run " : "/run/beamOn ") + G4UIcommand::ConvertToString(nEvents));
+
+        G4cout << "\n===== Sweep point " << point + 1 << "/" << nPoints << " [" << tag.str() << "]:"
+               << settings.str() << " =====" << G4endl;
+
+        for (const G4String& command : commands)
+        {
+            if (UImanager->ApplyCommand(command) != 0)
+            {
+                G4cerr << "Sweep stopped, command failed: " << command << G4endl;
+                UImanager->ApplyCommand("/RS/run/tag");
+                return;
+            }
+        }
+        point++;
+    }
+
+    UImanager->ApplyCommand("/RS/run/tag");
+}
+
+void ReadoutSimSweep::DefineCommands()
+{
+    fMessenger = new G4GenericMessenger(this, "/RS/sweep/", "Commands for a design-space scan in one process");
+
+    fMessenger->DeclareMethod("space", &ReadoutSimSweep::SetSpace)
+    .SetGuidance("Values of /RS/guide/space to scan, with an optional unit at the end (default cm)")
+    .SetParameterName("values", false);
+
+    fMessenger->DeclareMethod("wrap", &ReadoutSimSweep::SetWrap)
+    .SetGuidance("Values of /RS/guide/setWLSWrap to scan, e.g. 0 1")
+    .SetParameterName("values", false);
+
+    fMessenger->DeclareMethod("back", &ReadoutSimSweep::SetBack)
+    .SetGuidance("Values of /RS/guide/setWLSBack to scan, e.g. 0 1")
+    .SetParameterName("values", false);
+
+    fMessenger->DeclareMethod("foilThickness", &ReadoutSimSweep::SetFoilThickness)
+    .SetGuidance("Values of /RS/guide/setFoilThickness to scan, with an optional unit at the end (default um)")
+    .SetParameterName("values", false);
+
+    fMessenger->DeclareMethod("geometry", &ReadoutSimSweep::SetGeometry)
+    .SetGuidance("Values of /readoutsim/geometryType to scan")
+    .SetParameterName("values", false);
+
+    fMessenger->DeclareProperty("adaptive", fAdaptive)
+    .SetGuidance("Run every point with /RS/adaptive/run: until the /RS/adaptive/ precision,")
+    .SetGuidance("with the number of events of /RS/sweep/run as the limit")
+    .SetParameterName("adaptive", false)
+    .SetDefaultValue("1")
+    .SetToBeBroadcasted(false);
+
+    fMessenger->DeclareMethod("clear", &ReadoutSimSweep::Clear)
+    .SetGuidance("Forget all the scanned values");
+
+    fMessenger->DeclareMethod("run", &ReadoutSimSweep::Run)
+    .SetGuidance("Run the given number of events for every point of the grid")
+    .SetGuidance("Parameters without values keep their current setting")
+    .SetGuidance("With /RS/sweep/adaptive, the largest number of events of a point")
+    .SetParameterName("nEvents", false)
+    .SetRange("nEvents>0")
+    .SetToBeBroadcasted(false);
+}
@@ -1,50 +1,175 @@
 #include "ReadoutSimTrackingAction.hh"
+#include "ReadoutSimRunAction.hh"
+#include "ReadoutSimVolumeRegistry.hh"
+#include "ReadoutSimTrackInformation.hh"
+#include "ReadoutSimPhotonRecord.hh"
+#include "ReadoutSimOutputWriter.hh"
+#include "ReadoutSimStreamSender.hh"
+#include "ReadoutSimOpWLS.hh"
+#include "Run.hh"
 
 #include "G4TrackingManager.hh"
+#include "G4EventManager.hh"
+#include "G4Event.hh"
 #include "G4Track.hh"
+#include "G4Step.hh"
+#include "G4VProcess.hh"
+#include "G4OpProcessSubType.hh"
 #include "G4SystemOfUnits.hh"
 
-#include "g4root.hh"
+#include <cstdint>
+
+namespace
+{
+    // 1 in n of the tracks, the same ones for any thread scheduling, and
+    // without a draw from the random engine of the physics
+    G4bool IsPrescaled(G4int eventID, G4int trackID, G4int n)
+    {
+        // splitmix64 finalizer of the event and track numbers
+        std::uint64_t key = (std::uint64_t(std::uint32_t(eventID)) << 32) | std::uint32_t(trackID);
+        key += 0x9e3779b97f4a7c15ULL;
+        key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        key = (key ^ (key >> 27)) * 0x94d049bb133111ebULL;
+        key ^= key >> 31;
+        return key % std::uint64_t(n) == 0;
+    }
+}
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
-ReadoutSimTrackingAction::ReadoutSimTrackingAction()
+ReadoutSimTrackingAction::ReadoutSimTrackingAction(const ReadoutSimRunAction* runAction)
 :G4UserTrackingAction()
 {
+    fRunAction = runAction;
+    fInitialVolume = 0;
 }
 
 void ReadoutSimTrackingAction::PreUserTrackingAction(const G4Track* aTrack)
 {
-    G4AnalysisManager* analysisMan = G4AnalysisManager::Instance();
-
     track_length_g4 = 0.;
 
-    // const G4Step* step = aTrack->GetStep();
-    G4String volume_name = aTrack->GetVolume()->GetName();
-
-    analysisMan->FillNtupleDColumn(0, aTrack->GetVertexPosition().getX() / cm);
-    analysisMan->FillNtupleDColumn(1, aTrack->GetVertexPosition().getY() / cm);
-    analysisMan->FillNtupleDColumn(2, aTrack->GetVertexPosition().getZ() / cm);
-    analysisMan->FillNtupleDColumn(3, aTrack->GetMomentumDirection().getX() / cm);
-    analysisMan->FillNtupleDColumn(4, aTrack->GetMomentumDirection().getY() / cm);
-    analysisMan->FillNtupleDColumn(5, aTrack->GetMomentumDirection().getZ() / cm);
-    analysisMan->FillNtupleSColumn(6, volume_name);
-    // analysisMan->AddNtupleRow(0);
+    // primaries start the ancestry, secondaries got it from their parent
+    if (aTrack->GetParentID() == 0 && !aTrack->GetUserInformation())
+    {
+        const G4ThreeVector& source = aTrack->GetVertexPosition();
+        fpTrackingManager->SetUserTrackInformation(new ReadoutSimTrackInformation(aTrack->GetTrackID(), source));
+    }
+
+    fInitialVolume = ReadoutSimVolumeRegistry::Instance()->GetID(aTrack->GetVolume());
+
+    // the first step is timed from here
+    ReadoutSimStepProfiler* profiler = fRunAction->GetRun()->GetStepProfiler();
+    if (profiler) profiler->StartTrack(aTrack->GetTrackID());
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 void ReadoutSimTrackingAction::PostUserTrackingAction(const G4Track* aTrack)
 {
-    G4AnalysisManager* analysisMan = G4AnalysisManager::Instance();
+    ReadoutSimStepProfiler* profiler = fRunAction->GetRun()->GetStepProfiler();
+    if (profiler) profiler->EndTrack();
+
+    const ReadoutSimTrackInformation* info = static_cast<const ReadoutSimTrackInformation*>(aTrack->GetUserInformation());
+    ReadoutSimVolumeRegistry::VolumeID volume = ReadoutSimVolumeRegistry::Instance()->GetID(aTrack->GetVolume());
+    G4int fate = ClassifyFate(aTrack, volume);
+    G4bool detected = (fate == ReadoutSimPhotonRecord::kDetectedRight || fate == ReadoutSimPhotonRecord::kDetectedLeft);
+
+    // pass the ancestry on to the re-emitted photons, with the path and the
+    // conversions behind them for the reweighting
+    // (split copies already carry theirs and are not re-emitted photons)
+    G4TrackVector* secondaries = fpTrackingManager->GimmeSecondaries();
+    if (info && secondaries)
+    {
+        G4int emitted = 0;
+        for (G4Track* secondary : *secondaries)
+            if (!secondary->GetUserInformation()) emitted++;
+        for (G4Track* secondary : *secondaries)
+        {
+            if (secondary->GetUserInformation()) continue;
+            ReadoutSimTrackInformation* secondaryInfo = new ReadoutSimTrackInformation(info->GetPrimaryID(), info->GetSource());
+            if (fate == ReadoutSimPhotonRecord::kWLSAbsorbed)
+            {
+                const ReadoutSimOpWLS* wls = dynamic_cast<const ReadoutSimOpWLS*>(secondary->GetCreatorProcess());
+                secondaryInfo->InheritConversion(*info, emitted, wls && wls->IsWeightedEmission());
+            }
+            secondary->SetUserInformation(secondaryInfo);
+        }
+    }
+
+    // importance sampling, roulette, splitting and weighted WLS emission
+    G4double weight = aTrack->GetWeight();
 
-    G4String volume_name = aTrack->GetVolume()->GetName();
-    analysisMan->FillNtupleSColumn(7, volume_name);
-    analysisMan->FillNtupleDColumn(8, aTrack->GetPosition().getX() / cm);
-    analysisMan->FillNtupleDColumn(9, aTrack->GetPosition().getY() / cm);
-    analysisMan->FillNtupleDColumn(10, aTrack->GetPosition().getZ() / cm);
-    analysisMan->FillNtupleDColumn(11, aTrack->GetKineticEnergy() / eV);
+    Run* run = fRunAction->GetRun();
+    run->CountTrack(fate, volume, info ? info->GetVolumeBeforeWorld() : 0, weight);
+    run->AddSteps(aTrack->GetCurrentStepNumber());
+    if (detected && info)
+    {
+        run->AddChannelDetection(info->GetChannel(), fate == ReadoutSimPhotonRecord::kDetectedRight, weight);
+        run->FillDetection(fate, info->GetSource().x(), info->GetSource().z(), aTrack->GetKineticEnergy(), weight);
+        if (run->GetReweighting()) run->GetReweighting()->Fill(*info, weight);
+    }
+
+    // every track, whatever the ntuple settings
+    if (fRunAction->IsStreaming())
+    {
+        ReadoutSimStreamRecord streamRecord;
+        streamRecord.fate = std::uint8_t(fate);
+        streamRecord.flags = aTrack->GetParentID() == 0 ? ReadoutSimStreamRecord::kPrimary : 0;
+        streamRecord.channel = (detected && info && info->GetChannel() >= 0) ? std::uint16_t(info->GetChannel()) : ReadoutSimStreamRecord::kNoChannel;
+        streamRecord.sourceX = info ? info->GetSource().x() / cm : 0.;
+        streamRecord.sourceZ = info ? info->GetSource().z() / cm : 0.;
+        streamRecord.energy = aTrack->GetKineticEnergy() / eV;
+        streamRecord.weight = weight;
+        ReadoutSimStreamSender::Instance()->Push(streamRecord);
+    }
+
+    if (!fRunAction->GetWriteRecords()) return;
+
+    // every detected photon, 1 in N of the others
+    G4int prescale = 1;
+    if (!detected)
+    {
+        prescale = fRunAction->GetPrescale();
+        G4int eventID = G4EventManager::GetEventManager()->GetConstCurrentEvent()->GetEventID();
+        if (prescale > 1 && !IsPrescaled(eventID, aTrack->GetTrackID(), prescale)) return;
+    }
+
+    const G4ThreeVector& vertex = aTrack->GetVertexPosition();
+    const G4ThreeVector& position = aTrack->GetPosition();
+    const G4ThreeVector& direction = aTrack->GetVertexMomentumDirection();
+
+    ReadoutSimPhotonRecord record;
+    record.initialVolume = fInitialVolume;
+    record.finalVolume = volume;
+    record.fate = fate;
+    record.vertex[0] = vertex.x() / cm;
+    record.vertex[1] = vertex.y() / cm;
+    record.vertex[2] = vertex.z() / cm;
+    record.position[0] = position.x() / cm;
+    record.position[1] = position.y() / cm;
+    record.position[2] = position.z() / cm;
+    record.energy = aTrack->GetKineticEnergy() / eV;
+    record.weight = prescale * weight;
+    record.direction = ReadoutSimPhotonRecord::EncodeDirection(direction.x(), direction.y(), direction.z());
+    if (fRunAction->UseAsyncOutput()) ReadoutSimOutputWriter::Instance()->Push(record);
+    else record.AddRow(fRunAction->GetWriteDirection());
 
     // track_length_g4 = aTrack->GetTrackLength() / cm;
+}
+
+G4int ReadoutSimTrackingAction::ClassifyFate(const G4Track* aTrack, G4int finalVolume) const
+{
+    const ReadoutSimTrackInformation* info = static_cast<const ReadoutSimTrackInformation*>(aTrack->GetUserInformation());
+    if (info && info->GetDetector() == ReadoutSimVolumeRegistry::kRightDetector) return ReadoutSimPhotonRecord::kDetectedRight;
+    if (info && info->GetDetector() == ReadoutSimVolumeRegistry::kLeftDetector) return ReadoutSimPhotonRecord::kDetectedLeft;
+    if (finalVolume == ReadoutSimVolumeRegistry::kOutOfWorld) return ReadoutSimPhotonRecord::kEscaped;
 
-    // analysisMan->FillNtupleDColumn(9, track_length_g4);
-    analysisMan->AddNtupleRow(0);
+    const G4VProcess* process = aTrack->GetStep()->GetPostStepPoint()->GetProcessDefinedStep();
+    if (process && process->GetProcessType() == fOptical)
+    {
+        if (process->GetProcessSubType() == fOpAbsorption) return ReadoutSimPhotonRecord::kAbsorbed;
+        if (process->GetProcessSubType() == fOpWLS) return ReadoutSimPhotonRecord::kWLSAbsorbed;
+    }
+    // the guide model (-g) only kills photons absorbed in the guide bulk
+    if (process && process->GetProcessType() == fParameterisation && finalVolume == ReadoutSimVolumeRegistry::kGuide)
+        return ReadoutSimPhotonRecord::kAbsorbed;
+    return ReadoutSimPhotonRecord::kKilled;
 }
@@ -0,0 +1,138 @@
+#include "ReadoutSimVertexLibrary.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <new>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// the cursor is shared with forked processes, which only works without a lock
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "the vertex library needs lock-free 64-bit atomics");
+
+ReadoutSimVertexLibrary* ReadoutSimVertexLibrary::Instance()
+{
+    static ReadoutSimVertexLibrary instance;
+    return &instance;
+}
+
+ReadoutSimVertexLibrary::ReadoutSimVertexLibrary()
+{
+    fMapping = nullptr;
+    fMappingSize = 0;
+    fRecords = nullptr;
+    fCount = 0;
+    fChunkSize = 1024;
+    fLoop = false;
+    fShared = nullptr;
+    fProcessGeneration = 0;
+}
+
+ReadoutSimVertexLibrary::~ReadoutSimVertexLibrary()
+{
+    Close();
+    if (fShared) munmap(fShared, sizeof(Shared));
+}
+
+G4bool ReadoutSimVertexLibrary::Open(const G4String& fileName)
+{
+    Close();
+
+    if (!fShared)
+    {
+        void* shared = mmap(nullptr, sizeof(Shared), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (shared == MAP_FAILED)
+        {
+            G4cerr << "Cannot allocate the cursor of the vertex library: " << std::strerror(errno) << G4endl;
+            return false;
+        }
+        fShared = new (shared) Shared();
+        fShared->cursor = 0;
+        fShared->generation = 0;
+    }
+
+    int fd = open(fileName.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        G4cerr << "Cannot open the vertex library " << fileName << ": " << std::strerror(errno) << G4endl;
+        return false;
+    }
+    struct stat status;
+    if (fstat(fd, &status) != 0 || std::size_t(status.st_size) < sizeof(ReadoutSimVertexHeader))
+    {
+        G4cerr << fileName << " is not a vertex library: too short" << G4endl;
+        close(fd);
+        return false;
+    }
+
+    // the mapping stays valid once the descriptor is closed
+    std::size_t size = status.st_size;
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        G4cerr << "Cannot map the vertex library " << fileName << ": " << std::strerror(errno) << G4endl;
+        return false;
+    }
+
+    const ReadoutSimVertexHeader* header = static_cast<const ReadoutSimVertexHeader*>(mapping);
+    if (header->magic != ReadoutSimVertexHeader::kMagic || header->recordSize != sizeof(ReadoutSimVertexRecord)
+        || header->count != (size - sizeof(ReadoutSimVertexHeader)) / sizeof(ReadoutSimVertexRecord)
+        || (size - sizeof(ReadoutSimVertexHeader)) % sizeof(ReadoutSimVertexRecord) != 0)
+    {
+        G4cerr << fileName << " is not a vertex library: wrong header or size" << G4endl;
+        munmap(mapping, size);
+        return false;
+    }
+
+    // the chunks are read front to back: let the kernel read ahead
+    madvise(mapping, size, MADV_SEQUENTIAL);
+
+    fFileName = fileName;
+    fMapping = mapping;
+    fMappingSize = size;
+    fRecords = reinterpret_cast<const ReadoutSimVertexRecord*>(static_cast<const char*>(mapping) + sizeof(ReadoutSimVertexHeader));
+    fCount = header->count;
+    Rewind();
+
+    G4cout << "Vertex library " << fileName << ": " << fCount << " vertices, "
+           << G4double(size) / (1024. * 1024.) << " MB mapped" << G4endl;
+    return true;
+}
+
+void ReadoutSimVertexLibrary::Close()
+{
+    if (!fMapping) return;
+    munmap(fMapping, fMappingSize);
+    fMapping = nullptr;
+    fMappingSize = 0;
+    fRecords = nullptr;
+    fCount = 0;
+    fFileName = "";
+    if (fShared) fShared->generation++;
+}
+
+void ReadoutSimVertexLibrary::Rewind()
+{
+    if (!fShared) return;
+    fShared->cursor = 0;
+    fShared->generation++;
+}
+
+G4bool ReadoutSimVertexLibrary::Claim(std::uint64_t& begin, std::uint64_t& end, std::uint64_t& generation)
+{
+    if (!IsOpen() || fCount == 0) return false;
+
+    // the cursor counts vertices, so the chunk size may change between runs
+    generation = fProcessGeneration + fShared->generation.load(std::memory_order_acquire);
+    begin = fShared->cursor.fetch_add(fChunkSize, std::memory_order_relaxed);
+    if (begin >= fCount)
+    {
+        if (!fLoop) return false;
+        begin %= fCount;
+    }
+    end = std::min(begin + fChunkSize, fCount);
+    return true;
+}
@@ -0,0 +1,93 @@
+#include "ReadoutSimVolumeRegistry.hh"
+
+#include "G4VPhysicalVolume.hh"
+#include "G4LogicalVolume.hh"
+#include "G4VSolid.hh"
+#include "G4AffineTransform.hh"
+#include "G4SystemOfUnits.hh"
+
+ReadoutSimVolumeRegistry* ReadoutSimVolumeRegistry::Instance()
+{
+    static ReadoutSimVolumeRegistry instance;
+    return &instance;
+}
+
+void ReadoutSimVolumeRegistry::Clear()
+{
+    fPhysicalVolumes.clear();
+    fPhysicalIDs.clear();
+    fLogicalVolumes.clear();
+    fLogicalIDs.clear();
+    fModule = ReadoutSimModuleLayout();
+    fHasEnvelope = false;
+}
+
+void ReadoutSimVolumeRegistry::ComputeEnvelope(const G4LogicalVolume* world)
+{
+    fHasEnvelope = false;
+    for (G4int axis = 0; axis < 3; axis++)
+    {
+        fEnvelopeMin[axis] = DBL_MAX;
+        fEnvelopeMax[axis] = -DBL_MAX;
+    }
+
+    for (std::size_t i = 0; i < world->GetNoDaughters(); i++)
+    {
+        const G4VPhysicalVolume* daughter = world->GetDaughter(i);
+        // no placement of its own: keep every photon
+        if (daughter->IsReplicated()) return;
+
+        G4ThreeVector min, max;
+        daughter->GetLogicalVolume()->GetSolid()->BoundingLimits(min, max);
+        G4AffineTransform transform(daughter->GetRotation(), daughter->GetTranslation());
+        for (G4int corner = 0; corner < 8; corner++)
+        {
+            G4ThreeVector point((corner & 1) ? max.x() : min.x(),
+                                (corner & 2) ? max.y() : min.y(),
+                                (corner & 4) ? max.z() : min.z());
+            point = transform.TransformPoint(point);
+            for (G4int axis = 0; axis < 3; axis++)
+            {
+                fEnvelopeMin[axis] = std::min(fEnvelopeMin[axis], point[axis]);
+                fEnvelopeMax[axis] = std::max(fEnvelopeMax[axis], point[axis]);
+            }
+        }
+    }
+
+    // a little margin for photons leaving a surface of the envelope
+    for (G4int axis = 0; axis < 3; axis++)
+    {
+        fEnvelopeMin[axis] -= 1.*um;
+        fEnvelopeMax[axis] += 1.*um;
+    }
+    fHasEnvelope = world->GetNoDaughters() > 0;
+}
+
+void ReadoutSimVolumeRegistry::Register(const G4VPhysicalVolume* volume, VolumeID id)
+{
+    fPhysicalVolumes.push_back(volume);
+    fPhysicalIDs.push_back(id);
+
+    const G4LogicalVolume* logical = volume->GetLogicalVolume();
+    if (GetID(logical) == kUnknownVolume)
+    {
+        fLogicalVolumes.push_back(logical);
+        fLogicalIDs.push_back(id);
+    }
+}
+
+const G4String& ReadoutSimVolumeRegistry::GetName(VolumeID id)
+{
+    // names of the placements, as written to the output so far
+    static const G4String names[kNumberOfVolumes] = {
+        "Unknown",
+        "OutOfWorld",
+        "World_phys",
+        "Panel_phys",
+        "PEN_phys",
+        "Guide_phys",
+        "RightDetector_phys",
+        "LeftDetector_phys"
+    };
+    return names[id];
+}
@@ -0,0 +1,23 @@
+#include "ReadoutSimWLSPhysics.hh"
+#include "ReadoutSimOpWLS.hh"
+
+#include "G4OpticalPhoton.hh"
+#include "G4ProcessManager.hh"
+
+ReadoutSimWLSPhysics::ReadoutSimWLSPhysics(const G4String& name)
+: G4VPhysicsConstructor(name)
+{}
+
+ReadoutSimWLSPhysics::~ReadoutSimWLSPhysics()
+{}
+
+void ReadoutSimWLSPhysics::ConstructParticle()
+{
+    G4OpticalPhoton::OpticalPhotonDefinition();
+}
+
+void ReadoutSimWLSPhysics::ConstructProcess()
+{
+    G4ProcessManager* processManager = G4OpticalPhoton::OpticalPhotonDefinition()->GetProcessManager();
+    processManager->AddDiscreteProcess(new ReadoutSimOpWLS());
+}
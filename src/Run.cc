@@ -1,6 +1,30 @@
 #include "Run.hh"
+#include "ReadoutSimSource.hh"
+#include "ReadoutSimPhotonRecord.hh"
+#include "ReadoutSimVolumeRegistry.hh"
+#include "ReadoutSimMemory.hh"
 
-Run::Run() : G4Run()
+#include "G4Event.hh"
+#include "G4SystemOfUnits.hh"
+
+#include "TFile.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+    const G4double kSourceX = ReadoutSimSource::xHalfWidth / cm;
+    const G4double kSourceZ = ReadoutSimSource::zHalfWidth / cm;
+}
+
+Run::Run(G4double sourceZHalfWidth) : G4Run(),
+  fSourceXZ("sourceXZ", "Primary photons;source x [cm];source z [cm]", 100, -kSourceX, kSourceX, 20, -kSourceZ, kSourceZ),
+  fDetectedXZ("detectedXZ", "Detected photons;source x [cm];source z [cm]", 100, -kSourceX, kSourceX, 20, -kSourceZ, kSourceZ),
+  fDetectedRightX("detectedRightX", "Detected right;source x [cm]", 100, -kSourceX, kSourceX),
+  fDetectedLeftX("detectedLeftX", "Detected left;source x [cm]", 100, -kSourceX, kSourceX),
+  fArrivalEnergy("arrivalEnergy", "Detected photons;energy [eV]", 160, 2., 10.)
 {
   fTotal = 0;
   fDetection = 0;
@@ -10,50 +34,361 @@ Run::Run() : G4Run()
   fLArAbsorption = 0;
   fOuterCladdingAbsorption = 0;
   fInnerCladdingAbsorption = 0;
+  fRightDetection = 0;
+  fLeftDetection = 0;
+  fWLSAbsorption = 0;
+  fEscaped = 0;
+  fKilled = 0;
+  fTracks = 0;
+  fTrackWeights = 0.;
+  fDetectionSquares = 0.;
 
   fPanelTowardLAr = 0;
   fPENTowardLAr = 0;
   fLightGuideTowardLAr = 0;
+
+  for (G4int i = 0; i < kNumberOfKillReasons; i++) fKills[i] = 0;
+  fRoulettes = 0;
+  fRouletteKills = 0;
+  fSplitCopies = 0;
+  fSteps = 0;
+  fSourceZHalfWidth = sourceZHalfWidth;
+
+  // source over the whole panel, or over all bars and panels of the
+  // module: wider histograms with the same bin sizes, up to 1000 bins
+  const ReadoutSimModuleLayout& module = ReadoutSimVolumeRegistry::Instance()->GetModuleLayout();
+  fChannelDetections.assign(2 * module.GetNumberOfChannels(), 0.);
+  G4double x = kSourceX;
+  G4double z = std::max(kSourceZ, sourceZHalfWidth / cm);
+  if (!module.IsBaseline())
+  {
+    x = std::max(x, 0.5 * module.nPanels * module.panelPitch / cm);
+    z = std::max(z, 0.5 * module.nBars * module.barPitch / cm);
+  }
+  if (x != kSourceX || z != kSourceZ)
+  {
+    G4int nx = std::min(1000, G4int(std::ceil(2. * x)));
+    G4int nz = std::min(1000, G4int(std::ceil(4. * z)));
+    fSourceXZ = ReadoutSimHistogram("sourceXZ", "Primary photons;source x [cm];source z [cm]", nx, -x, x, nz, -z, z);
+    fDetectedXZ = ReadoutSimHistogram("detectedXZ", "Detected photons;source x [cm];source z [cm]", nx, -x, x, nz, -z, z);
+    fDetectedRightX = ReadoutSimHistogram("detectedRightX", "Detected right;source x [cm]", nx, -x, x);
+    fDetectedLeftX = ReadoutSimHistogram("detectedLeftX", "Detected left;source x [cm]", nx, -x, x);
+  }
+
+  fLightMap = nullptr;
+  fLightMapLookup = false;
+  fReweighting = nullptr;
+  fStepProfiler = nullptr;
+  fImportanceSampler = nullptr;
+  for (G4int i = 0; i < 4; i++) fLookups[i] = 0;
+  fEmptyBinLookups = 0;
+
+  fStartTime = std::chrono::steady_clock::now();
+  fWorkerTime = 0.;
+  fNumberOfWorkers = 0;
 }
 Run::~Run()
-{}
+{
+  delete fLightMap;
+  delete fReweighting;
+  delete fStepProfiler;
+  delete fImportanceSampler;
+}
+
+void Run::RecordEvent(const G4Event* event)
+{
+  // every primary vertex carries one optical photon
+  fTotal += event->GetNumberOfPrimaryVertex();
+
+  G4Run::RecordEvent(event);
+}
 
 void Run::Merge(const G4Run* run)
 {
   const Run* localRun = static_cast<const Run*>(run);
 
-  // pass information about primary particle
-  fTotal = localRun->fTotal;
-  fDetection = localRun->fDetection;
-  fPenAbsorption = localRun->fPenAbsorption;
-  fLightGuideAbsorption = localRun->fLightGuideAbsorption;
-  fPanelAbsorption = localRun->fPanelAbsorption;
-  fLArAbsorption = localRun->fLArAbsorption;
-  fOuterCladdingAbsorption = localRun->fOuterCladdingAbsorption;
-  fInnerCladdingAbsorption = localRun->fInnerCladdingAbsorption;
-
-  fPanelTowardLAr = localRun->fPanelTowardLAr;
-  fPENTowardLAr = localRun->fPENTowardLAr;
-  fLightGuideTowardLAr = localRun->fLightGuideTowardLAr;
+  // sum the counters of all worker threads
+  Add(*localRun);
+
+  if (IsFillingLightMap() && localRun->IsFillingLightMap()) fLightMap->Add(*localRun->fLightMap);
+  for (G4int i = 0; i < 4; i++) fLookups[i] += localRun->fLookups[i];
+  fEmptyBinLookups += localRun->fEmptyBinLookups;
+  if (fReweighting && localRun->fReweighting) fReweighting->Add(*localRun->fReweighting);
+  if (fStepProfiler && localRun->fStepProfiler) fStepProfiler->Add(*localRun->fStepProfiler);
+
+  // a worker run is merged as soon as its event loop is over
+  std::chrono::duration<G4double> busy = std::chrono::steady_clock::now() - localRun->fStartTime;
+  fWorkerTime += busy.count();
+  fNumberOfWorkers += 1;
   
   G4Run::Merge(run);
 }
 
-void Run::EndOfRun()
+void Run::Add(const Run& other)
+{
+  fTotal += other.fTotal;
+  fDetection += other.fDetection;
+  fPenAbsorption += other.fPenAbsorption;
+  fLightGuideAbsorption += other.fLightGuideAbsorption;
+  fPanelAbsorption += other.fPanelAbsorption;
+  fLArAbsorption += other.fLArAbsorption;
+  fOuterCladdingAbsorption += other.fOuterCladdingAbsorption;
+  fInnerCladdingAbsorption += other.fInnerCladdingAbsorption;
+  fRightDetection += other.fRightDetection;
+  fLeftDetection += other.fLeftDetection;
+  fWLSAbsorption += other.fWLSAbsorption;
+  fEscaped += other.fEscaped;
+  fKilled += other.fKilled;
+  fTracks += other.fTracks;
+  fTrackWeights += other.fTrackWeights;
+  fDetectionSquares += other.fDetectionSquares;
+
+  fPanelTowardLAr += other.fPanelTowardLAr;
+  fPENTowardLAr += other.fPENTowardLAr;
+  fLightGuideTowardLAr += other.fLightGuideTowardLAr;
+  for (G4int i = 0; i < kNumberOfKillReasons; i++) fKills[i] += other.fKills[i];
+  fRoulettes += other.fRoulettes;
+  fRouletteKills += other.fRouletteKills;
+  fSplitCopies += other.fSplitCopies;
+  fSteps += other.fSteps;
+  for (std::size_t i = 0; i < fChannelDetections.size() && i < other.fChannelDetections.size(); i++)
+    fChannelDetections[i] += other.fChannelDetections[i];
+
+  fSourceXZ.Add(other.fSourceXZ);
+  fDetectedXZ.Add(other.fDetectedXZ);
+  fDetectedRightX.Add(other.fDetectedRightX);
+  fDetectedLeftX.Add(other.fDetectedLeftX);
+  fArrivalEnergy.Add(other.fArrivalEnergy);
+}
+
+void Run::CountTrack(G4int fate, G4int finalVolume, G4int volumeBeforeWorld, G4double weight)
+{
+  fTracks += 1;
+  fTrackWeights += weight;
+
+  switch (fate)
+  {
+    case ReadoutSimPhotonRecord::kDetectedRight:
+      fDetection += weight;
+      fRightDetection += weight;
+      fDetectionSquares += weight * weight;
+      break;
+    case ReadoutSimPhotonRecord::kDetectedLeft:
+      fDetection += weight;
+      fLeftDetection += weight;
+      fDetectionSquares += weight * weight;
+      break;
+    case ReadoutSimPhotonRecord::kWLSAbsorbed:
+      fWLSAbsorption += weight;
+      break;
+    case ReadoutSimPhotonRecord::kEscaped:
+      fEscaped += weight;
+      break;
+    case ReadoutSimPhotonRecord::kAbsorbed:
+      if (finalVolume == ReadoutSimVolumeRegistry::kPanel) fPanelAbsorption += weight;
+      else if (finalVolume == ReadoutSimVolumeRegistry::kGuide) fLightGuideAbsorption += weight;
+      else if (finalVolume == ReadoutSimVolumeRegistry::kPENFoil) fPenAbsorption += weight;
+      else if (finalVolume == ReadoutSimVolumeRegistry::kWorld)
+      {
+        fLArAbsorption += weight;
+        if (volumeBeforeWorld == ReadoutSimVolumeRegistry::kPanel) fPanelTowardLAr += weight;
+        else if (volumeBeforeWorld == ReadoutSimVolumeRegistry::kPENFoil) fPENTowardLAr += weight;
+        else if (volumeBeforeWorld == ReadoutSimVolumeRegistry::kGuide) fLightGuideTowardLAr += weight;
+      }
+      else fKilled += weight;
+      break;
+    default:
+      fKilled += weight;
+  }
+}
+
+void Run::AddChannelDetection(G4int channel, G4bool right, G4double weight)
+{
+  std::size_t i = 2 * std::size_t(channel) + (right ? 0 : 1);
+  if (channel >= 0 && i < fChannelDetections.size()) fChannelDetections[i] += weight;
+}
+
+void Run::FillSource(G4double x, G4double z, G4double weight)
+{
+  fSourceXZ.FillWeighted(x / cm, z / cm, weight);
+}
+
+void Run::FillDetection(G4int fate, G4double sourceX, G4double sourceZ, G4double energy, G4double weight)
+{
+  fDetectedXZ.FillWeighted(sourceX / cm, sourceZ / cm, weight);
+  if (fate == ReadoutSimPhotonRecord::kDetectedRight) fDetectedRightX.FillWeighted(sourceX / cm, weight);
+  else fDetectedLeftX.FillWeighted(sourceX / cm, weight);
+  fArrivalEnergy.FillWeighted(energy / eV, weight);
+}
+
+G4bool Run::WriteHistograms(const G4String& fileName) const
+{
+  TFile file(fileName, "RECREATE");
+  if (file.IsZombie()) return false;
+  fSourceXZ.Write();
+  fDetectedXZ.Write();
+  fDetectedRightX.Write();
+  fDetectedLeftX.Write();
+  fArrivalEnergy.Write();
+  file.Close();
+  return true;
+}
+
+void Run::Save(std::ostream& out) const
 {
-  G4cout << "\n   Summary\n";
+  out << "photons " << fTotal << " " << fTracks << "\ncounters";
+  for (G4double counter : {fDetection, fPanelAbsorption, fLightGuideAbsorption, fPenAbsorption,
+                           fLArAbsorption, fOuterCladdingAbsorption, fInnerCladdingAbsorption, fRightDetection,
+                           fLeftDetection, fWLSAbsorption, fEscaped, fKilled, fTrackWeights, fDetectionSquares,
+                           fPanelTowardLAr, fPENTowardLAr, fLightGuideTowardLAr})
+    out << " " << counter;
+  out << "\nkills";
+  for (G4int i = 0; i < kNumberOfKillReasons; i++) out << " " << fKills[i];
+  out << "\nbiasing " << fRoulettes << " " << fRouletteKills << " " << fSplitCopies;
+  out << "\nsteps " << fSteps << "\nchannels " << fChannelDetections.size();
+  for (G4double count : fChannelDetections) out << " " << count;
+  out << "\n";
+
+  fSourceXZ.Save(out);
+  fDetectedXZ.Save(out);
+  fDetectedRightX.Save(out);
+  fDetectedLeftX.Save(out);
+  fArrivalEnergy.Save(out);
+}
+
+G4bool Run::Load(std::istream& in)
+{
+  std::string word;
+  in >> word >> fTotal >> fTracks;
+  if (word != "photons") return false;
+  in >> word;
+  if (word != "counters") return false;
+  for (G4double* counter : {&fDetection, &fPanelAbsorption, &fLightGuideAbsorption, &fPenAbsorption,
+                            &fLArAbsorption, &fOuterCladdingAbsorption, &fInnerCladdingAbsorption, &fRightDetection,
+                            &fLeftDetection, &fWLSAbsorption, &fEscaped, &fKilled, &fTrackWeights, &fDetectionSquares,
+                            &fPanelTowardLAr, &fPENTowardLAr, &fLightGuideTowardLAr})
+    in >> *counter;
+
+  in >> word;
+  if (word != "kills") return false;
+  for (G4int i = 0; i < kNumberOfKillReasons; i++) in >> fKills[i];
+  in >> word >> fRoulettes >> fRouletteKills >> fSplitCopies;
+  if (word != "biasing") return false;
+  in >> word >> fSteps;
+  if (word != "steps") return false;
+
+  std::size_t nChannels = 0;
+  in >> word >> nChannels;
+  if (!in || word != "channels" || nChannels != fChannelDetections.size()) return false;
+  for (G4double& count : fChannelDetections) in >> count;
+  if (!in) return false;
+
+  return fSourceXZ.Load(in) && fDetectedXZ.Load(in) && fDetectedRightX.Load(in)
+      && fDetectedLeftX.Load(in) && fArrivalEnergy.Load(in);
+}
+
+void Run::EndOfRun(const G4String& tag)
+{
+  // nothing tracked, e.g. light map lookup
+  if (fTotal == 0) return;
+
+  G4cout << "\n   Summary";
+  if (!tag.empty()) G4cout << " [" << tag << "]";
+  G4cout << "\n";
   G4cout <<   "---------------------------------\n";
   G4cout << "  # of generated photons:          " << std::setw(8) << fTotal << G4endl;
+  G4cout << "  # of tracked photons (with WLS): " << std::setw(8) << fTracks << G4endl;
   G4cout << "  Photons Detected:                 " << std::setw(8) << double(fDetection)/double(fTotal)*100 << " %" << G4endl;
+  G4cout << "    right:                          " << std::setw(8) << double(fRightDetection)/double(fTotal)*100 << " %" << G4endl;
+  G4cout << "    left:                           " << std::setw(8) << double(fLeftDetection)/double(fTotal)*100 << " %" << G4endl;
+  G4cout << "  Photons Shifted in PEN:           " << std::setw(8) << double(fWLSAbsorption)/double(fTotal)*100 << " %" << G4endl;
   G4cout << "  Photons Absorbed in PEN:          " << std::setw(8) << double(fPenAbsorption)/double(fTotal)*100 << " %" << G4endl;
   G4cout << "  Photons Absorbed in PMMA guide:   " << std::setw(8) << double(fLightGuideAbsorption)/double(fTotal)*100 << " %" << G4endl;
   G4cout << "  Photons Absorbed in PMMA panel:   " << std::setw(8) << double(fPanelAbsorption)/double(fTotal)*100 << " %" << G4endl;
   G4cout << "  Photons Absorbed in LAr:          " << std::setw(8) << double(fLArAbsorption)/double(fTotal)*100 << " %" << G4endl;
   G4cout << "  Photons Absorbed in Outer Cladding: " << std::setw(8) << double(fOuterCladdingAbsorption)/double(fTotal)*100 << " %" << G4endl;
   G4cout << "  Photons Absorbed in Inner Cladding: " << std::setw(8) << double(fInnerCladdingAbsorption)/double(fTotal)*100 << " %" << G4endl; 
-  G4cout << "  TOTAL:          " << std::setw(8) << double(fDetection+fPenAbsorption+fLightGuideAbsorption+fPanelAbsorption+fLArAbsorption+fOuterCladdingAbsorption+fInnerCladdingAbsorption)/double(fTotal)*100 << " %" << G4endl;
+  G4cout << "  Photons Escaped from the World:   " << std::setw(8) << double(fEscaped)/double(fTotal)*100 << " %" << G4endl;
+  G4cout << "  Photons Killed otherwise:         " << std::setw(8) << double(fKilled)/double(fTotal)*100 << " %" << G4endl;
+  // WLS photons are tracked too, so the fates add up to the tracked photons
+  G4cout << "  TOTAL (of tracked photons):       " << std::setw(8) << double(fDetection+fWLSAbsorption+fPenAbsorption+fLightGuideAbsorption+fPanelAbsorption+fLArAbsorption+fOuterCladdingAbsorption+fInnerCladdingAbsorption+fEscaped+fKilled)/fTrackWeights*100 << " %" << G4endl;
   G4cout <<   "---------------------------------\n";
 
+  // weights other than 1: the detected photons count for fewer independent ones
+  if (fDetectionSquares != fDetection && fDetectionSquares > 0.)
+  {
+    G4cout << "\n   Weighted photons\n";
+    G4cout <<   "---------------------------------\n";
+    G4cout << "  Effective detected photons:      " << std::setw(8) << fDetection * fDetection / fDetectionSquares << G4endl;
+    G4cout << "  Relative error of detected:      " << std::setw(8) << std::sqrt(fDetectionSquares) / fDetection * 100 << " %" << G4endl;
+    if (fImportanceSampler)
+      G4cout << "  Photon weights:                  " << std::setw(8) << fImportanceSampler->GetMinWeight()
+             << " to " << fImportanceSampler->GetMaxWeight() << G4endl;
+    G4cout <<   "---------------------------------\n";
+  }
+
+  if (fRoulettes > 0 || fSplitCopies > 0)
+  {
+    G4cout << "\n   Russian roulette and splitting (/RS/roulette/, /RS/split/)\n";
+    G4cout <<   "---------------------------------\n";
+    G4cout << "  Roulettes played:                " << std::setw(8) << fRoulettes << G4endl;
+    G4cout << "  Photons killed by roulette:      " << std::setw(8) << fRouletteKills << G4endl;
+    G4cout << "  Copies made by splitting:        " << std::setw(8) << fSplitCopies << G4endl;
+    G4cout <<   "---------------------------------\n";
+  }
+
+  const ReadoutSimModuleLayout& module = ReadoutSimVolumeRegistry::Instance()->GetModuleLayout();
+  if (!module.IsBaseline() && fChannelDetections.size() == std::size_t(2 * module.GetNumberOfChannels()))
+  {
+    // summed over the panels, and over the bars of each panel
+    G4cout << "\n   Detected per bar (right, left, % of generated)\n";
+    G4cout <<   "---------------------------------\n";
+    for (G4int bar = 0; bar < module.nBars; bar++)
+    {
+      G4double right = 0., left = 0.;
+      for (G4int panel = 0; panel < module.nPanels; panel++)
+      {
+        right += fChannelDetections[2 * (panel * module.nBars + bar)];
+        left += fChannelDetections[2 * (panel * module.nBars + bar) + 1];
+      }
+      G4cout << "  Bar " << std::setw(4) << bar << ":                      " << std::setw(8) << std::llround(right) << " " << std::setw(8) << std::llround(left)
+             << "  " << double(right + left)/double(fTotal)*100 << " %" << G4endl;
+    }
+    if (module.nPanels > 1)
+    {
+      G4cout << "\n   Detected per panel (right, left, % of generated)\n";
+      G4cout <<   "---------------------------------\n";
+      for (G4int panel = 0; panel < module.nPanels; panel++)
+      {
+        G4double right = 0., left = 0.;
+        for (G4int bar = 0; bar < module.nBars; bar++)
+        {
+          right += fChannelDetections[2 * (panel * module.nBars + bar)];
+          left += fChannelDetections[2 * (panel * module.nBars + bar) + 1];
+        }
+        G4cout << "  Panel " << std::setw(4) << panel << ":                    " << std::setw(8) << std::llround(right) << " " << std::setw(8) << std::llround(left)
+               << "  " << double(right + left)/double(fTotal)*100 << " %" << G4endl;
+      }
+    }
+    G4cout <<   "---------------------------------\n";
+  }
+
+  if (fReweighting) fReweighting->Print(fTotal);
+
+  G4double kills = fKills[kKillEnterWorld] + fKills[kKillBelowEnergy] + fKills[kKillEscape];
+  if (kills > 0.)
+  {
+    // killed at creation are not tracked, and not in the fates above
+    G4cout << "\n   Photons killed early (/RS/kill/)\n";
+    G4cout <<   "---------------------------------\n";
+    G4cout << "  Going into LAr:                  " << std::setw(8) << std::llround(fKills[kKillEnterWorld]) << G4endl;
+    G4cout << "  Below the energy threshold:      " << std::setw(8) << std::llround(fKills[kKillBelowEnergy]) << G4endl;
+    G4cout << "  Pointing away from all volumes:  " << std::setw(8) << std::llround(fKills[kKillEscape]) << G4endl;
+    G4cout <<   "---------------------------------\n";
+  }
+
+  if (fLArAbsorption == 0.) return;
+
   G4cout << "\n   Where are photon before going into LAr?\n";
   G4cout <<   "---------------------------------\n";
   G4cout << "  Photons coming from Panel        " << std::setw(8) << double(fPanelTowardLAr)/double(fLArAbsorption) * 100 << " %" << G4endl;
@@ -62,3 +397,71 @@ void Run::EndOfRun()
   G4cout << "  TOTAL:          " << std::setw(8) << double(fPanelTowardLAr+fPENTowardLAr+fLightGuideTowardLAr)/double(fLArAbsorption)*100 << " %" << G4endl;
   G4cout << "\n";
 }
+
+void Run::SetLightMap(ReadoutSimLightMap* map, G4bool lookup)
+{
+  delete fLightMap;
+  fLightMap = map;
+  fLightMapLookup = lookup;
+}
+
+void Run::AddLookup(ReadoutSimLightMap::Outcome outcome, G4bool emptyBin)
+{
+  fLookups[outcome] += 1;
+  if (emptyBin) fEmptyBinLookups += 1;
+}
+
+void Run::PrintLookup(G4double wallTime) const
+{
+  G4long points = fLookups[0] + fLookups[1] + fLookups[2] + fLookups[3];
+  if (points == 0) return;
+  G4long right = fLookups[ReadoutSimLightMap::kRight] + fLookups[ReadoutSimLightMap::kBoth];
+  G4long left = fLookups[ReadoutSimLightMap::kLeft] + fLookups[ReadoutSimLightMap::kBoth];
+
+  G4cout << "\n   Light map lookup\n";
+  G4cout <<   "---------------------------------\n";
+  G4cout << "  # of source points:              " << std::setw(8) << points << G4endl;
+  G4cout << "  Detected right:                  " << std::setw(8) << right << "  (" << double(right)/double(points)*100 << " %)" << G4endl;
+  G4cout << "  Detected left:                   " << std::setw(8) << left << "  (" << double(left)/double(points)*100 << " %)" << G4endl;
+  G4cout << "  Detected on both sides:          " << std::setw(8) << fLookups[ReadoutSimLightMap::kBoth] << G4endl;
+  G4cout << "  In empty bins:                   " << std::setw(8) << fEmptyBinLookups << "  (" << double(fEmptyBinLookups)/double(points)*100 << " %)" << G4endl;
+  if (wallTime > 0.)
+    G4cout << "  Source points/s:                 " << std::setw(8) << double(points) / wallTime << G4endl;
+  G4cout <<   "---------------------------------\n";
+}
+
+void Run::PrintThroughput(G4double wallTime, G4double referenceRate) const
+{
+  // nothing tracked, e.g. light map lookup
+  if (fTotal == 0) return;
+
+  // sequential runs have no worker to merge
+  G4int nThreads = fNumberOfWorkers > 0 ? fNumberOfWorkers : 1;
+  G4double workerTime = fNumberOfWorkers > 0 ? fWorkerTime : wallTime;
+  if (wallTime <= 0. || workerTime <= 0.) return;
+
+  G4double rate = double(fTotal) / wallTime;
+  // without a measured single-thread rate, compare with the rate of the busy workers
+  G4double threadRate = double(fTotal) / workerTime;
+
+  G4cout << "\n   Throughput\n";
+  G4cout <<   "---------------------------------\n";
+  G4cout << "  Threads:                         " << std::setw(8) << nThreads << G4endl;
+  G4cout << "  Wall time:                       " << std::setw(8) << wallTime << " s" << G4endl;
+  G4cout << "  Photons/s:                       " << std::setw(8) << rate << G4endl;
+  G4cout << "  Photons/s per thread:            " << std::setw(8) << rate / nThreads << G4endl;
+  if (referenceRate > 0.)
+    G4cout << "  Scaling efficiency (vs 1 thread): " << std::setw(8) << rate / (nThreads * referenceRate) * 100 << " %" << G4endl;
+  else
+    G4cout << "  Scaling efficiency (estimated):  " << std::setw(8) << rate / (nThreads * threadRate) * 100 << " %" << G4endl;
+  if (fSteps > 0)
+  {
+    // busy thread time over all steps: transport, physics and navigation together
+    G4cout << "  Steps per tracked photon:        " << std::setw(8) << double(fSteps) / double(fTracks) << G4endl;
+    G4cout << "  Time per step:                   " << std::setw(8) << workerTime * s / double(fSteps) / ns << " ns" << G4endl;
+  }
+  G4double peakMemory = ReadoutSimMemory::GetPeakResident();
+  if (peakMemory > 0.)
+    G4cout << "  Peak memory:                     " << std::setw(8) << peakMemory << " MB" << G4endl;
+  G4cout <<   "---------------------------------\n";
+}